@@ -0,0 +1,92 @@
+-- Wireshark dissector for RadioManager captures written by RadioPcapWriter
+-- (link type DLT_USER0 = 147).
+--
+-- Install: copy to your Wireshark personal plugins folder, or run
+--   wireshark -X lua_script:radiomanager.lua capture.pcap
+
+local rm = Proto("radiomanager", "RadioManager nRF24 frame")
+
+local directions = { [0] = "RX", [1] = "TX" }
+local codes = { [0x4D] = "Start ('M')", [0x43] = "Continue ('C')",
+                [0x6D] = "Start with source id ('m')", [0x63] = "Continue with source id ('c')",
+                [0x52] = "Rate request ('R')", [0x72] = "Rate request with source id ('r')",
+                [0x4B] = "Channel change ('K')", [0x6B] = "Channel change with source id ('k')",
+                [0x48] = "Hop key ('H')", [0x68] = "Hop key with source id ('h')",
+                [0x53] = "Hop sync ('S')", [0x73] = "Hop sync with source id ('s')",
+                [0x42] = "TDMA beacon ('B')",
+                [0x54] = "Timestamps ('T')", [0x74] = "Timestamps with source id ('t')",
+                [0x51] = "Credit query ('Q')", [0x71] = "Credit query with source id ('q')",
+                [0x44] = "Stream record ('D')", [0x64] = "Stream record with source id ('d')" }
+
+local f = rm.fields
+f.version   = ProtoField.uint8("radiomanager.version", "Pseudo-header version")
+f.direction = ProtoField.uint8("radiomanager.direction", "Direction", base.DEC, directions)
+f.pipe      = ProtoField.uint8("radiomanager.pipe", "Pipe")
+f.retries   = ProtoField.uint8("radiomanager.retries", "Retries (ARC)")
+f.flags     = ProtoField.uint8("radiomanager.flags", "Flags", base.HEX)
+f.acked     = ProtoField.bool("radiomanager.flags.acked", "Acknowledged", 8, nil, 0x01)
+f.fifo_full = ProtoField.bool("radiomanager.flags.fifo_full", "RX FIFO full", 8, nil, 0x02)
+f.ack_payload = ProtoField.bool("radiomanager.flags.ack_payload", "Ack payload", 8, nil, 0x04)
+f.length    = ProtoField.uint8("radiomanager.length", "Frame length")
+f.code      = ProtoField.uint8("radiomanager.code", "Fragment code", base.HEX, codes)
+f.index     = ProtoField.uint16("radiomanager.index", "Fragments remaining (value of control frames)")
+f.source    = ProtoField.uint8("radiomanager.source", "Source id")
+f.payload   = ProtoField.bytes("radiomanager.payload", "Payload")
+
+function rm.dissector(buf, pinfo, tree)
+    if buf:len() < 8 then return 0 end
+    pinfo.cols.protocol = "RadioManager"
+
+    local direction = buf(1, 1):uint()
+    local pipe = buf(2, 1):uint()
+    local retries = buf(3, 1):uint()
+    local length = buf(5, 1):uint()
+
+    local subtree = tree:add(rm, buf(), "RadioManager frame")
+    subtree:add(f.version, buf(0, 1))
+    subtree:add(f.direction, buf(1, 1))
+    subtree:add(f.pipe, buf(2, 1))
+    subtree:add(f.retries, buf(3, 1))
+    local flags = subtree:add(f.flags, buf(4, 1))
+    flags:add(f.acked, buf(4, 1))
+    flags:add(f.fifo_full, buf(4, 1))
+    flags:add(f.ack_payload, buf(4, 1))
+    subtree:add(f.length, buf(5, 1))
+
+    local info = string.format("%s pipe %d", directions[direction] or "?", pipe)
+    if direction == 1 then
+        info = info .. string.format(" retries %d", retries)
+    end
+
+    local frame = buf(8)
+    local code = frame:len() >= 3 and frame(0, 1):uint() or nil
+    if bit.band(buf(4, 1):uint(), 0x04) ~= 0 then
+        -- Ack payloads have a 1-byte code, no fragment index
+        subtree:add(f.payload, frame)
+        info = info .. " ack payload"
+    elseif codes[code] then
+        -- Fragment header (PacketHeader): code + little-endian fragment index
+        subtree:add(f.code, frame(0, 1))
+        subtree:add_le(f.index, frame(1, 2))
+        info = info .. string.format(" %s idx %d", string.char(code), frame(1, 2):le_uint())
+        local header_size = 3
+        -- Lowercase codes carry the source id of the sender
+        if code >= 0x61 and code <= 0x7A and frame:len() >= 4 then
+            -- Peers sharing a pipe (gateway mode) send their source id after the header
+            subtree:add(f.source, frame(3, 1))
+            info = info .. string.format(" src %d", frame(3, 1):uint())
+            header_size = 4
+        end
+        if frame:len() > header_size then
+            subtree:add(f.payload, frame(header_size))
+        end
+    else
+        -- Pairing frames (public keys, encrypted addresses) carry no fragment header
+        subtree:add(f.payload, frame)
+        info = info .. " (no fragment header)"
+    end
+    pinfo.cols.info = info .. string.format(" len %d", length)
+    return buf:len()
+end
+
+DissectorTable.get("wtap_encap"):add(wtap.USER0, rm)
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""Decode RadioManager binary traces written by RadioTrace::drain().
+
+Usage: trace_decode.py <dump.bin> [--csv]
+
+A dump is a sequence of drains, each made of a 10-byte header
+("RMTR", version, record size, dropped count) followed by 12-byte records
+(timestamp_us, event, pipe, fragment, value), all little-endian.
+"""
+
+import struct
+import sys
+
+# Must match RadioTrace::Event in RadioTrace.h
+EVENTS = {
+    1: "TX_START",
+    2: "TX_FRAGMENT",
+    3: "TX_FAIL",
+    4: "TX_DONE",
+    5: "RX_FRAGMENT",
+    6: "RX_COMPLETE",
+    7: "RX_INCOMPLETE",
+    8: "RX_TIMEOUT",
+    9: "DECRYPT_OK",
+    10: "DECRYPT_FAIL",
+    11: "MAILBOX_DROP",
+    12: "PAIRING_START",
+    13: "PAIRING_STEP",
+    14: "PAIRING_DONE",
+    15: "PAIRING_ABORT",
+    16: "RX_NO_BUFFER",
+    17: "RATE_CHANGE",
+    18: "POWER_CHANGE",
+    19: "SCAN_DONE",
+    20: "CHANNEL_CHANGE",
+    21: "HOP_SYNC",
+    22: "LBT_BACKOFF",
+    23: "TDMA_BEACON",
+    24: "CLOCK_SYNC",
+    25: "ACK_PAYLOAD",
+    26: "CREDIT_WAIT",
+    27: "STREAM_FEC",
+}
+
+HEADER = struct.Struct("<4sBBI")
+RECORD = struct.Struct("<IBBHI")
+
+
+def decode(data):
+    offset = 0
+    while offset + HEADER.size <= len(data):
+        magic, version, record_size, dropped = HEADER.unpack_from(data, offset)
+        if magic != b"RMTR":
+            # Resynchronise on the next header (e.g. serial noise between drains)
+            next_header = data.find(b"RMTR", offset + 1)
+            if next_header < 0:
+                return
+            offset = next_header
+            continue
+        if version != 1 or record_size != RECORD.size:
+            raise ValueError("Unsupported trace format v%d (record size %d)" % (version, record_size))
+        offset += HEADER.size
+        if dropped:
+            yield None, dropped
+        while offset + RECORD.size <= len(data) and data[offset:offset + 4] != b"RMTR":
+            yield RECORD.unpack_from(data, offset), 0
+            offset += RECORD.size
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        return 1
+    csv = "--csv" in sys.argv
+    with open(sys.argv[1], "rb") as f:
+        data = f.read()
+
+    if csv:
+        print("timestamp_us,delta_us,event,pipe,fragment,value")
+    previous = None
+    for record, dropped in decode(data):
+        if record is None:
+            print("# %d records dropped (ring buffer full)" % dropped)
+            continue
+        timestamp, event, pipe, fragment, value = record
+        delta = 0 if previous is None else (timestamp - previous) & 0xFFFFFFFF
+        previous = timestamp
+        name = EVENTS.get(event, "EVENT_%d" % event)
+        if csv:
+            print("%d,%d,%s,%d,%d,%d" % (timestamp, delta, name, pipe, fragment, value))
+        else:
+            print("%12d us  +%8d  %-14s pipe=%d frag=%-4d value=%d" % (timestamp, delta, name, pipe, fragment, value))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
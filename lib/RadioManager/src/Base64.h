@@ -4,37 +4,86 @@
 #include <Arduino.h>
 #include <vector>
 
+// SSSE3 fast path, only available on host builds (tests, tools, simulators)
+#if !defined(ARDUINO) && defined(__SSSE3__) && !defined(BASE64_NO_SIMD)
+    #define BASE64_SIMD
+    #include <tmmintrin.h>
+#endif
+
 using Bytes = std::vector<uint8_t>;
 
 class Base64 {
 public:
-    static String encode(const uint8_t* data, size_t length) {
-        static const char* encoding_table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-        size_t output_length = 4 * ((length + 2) / 3);
-        String encoded;
-        encoded.reserve(output_length);
+    enum Error : uint8_t {
+        OK = 0,
+        INVALID_LENGTH,   // Input length is not a multiple of 4
+        INVALID_CHAR,     // Input contains a character outside of the Base64 alphabet
+        INVALID_PADDING,  // Misplaced '=' padding character
+        BUFFER_TOO_SMALL  // Output buffer cannot hold the result
+    };
 
-        for (size_t i = 0; i < length;) {
-            uint32_t octet_a = i < length ? data[i++] : 0;
-            uint32_t octet_b = i < length ? data[i++] : 0;
-            uint32_t octet_c = i < length ? data[i++] : 0;
+    /**
+     * @brief Encodes a byte array into a caller-provided char buffer
+     *
+     * @param data Pointer to the data to encode
+     * @param length Length of the data
+     * @param output Output buffer, must hold at least encodedLength(length) chars
+     *               (a NUL terminator is appended if there is room for it)
+     * @param outputSize Size of the output buffer
+     * @return Number of chars written (without NUL), or 0 if the buffer is too small
+     */
+    static size_t encode(const uint8_t* data, size_t length, char* output, size_t outputSize) {
+        size_t output_length = encodedLength(length);
+        if (outputSize < output_length) return 0;
 
-            uint32_t triple = (octet_a << 0x10) + (octet_b << 0x08) + octet_c;
+        const char* ENCODING = encodingTable();
+        size_t i = 0;
+        char* out = output;
+
+#ifdef BASE64_SIMD
+        // 12 input bytes -> 16 chars per iteration (loads 16 bytes, so keep 4 bytes of slack)
+        while (i + 16 <= length) {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), encodeBlock(in));
+            i += 12;
+            out += 16;
+        }
+#endif
 
-            encoded += encoding_table[(triple >> 3 * 6) & 0x3F];
-            encoded += encoding_table[(triple >> 2 * 6) & 0x3F];
-            encoded += encoding_table[(triple >> 1 * 6) & 0x3F];
-            encoded += encoding_table[(triple >> 0 * 6) & 0x3F];
+        // 3 input bytes -> 4 chars
+        for (; i + 3 <= length; i += 3) {
+            uint32_t triple = (uint32_t(data[i]) << 16) | (uint32_t(data[i + 1]) << 8) | data[i + 2];
+            *out++ = ENCODING[(triple >> 18) & 0x3F];
+            *out++ = ENCODING[(triple >> 12) & 0x3F];
+            *out++ = ENCODING[(triple >> 6) & 0x3F];
+            *out++ = ENCODING[triple & 0x3F];
         }
 
-        switch (length % 3) {
-            case 1:
-                encoded[output_length - 1] = '=';
-                encoded[output_length - 2] = '=';
-                break;
-            case 2:
-                encoded[output_length - 1] = '=';
-                break;
+        // Tail and padding
+        size_t remaining = length - i;
+        if (remaining) {
+            uint32_t triple = uint32_t(data[i]) << 16;
+            if (remaining == 2) triple |= uint32_t(data[i + 1]) << 8;
+            *out++ = ENCODING[(triple >> 18) & 0x3F];
+            *out++ = ENCODING[(triple >> 12) & 0x3F];
+            *out++ = (remaining == 2) ? ENCODING[(triple >> 6) & 0x3F] : '=';
+            *out++ = '=';
+        }
+
+        if (outputSize > output_length) output[output_length] = '\0';
+        return output_length;
+    }
+
+    static String encode(const uint8_t* data, size_t length) {
+        String encoded;
+        encoded.reserve(encodedLength(length));
+
+        // Encode by chunks on the stack to avoid appending char by char
+        static const size_t CHUNK_SIZE = 48;
+        char chunk[encodedLength(CHUNK_SIZE) + 1];
+        for (size_t i = 0; i < length; i += CHUNK_SIZE) {
+            size_t n = encode(data + i, std::min(CHUNK_SIZE, length - i), chunk, sizeof(chunk));
+            encoded.concat(chunk, n);
         }
 
         return encoded;
@@ -44,8 +93,136 @@ public:
         return encode(data.data(), data.size());
     }
 
+    /**
+     * @brief Decodes and validates a Base64 string into a caller-provided buffer
+     *
+     * @param input Pointer to the Base64 chars
+     * @param inputLength Number of chars to decode
+     * @param output Output buffer, must hold at least decodedLength(input, inputLength) bytes
+     * @param outputSize Size of the output buffer
+     * @param error Optional pointer to report the reason of a failure
+     * @return Number of bytes written, or 0 on error
+     */
+    static size_t decode(const char* input, size_t inputLength, uint8_t* output, size_t outputSize, Error* error = nullptr) {
+        Error err = validateLength(input, inputLength);
+        size_t output_length = (err == OK) ? decodedLength(input, inputLength) : 0;
+        if (err == OK && outputSize < output_length) err = BUFFER_TOO_SMALL;
+        if (err != OK) {
+            if (error) *error = err;
+            return 0;
+        }
+
+        const uint8_t* DECODING = decodingTable();
+        size_t i = 0;
+        uint8_t* out = output;
+        size_t lastQuad = inputLength ? inputLength - 4 : 0; // Last quartet may hold padding
+
+#ifdef BASE64_SIMD
+        // 16 chars -> 12 bytes per iteration (stores 16 bytes, so keep 4 bytes of slack)
+        while (i + 16 <= lastQuad && size_t(out - output) + 16 <= outputSize) {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            __m128i decoded;
+            if (!decodeBlock(in, decoded)) break; // Let the scalar path locate the error
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), decoded);
+            i += 16;
+            out += 12;
+        }
+#endif
+
+        // 4 chars -> 3 bytes, the "invalid" bit (0x40) of each sextet is accumulated
+        uint8_t invalid = 0;
+        for (; i < lastQuad; i += 4) {
+            uint8_t a = DECODING[uint8_t(input[i])];
+            uint8_t b = DECODING[uint8_t(input[i + 1])];
+            uint8_t c = DECODING[uint8_t(input[i + 2])];
+            uint8_t d = DECODING[uint8_t(input[i + 3])];
+            invalid |= a | b | c | d;
+            uint32_t triple = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | d;
+            *out++ = (triple >> 16) & 0xFF;
+            *out++ = (triple >> 8) & 0xFF;
+            *out++ = triple & 0xFF;
+        }
+
+        // Last quartet (padding was already validated by validateLength)
+        if (inputLength) {
+            uint8_t a = DECODING[uint8_t(input[i])];
+            uint8_t b = DECODING[uint8_t(input[i + 1])];
+            uint8_t c = input[i + 2] == '=' ? 0 : DECODING[uint8_t(input[i + 2])];
+            uint8_t d = input[i + 3] == '=' ? 0 : DECODING[uint8_t(input[i + 3])];
+            invalid |= a | b | c | d;
+            uint32_t triple = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | d;
+            uint8_t* end = output + output_length;
+            if (out < end) *out++ = (triple >> 16) & 0xFF;
+            if (out < end) *out++ = (triple >> 8) & 0xFF;
+            if (out < end) *out++ = triple & 0xFF;
+        }
+
+        if (invalid & 0x40) {
+            // '=' decodes as invalid too, tell a misplaced padding from a bad char
+            if (error) *error = memchr(input, '=', lastQuad) ? INVALID_PADDING : INVALID_CHAR;
+            return 0;
+        }
+
+        if (error) *error = OK;
+        return output_length;
+    }
+
     static size_t decode(const String& input, uint8_t* output) {
-        static const uint8_t decoding_table[256] = {
+        return decode(input.c_str(), input.length(), output, decodedLength(input.c_str(), input.length()));
+    }
+
+    static Bytes decode(const String& input) {
+        Bytes output;
+        decode(input, output);
+        return output;
+    }
+
+    static bool decode(const String& input, Bytes& output, Error* error = nullptr) {
+        Error err = validateLength(input.c_str(), input.length());
+        if (err != OK) {
+            if (error) *error = err;
+            output.clear();
+            return false;
+        }
+        output.resize(decodedLength(input.c_str(), input.length()));
+        decode(input.c_str(), input.length(), output.data(), output.size(), &err);
+        if (error) *error = err;
+        if (err != OK) output.clear();
+        return err == OK;
+    }
+
+    static constexpr size_t encodedLength(size_t length) {
+        return 4 * ((length + 2) / 3);
+    }
+
+    static size_t decodedLength(const char* input, size_t input_length) {
+        if (input_length < 4) return 0;
+        size_t padding = 0;
+        if (input[input_length - 1] == '=') padding++;
+        if (input[input_length - 2] == '=') padding++;
+        return (input_length / 4) * 3 - padding;
+    }
+
+    static const char* errorToStr(Error error) {
+        switch (error) {
+            case OK: return "OK";
+            case INVALID_LENGTH: return "Invalid length";
+            case INVALID_CHAR: return "Invalid character";
+            case INVALID_PADDING: return "Invalid padding";
+            case BUFFER_TOO_SMALL: return "Buffer too small";
+        }
+        return "Unknown error";
+    }
+
+private:
+    static const char* encodingTable() {
+        static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        return table;
+    }
+
+    // 0x40 flags characters outside of the alphabet (including '=')
+    static const uint8_t* decodingTable() {
+        static const uint8_t table[256] = {
             64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
             64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
             64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 62, 64, 64, 64, 63,
@@ -60,59 +237,71 @@ public:
             64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
             64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
             64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+            64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
             64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64
         };
+        return table;
+    }
 
-        size_t input_length = input.length();
-        if (input_length % 4 != 0) return 0;
-
-        size_t output_length = input_length / 4 * 3;
-        if (input[input_length - 1] == '=') output_length--;
-        if (input[input_length - 2] == '=') output_length--;
-
-        size_t i, j;
-        for (i = 0, j = 0; i < input_length;) {
-            uint32_t sextet_a = input[i] == '=' ? 0 & i++ : decoding_table[input[i++]];
-            uint32_t sextet_b = input[i] == '=' ? 0 & i++ : decoding_table[input[i++]];
-            uint32_t sextet_c = input[i] == '=' ? 0 & i++ : decoding_table[input[i++]];
-            uint32_t sextet_d = input[i] == '=' ? 0 & i++ : decoding_table[input[i++]];
-
-            uint32_t triple = (sextet_a << 3 * 6)
-                + (sextet_b << 2 * 6)
-                + (sextet_c << 1 * 6)
-                + (sextet_d << 0 * 6);
-
-            if (j < output_length) output[j++] = (triple >> 2 * 8) & 0xFF;
-            if (j < output_length) output[j++] = (triple >> 1 * 8) & 0xFF;
-            if (j < output_length) output[j++] = (triple >> 0 * 8) & 0xFF;
+    // Checks length and padding of the last quartet, the other chars are checked while decoding
+    static Error validateLength(const char* input, size_t inputLength) {
+        if (inputLength % 4 != 0) return INVALID_LENGTH;
+        if (inputLength) {
+            const char* last = input + inputLength - 4;
+            if (last[0] == '=' || last[1] == '=') return INVALID_PADDING;
+            if (last[2] == '=' && last[3] != '=') return INVALID_PADDING;
         }
-
-        return output_length;
+        return OK;
     }
 
-    static Bytes decode(const String& input) {
-        Bytes output;
-        decode(input, output);
-        return output;
-    }
+#ifdef BASE64_SIMD
+    // Bytes [0..11] of 'in' -> 16 Base64 chars (W. Mula / D. Lemire SSSE3 algorithm)
+    static __m128i encodeBlock(__m128i in) {
+        in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+        const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+        const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+        const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        const __m128i indices = _mm_or_si128(t1, t3);
 
-    static bool decode(const String& input, Bytes& output) {
-        size_t output_length = decodedLength(input.c_str(), input.length());
-        output.resize(output_length);
-        size_t decoded_size = decode(input, output.data());
-        return decoded_size == output_length;
+        // Map 6-bit indices to ASCII with an offset lookup
+        __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+        const __m128i shiftLUT = _mm_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+        result = _mm_shuffle_epi8(shiftLUT, result);
+        return _mm_add_epi8(result, indices);
     }
 
-    static size_t encodedLength(size_t length) {
-        return 4 * ((length + 2) / 3);
-    }
+    // 16 Base64 chars -> bytes [0..11] of 'out', returns false on any invalid char
+    static bool decodeBlock(__m128i in, __m128i& out) {
+        const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+        const __m128i loNibbles = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+        const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+        const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                              0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+        const __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()))) {
+            return false;
+        }
 
-    static size_t decodedLength(const char* input, size_t input_length) {
-        size_t padding = 0;
-        if (input_length > 0 && input[input_length - 1] == '=') padding++;
-        if (input_length > 1 && input[input_length - 2] == '=') padding++;
-        return (input_length / 4) * 3 - padding;
+        const __m128i eq2F = _mm_cmpeq_epi8(in, _mm_set1_epi8(0x2f));
+        const __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles));
+        const __m128i values = _mm_add_epi8(in, roll);
+
+        // Pack 4 x 6-bit values into 3 bytes
+        const __m128i mergeAB = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        const __m128i merged = _mm_madd_epi16(mergeAB, _mm_set1_epi32(0x00011000));
+        out = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        return true;
     }
+#endif
 };
 
-#endif // BASE64_H
\ No newline at end of file
+#endif // BASE64_H
@@ -0,0 +1,36 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <Arduino.h>
+
+class Crc32 {
+public:
+    static const uint32_t INITIAL = 0;
+
+    /**
+     * @brief Computes (or continues) an IEEE 802.3 CRC-32, as used by zlib/PNG
+     *
+     * Uses a 16-entry nibble table to keep flash usage minimal.
+     *
+     * @param data Pointer to the data
+     * @param length Length of the data
+     * @param crc Value returned by a previous call to continue a computation
+     * @return The CRC-32 of all data processed so far
+     */
+    static uint32_t compute(const void* data, size_t length, uint32_t crc = INITIAL) {
+        static const uint32_t table[16] = {
+            0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+            0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+        };
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        crc = ~crc;
+        while (length--) {
+            crc ^= *p++;
+            crc = table[crc & 0x0F] ^ (crc >> 4);
+            crc = table[crc & 0x0F] ^ (crc >> 4);
+        }
+        return ~crc;
+    }
+};
+
+#endif // CRC32_H
@@ -0,0 +1,90 @@
+#ifndef RADIO_ADDRESS_H
+#define RADIO_ADDRESS_H
+
+#include <Arduino.h>
+
+/**
+ * @brief nRF24 address of a node: pipe digit + 4-character UID, e.g. "1X2d8"
+ *
+ * Stored as the 5 bytes given to the radio (pipe character first), so that it can be
+ * passed to openWritingPipe() as-is, without String or allocation. The UID is read as a
+ * uint32_t for comparisons and hashing. A zero pipe means "not paired".
+ */
+struct RadioAddress {
+    static const uint8_t SIZE = 5;
+    static const uint8_t UID_SIZE = 4;
+
+    char pipe;      // '0'-'5'
+    uint32_t uid;   // UID characters, in memory order
+
+    void clear() {
+        pipe = 0;
+        uid = 0;
+    }
+
+    bool isEmpty() const {
+        return pipe == 0;
+    }
+
+    const uint8_t* bytes() const {
+        return reinterpret_cast<const uint8_t*>(this);
+    }
+
+    bool operator==(const RadioAddress& other) const {
+        return pipe == other.pipe && uid == other.uid;
+    }
+
+    bool operator!=(const RadioAddress& other) const {
+        return !(*this == other);
+    }
+
+    static uint32_t uidFromChars(const char* chars) {
+        uint32_t value;
+        memcpy(&value, chars, UID_SIZE);
+        return value;
+    }
+
+    /**
+     * @brief Reads a 5-character address
+     *
+     * @return false if the string is not 5 characters long
+     */
+    static bool parse(const char* str, size_t length, RadioAddress& address) {
+        if (str == nullptr || length != SIZE) return false;
+        address.pipe = str[0];
+        address.uid = uidFromChars(str + 1);
+        return true;
+    }
+
+    static bool parse(const String& str, RadioAddress& address) {
+        return parse(str.c_str(), str.length(), address);
+    }
+
+    /**
+     * @brief Writes the address as a null-terminated string in a 6-byte buffer (empty if not paired)
+     */
+    void toChars(char* out) const {
+        if (isEmpty()) {
+            out[0] = '\0';
+            return;
+        }
+        memcpy(out, bytes(), SIZE);
+        out[SIZE] = '\0';
+    }
+
+    String toString() const {
+        char str[SIZE + 1];
+        toChars(str);
+        return String(str);
+    }
+
+    String uidToString() const {
+        char str[UID_SIZE + 1] = {0};
+        if (!isEmpty()) memcpy(str, bytes() + 1, UID_SIZE);
+        return String(str);
+    }
+} __attribute__((packed));
+
+static_assert(sizeof(RadioAddress) == RadioAddress::SIZE, "RadioAddress must match the 5-byte radio address");
+
+#endif // RADIO_ADDRESS_H
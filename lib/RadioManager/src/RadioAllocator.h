@@ -0,0 +1,66 @@
+#ifndef RADIO_ALLOCATOR_H
+#define RADIO_ALLOCATOR_H
+
+#include <Arduino.h>
+#include <stdlib.h>
+
+#if defined(ESP32) || defined(ESP_PLATFORM)
+    #include <esp_heap_caps.h>
+#endif
+
+/**
+ * @brief Memory policy for the buffers RadioManager allocates once in begin()
+ *
+ * Buffers are requested from a tier: LARGE for message payloads (pool blocks holding the
+ * mailboxes, reassembly buffers and outgoing message), FAST for the small structures walked
+ * on every fragment (pool block links). Fragment buffers are part of the RadioManager object
+ * and stay wherever it lives. See RadioHeapAllocator (ESP32 PSRAM) and RadioTieredAllocator (host).
+ */
+class RadioAllocator {
+public:
+    enum Tier : uint8_t {
+        FAST = 0,   // Internal RAM
+        LARGE,      // External RAM (PSRAM) when available
+        TIER_COUNT
+    };
+
+    virtual ~RadioAllocator() {}
+
+    // Allocate size bytes from a tier, nullptr if out of memory
+    virtual void* allocate(size_t size, uint8_t tier) = 0;
+    // Release a buffer obtained from allocate() with the same tier
+    virtual void release(void* buffer, uint8_t tier) = 0;
+};
+
+/**
+ * @brief Default allocator: LARGE buffers in PSRAM on ESP32 boards that have it
+ *
+ * LARGE buffers fall back to internal RAM when PSRAM is missing or full. On other
+ * platforms, both tiers use malloc().
+ */
+class RadioHeapAllocator : public RadioAllocator {
+public:
+    void* allocate(size_t size, uint8_t tier) override {
+#if defined(ESP32) || defined(ESP_PLATFORM)
+        if (tier == LARGE) {
+            void* buffer = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            if (buffer != nullptr) return buffer;
+        }
+        return heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+        (void)tier;
+        return malloc(size);
+#endif
+    }
+
+    void release(void* buffer, uint8_t tier) override {
+        (void)tier;
+#if defined(ESP32) || defined(ESP_PLATFORM)
+        heap_caps_free(buffer);
+#else
+        free(buffer);
+#endif
+    }
+};
+
+#endif // RADIO_ALLOCATOR_H
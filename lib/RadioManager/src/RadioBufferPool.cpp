@@ -0,0 +1,259 @@
+#include "RadioBufferPool.h"
+
+/**
+ * @brief Construct an empty RadioBufferPool (no block until begin() is called)
+ */
+RadioBufferPool::RadioBufferPool()
+    : data(nullptr), links(nullptr), blockCount(0), freeHead(NONE), freeCount(0), highWater(0), allocFailures(0) {
+    memset(used, 0, sizeof(used));
+    memset(quota, 0, sizeof(quota));
+    memset(ownerHighWater, 0, sizeof(ownerHighWater));
+}
+
+/**
+ * @brief Hands the block storage to the pool and frees all blocks
+ *
+ * Chains obtained before are invalidated. Quotas are reset to the whole pool.
+ *
+ * @param data Storage of blockCount * BLOCK_SIZE bytes
+ * @param links Storage of blockCount block links
+ * @param blockCount Number of blocks (less than NONE)
+ */
+void RadioBufferPool::begin(uint8_t* data, uint16_t* links, uint16_t blockCount) {
+    this->data = data;
+    this->links = links;
+    this->blockCount = (data != nullptr && links != nullptr && blockCount < NONE) ? blockCount : 0;
+    for (uint16_t i = 0; i < this->blockCount; i++) {
+        links[i] = (i + 1 < this->blockCount) ? i + 1 : NONE;
+    }
+    freeHead = this->blockCount ? 0 : NONE;
+    freeCount = this->blockCount;
+    highWater = 0;
+    allocFailures = 0;
+    for (uint8_t i = 0; i < MAX_OWNERS; i++) {
+        used[i] = 0;
+        quota[i] = this->blockCount;
+        ownerHighWater[i] = 0;
+    }
+}
+
+/**
+ * @brief Appends bytes to a chain, allocating blocks as needed
+ *
+ * Nothing is appended if the pool or the quota of the owner can't hold all the bytes.
+ *
+ * @param chain The chain (an empty chain takes the owner)
+ * @param owner Owner charged for the new blocks, must match the owner of a non-empty chain
+ * @param data Bytes to append
+ * @param length Number of bytes
+ * @return true if the bytes were appended, false if out of blocks or quota
+ */
+bool RadioBufferPool::append(Chain& chain, uint8_t owner, const uint8_t* data, size_t length) {
+    if (length == 0) {
+        return true;
+    }
+    if (owner >= MAX_OWNERS || (!chain.empty() && chain.owner != owner) || chain.length + length > 0xFFFF) {
+        allocFailures++;
+        return false;
+    }
+
+    size_t end = chain.empty() ? 0 : (chain.start + chain.length) % BLOCK_SIZE;
+    size_t space = (chain.empty() || end == 0) ? 0 : BLOCK_SIZE - end;
+    uint16_t needed = length > space ? blocksFor(length - space) : 0;
+    if (needed > freeCount || used[owner] + needed > quota[owner]) {
+        allocFailures++;
+        return false;
+    }
+
+    if (chain.empty()) {
+        chain = Chain();
+        chain.owner = owner;
+    }
+    while (length > 0) {
+        if (space == 0) {
+            uint16_t block = freeHead;
+            freeHead = links[block];
+            freeCount--;
+            links[block] = NONE;
+            if (chain.head == NONE) {
+                chain.head = block;
+            } else {
+                links[chain.tail] = block;
+            }
+            chain.tail = block;
+            end = 0;
+            space = BLOCK_SIZE;
+            used[owner]++;
+        }
+        size_t count = std::min(space, length);
+        memcpy(this->data + (size_t)chain.tail * BLOCK_SIZE + end, data, count);
+        chain.length += count;
+        data += count;
+        length -= count;
+        end += count;
+        space -= count;
+    }
+
+    if (blockCount - freeCount > highWater) highWater = blockCount - freeCount;
+    if (used[owner] > ownerHighWater[owner]) ownerHighWater[owner] = used[owner];
+    return true;
+}
+
+/**
+ * @brief Copies bytes out of a chain
+ *
+ * @param chain The chain
+ * @param offset Offset of the first byte to copy
+ * @param buffer Destination buffer
+ * @param length Number of bytes to copy
+ * @return The number of bytes copied
+ */
+size_t RadioBufferPool::read(const Chain& chain, size_t offset, uint8_t* buffer, size_t length) const {
+    if (offset >= chain.length) {
+        return 0;
+    }
+    length = std::min<size_t>(length, chain.length - offset);
+    size_t position = chain.start + offset;
+    uint16_t block = chain.head;
+    while (position >= BLOCK_SIZE) {
+        position -= BLOCK_SIZE;
+        block = links[block];
+    }
+    size_t copied = 0;
+    while (copied < length) {
+        size_t count = std::min<size_t>(BLOCK_SIZE - position, length - copied);
+        memcpy(buffer + copied, data + (size_t)block * BLOCK_SIZE + position, count);
+        copied += count;
+        position = 0;
+        block = links[block];
+    }
+    return copied;
+}
+
+/**
+ * @brief Drops bytes from the front of a chain, freeing the blocks left empty
+ *
+ * @param chain The chain
+ * @param length Number of bytes to drop
+ */
+void RadioBufferPool::consume(Chain& chain, size_t length) {
+    if (length >= chain.length) {
+        release(chain);
+        return;
+    }
+    chain.start += length;
+    chain.length -= length;
+    while (chain.start >= BLOCK_SIZE) {
+        uint16_t block = chain.head;
+        chain.head = links[block];
+        links[block] = freeHead;
+        freeHead = block;
+        freeCount++;
+        used[chain.owner]--;
+        chain.start -= BLOCK_SIZE;
+    }
+}
+
+/**
+ * @brief Returns all the blocks of a chain to the pool and empties it
+ *
+ * @param chain The chain
+ */
+void RadioBufferPool::release(Chain& chain) {
+    if (chain.head != NONE) {
+        uint16_t count = blocksFor(chain.start + chain.length);
+        links[chain.tail] = freeHead;
+        freeHead = chain.head;
+        freeCount += count;
+        used[chain.owner] -= count;
+    }
+    chain = Chain();
+}
+
+/**
+ * @brief Sets the maximum number of blocks an owner may hold
+ *
+ * @param owner The owner
+ * @param blocks Maximum number of blocks (capped to the pool size)
+ */
+void RadioBufferPool::setQuota(uint8_t owner, uint16_t blocks) {
+    if (owner < MAX_OWNERS) {
+        quota[owner] = std::min(blocks, blockCount);
+    }
+}
+
+/**
+ * @brief Gets the maximum number of blocks an owner may hold
+ *
+ * @param owner The owner
+ * @return The quota in blocks, 0 if the owner is invalid
+ */
+uint16_t RadioBufferPool::getQuota(uint8_t owner) const {
+    return owner < MAX_OWNERS ? quota[owner] : 0;
+}
+
+/**
+ * @brief Gets the number of blocks of the pool
+ *
+ * @return The number of blocks
+ */
+uint16_t RadioBufferPool::getBlockCount() const {
+    return blockCount;
+}
+
+/**
+ * @brief Gets the number of blocks currently free
+ *
+ * @return The number of free blocks
+ */
+uint16_t RadioBufferPool::getFreeBlocks() const {
+    return freeCount;
+}
+
+/**
+ * @brief Gets the number of blocks currently held by an owner
+ *
+ * @param owner The owner
+ * @return The number of blocks, 0 if the owner is invalid
+ */
+uint16_t RadioBufferPool::getUsedBlocks(uint8_t owner) const {
+    return owner < MAX_OWNERS ? used[owner] : 0;
+}
+
+/**
+ * @brief Gets the highest number of blocks in use at once
+ *
+ * @return The high-water mark in blocks
+ */
+uint16_t RadioBufferPool::getHighWater() const {
+    return highWater;
+}
+
+/**
+ * @brief Gets the highest number of blocks held at once by an owner
+ *
+ * @param owner The owner
+ * @return The high-water mark in blocks, 0 if the owner is invalid
+ */
+uint16_t RadioBufferPool::getHighWater(uint8_t owner) const {
+    return owner < MAX_OWNERS ? ownerHighWater[owner] : 0;
+}
+
+/**
+ * @brief Gets the number of appends refused for lack of blocks or quota
+ *
+ * @return The number of failures
+ */
+uint32_t RadioBufferPool::getAllocFailures() const {
+    return allocFailures;
+}
+
+/**
+ * @brief Restarts the high-water marks from the current usage
+ */
+void RadioBufferPool::resetHighWater() {
+    highWater = blockCount - freeCount;
+    for (uint8_t i = 0; i < MAX_OWNERS; i++) {
+        ownerHighWater[i] = used[i];
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef RADIO_BUFFER_POOL_H
+#define RADIO_BUFFER_POOL_H
+
+#include <Arduino.h>
+#include <RadioConfig.h>
+
+/**
+ * @brief Pool of fixed-size blocks shared by the message buffers
+ *
+ * Messages are stored as chains of blocks, so any message size fits without a contiguous
+ * allocation and memory released by one peer is immediately reusable by another. Every chain
+ * belongs to an owner (a peer channel, or the TX queue) whose block usage is capped by a quota
+ * and tracked with a high-water mark. The block storage is provided by the caller, nothing is
+ * allocated by the pool.
+ */
+class RadioBufferPool {
+public:
+    static const uint16_t BLOCK_SIZE = RadioManagerConfig::POOL_BLOCK_SIZE;
+    static const uint8_t MAX_OWNERS = RadioManagerConfig::MAX_PEERS + 1; // Peer channels + TX queue
+    static const uint16_t NONE = 0xFFFF;
+
+    // Message stored in the pool, a plain value: copying it doesn't copy the data
+    struct Chain {
+        uint16_t head;   // First block, NONE if empty
+        uint16_t tail;   // Last block
+        uint16_t start;  // Offset of the first byte in the head block
+        uint16_t length; // Number of bytes
+        uint8_t owner;
+
+        Chain() : head(NONE), tail(NONE), start(0), length(0), owner(0) {}
+        bool empty() const { return length == 0; }
+    };
+
+    RadioBufferPool();
+
+    void begin(uint8_t* data, uint16_t* links, uint16_t blockCount);
+
+    bool append(Chain& chain, uint8_t owner, const uint8_t* data, size_t length);
+    size_t read(const Chain& chain, size_t offset, uint8_t* buffer, size_t length) const;
+    void consume(Chain& chain, size_t length);
+    void release(Chain& chain);
+
+    /**
+     * @brief Calls f(uint8_t* data, size_t length) on each contiguous segment of a chain
+     *
+     * @param chain The chain
+     * @param offset Offset of the first byte to visit
+     * @param f Function called for each segment, may modify the bytes in place
+     */
+    template <typename F>
+    void forEachSegment(Chain& chain, size_t offset, F f) {
+        size_t position = chain.start + offset;
+        size_t remaining = offset < chain.length ? chain.length - offset : 0;
+        uint16_t block = chain.head;
+        while (remaining > 0 && block != NONE) {
+            if (position >= BLOCK_SIZE) {
+                position -= BLOCK_SIZE;
+            } else {
+                size_t length = std::min<size_t>(BLOCK_SIZE - position, remaining);
+                f(data + (size_t)block * BLOCK_SIZE + position, length);
+                remaining -= length;
+                position = 0;
+            }
+            block = links[block];
+        }
+    }
+
+    void setQuota(uint8_t owner, uint16_t blocks);
+    uint16_t getQuota(uint8_t owner) const;
+
+    uint16_t getBlockCount() const;
+    uint16_t getFreeBlocks() const;
+    uint16_t getUsedBlocks(uint8_t owner) const;
+    uint16_t getHighWater() const;
+    uint16_t getHighWater(uint8_t owner) const;
+    uint32_t getAllocFailures() const;
+    void resetHighWater();
+
+    static uint16_t blocksFor(size_t length) { return (length + BLOCK_SIZE - 1) / BLOCK_SIZE; }
+
+private:
+    uint8_t* data;       // blockCount * BLOCK_SIZE bytes
+    uint16_t* links;     // Next block of each block (chains and free list)
+    uint16_t blockCount;
+    uint16_t freeHead;
+    uint16_t freeCount;
+    uint16_t highWater;
+    uint32_t allocFailures;
+
+    uint16_t used[MAX_OWNERS];
+    uint16_t quota[MAX_OWNERS];
+    uint16_t ownerHighWater[MAX_OWNERS];
+};
+
+#endif // RADIO_BUFFER_POOL_H
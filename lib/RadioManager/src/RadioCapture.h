@@ -0,0 +1,195 @@
+#ifndef RADIO_CAPTURE_H
+#define RADIO_CAPTURE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+#ifndef RADIO_CAPTURE_CAPACITY
+    #define RADIO_CAPTURE_CAPACITY 64 // Number of frames, must be a power of 2
+#endif
+
+/**
+ * @brief One radio frame as seen by RadioManager, with its metadata
+ */
+struct RadioCaptureFrame {
+    enum Direction : uint8_t {
+        RX = 0,
+        TX = 1
+    };
+    enum Flags : uint8_t {
+        FLAG_ACKED = 0x01,        // TX: frame acknowledged by the receiver
+        FLAG_RX_FIFO_FULL = 0x02, // RX: FIFO was full when the frame was read
+        FLAG_ACK_PAYLOAD = 0x04   // RX: payload of the acknowledgement of our last frame
+    };
+    static const uint8_t MAX_LENGTH = 32;
+
+    uint64_t timestamp; // micros() when the frame was written/read, extended past its 32-bit wrap
+    uint8_t direction;  // Direction
+    uint8_t pipe;       // RX: reading pipe, TX: pipe digit of the target address (0 for pairing)
+    uint8_t retries;    // TX: hardware auto-retransmissions (ARC), RX: 0
+    uint8_t flags;      // Flags
+    uint8_t length;     // Number of valid bytes in data
+    uint8_t data[MAX_LENGTH];
+};
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring buffer of radio frames
+ *
+ * Installed with RadioManager::setCaptureSink(), filled by the radio loop and drained
+ * by the application (e.g. with RadioPcapWriter to Serial or SD). Frames that don't fit
+ * are dropped and counted, capture never blocks the radio loop.
+ */
+class RadioCapture {
+public:
+    static const uint32_t CAPACITY = RADIO_CAPTURE_CAPACITY;
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "RADIO_CAPTURE_CAPACITY must be a power of 2");
+
+    RadioCapture() : head(0), tail(0), dropped(0), lastMicros(0), wraps(0) {}
+
+    /**
+     * @brief Append a frame (producer side, never blocks)
+     */
+    void capture(uint8_t direction, uint8_t pipe, uint8_t retries, uint8_t flags, const void* data, uint8_t length) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= CAPACITY) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        RadioCaptureFrame& frame = buffer[h & (CAPACITY - 1)];
+        frame.timestamp = timestamp();
+        frame.direction = direction;
+        frame.pipe = pipe;
+        frame.retries = retries;
+        frame.flags = flags;
+        frame.length = length < RadioCaptureFrame::MAX_LENGTH ? length : RadioCaptureFrame::MAX_LENGTH;
+        memcpy(frame.data, data, frame.length);
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Pop the oldest frame (consumer side)
+     *
+     * @return true if a frame was copied into frame, false if the buffer is empty
+     */
+    bool pop(RadioCaptureFrame& frame) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        frame = buffer[t & (CAPACITY - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    uint32_t getDropped() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    /**
+     * @brief micros() extended to 64 bits, so timestamps keep increasing after it wraps (~71.6 min)
+     *
+     * A wrap is seen when micros() goes backwards between two frames, only the producer calls it.
+     */
+    uint64_t timestamp() {
+        uint32_t now = micros();
+        if (now < lastMicros) {
+            wraps++;
+        }
+        lastMicros = now;
+        return ((uint64_t)wraps << 32) | now;
+    }
+
+    RadioCaptureFrame buffer[CAPACITY];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> dropped;
+    uint32_t lastMicros; // Producer only
+    uint32_t wraps;      // Producer only
+};
+
+/**
+ * @brief Writes captured frames as a pcap stream (usable on device or host)
+ *
+ * Frames use the DLT_USER0 link type (147). Each packet starts with an 8-byte
+ * pseudo-header (version, direction, pipe, retries, flags, length, 2 reserved bytes)
+ * followed by the raw frame. extras/radiomanager.lua dissects it in Wireshark.
+ */
+class RadioPcapWriter {
+public:
+    static const uint32_t LINKTYPE = 147; // LINKTYPE_USER0
+    static const uint8_t PSEUDO_HEADER_VERSION = 1;
+
+    /**
+     * @brief Write the pcap global header, once at the start of the stream
+     */
+    static size_t begin(Print& out) {
+        uint8_t header[24];
+        put32(header, 0xa1b2c3d4);      // Magic, microsecond timestamps
+        put16(header + 4, 2);           // Version 2.4
+        put16(header + 6, 4);
+        put32(header + 8, 0);           // Timezone offset
+        put32(header + 12, 0);          // Timestamp accuracy
+        put32(header + 16, 8 + RadioCaptureFrame::MAX_LENGTH); // Snapshot length
+        put32(header + 20, LINKTYPE);
+        return out.write(header, sizeof(header));
+    }
+
+    /**
+     * @brief Write one frame as a pcap record
+     *
+     * @param out Destination stream
+     * @param frame Captured frame
+     * @param epochOffsetUs Offset added to the frame timestamp (e.g. boot time since 1970)
+     */
+    static size_t write(Print& out, const RadioCaptureFrame& frame, uint64_t epochOffsetUs = 0) {
+        uint64_t ts = epochOffsetUs + frame.timestamp;
+        uint32_t length = 8 + frame.length;
+        uint8_t record[16 + 8];
+        put32(record, ts / 1000000);
+        put32(record + 4, ts % 1000000);
+        put32(record + 8, length);      // Captured length
+        put32(record + 12, length);     // Original length
+        uint8_t* pseudo = record + 16;
+        pseudo[0] = PSEUDO_HEADER_VERSION;
+        pseudo[1] = frame.direction;
+        pseudo[2] = frame.pipe;
+        pseudo[3] = frame.retries;
+        pseudo[4] = frame.flags;
+        pseudo[5] = frame.length;
+        pseudo[6] = 0;
+        pseudo[7] = 0;
+        size_t written = out.write(record, sizeof(record));
+        return written + out.write(frame.data, frame.length);
+    }
+
+    /**
+     * @brief Write all pending frames of a capture ring
+     *
+     * @return Number of frames written
+     */
+    static size_t drain(Print& out, RadioCapture& capture, uint64_t epochOffsetUs = 0) {
+        size_t count = 0;
+        RadioCaptureFrame frame;
+        while (capture.pop(frame)) {
+            write(out, frame, epochOffsetUs);
+            count++;
+        }
+        return count;
+    }
+
+private:
+    static void put16(uint8_t* p, uint16_t v) {
+        p[0] = v & 0xFF;
+        p[1] = v >> 8;
+    }
+
+    static void put32(uint8_t* p, uint32_t v) {
+        put16(p, v & 0xFFFF);
+        put16(p + 2, v >> 16);
+    }
+};
+
+#endif // RADIO_CAPTURE_H
@@ -0,0 +1,91 @@
+#ifndef RADIO_CHANNEL_SCAN_H
+#define RADIO_CHANNEL_SCAN_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Occupancy histogram of the 126 nRF24 channels, filled by RadioManager::startScan()
+ *
+ * Each sweep listens briefly on every channel and counts the channels on which a carrier
+ * above -64 dBm was detected (RPD). The histogram holds the last scan, keep copies of it
+ * (or of dump()) to follow the RF noise over time.
+ */
+class RadioChannelScan {
+public:
+    static const uint8_t CHANNEL_COUNT = 126;
+
+    RadioChannelScan() { reset(); }
+
+    void reset() {
+        memset(busy, 0, sizeof(busy));
+        sweeps = 0;
+        scanTime = 0;
+    }
+
+    void record(uint8_t channel, bool carrier) {
+        if (channel < CHANNEL_COUNT && carrier && busy[channel] < 0xFFFF) busy[channel]++;
+    }
+
+    void endSweep() {
+        if (sweeps < 0xFFFF) sweeps++;
+    }
+
+    void finish(unsigned long time) { scanTime = time; }
+
+    uint16_t getSweeps() const { return sweeps; }
+    // millis() at the end of the scan, 0 if no scan completed
+    unsigned long getScanTime() const { return scanTime; }
+    // Number of sweeps in which a carrier was detected on the channel
+    uint16_t getBusy(uint8_t channel) const { return channel < CHANNEL_COUNT ? busy[channel] : 0; }
+    // Percentage of sweeps in which a carrier was detected on the channel
+    uint8_t getOccupancy(uint8_t channel) const {
+        return (sweeps && channel < CHANNEL_COUNT) ? (uint32_t)busy[channel] * 100 / sweeps : 0;
+    }
+
+    /**
+     * @brief Finds the quietest channel, taking the neighbours into account
+     *
+     * A channel scores twice its own occupancy plus the occupancy of each adjacent channel
+     * (a 2 Mbps link spans 2 MHz). Ties go to the highest channel, above the WiFi band.
+     *
+     * @param exclude Channel that can't be chosen (e.g. the rendezvous channel), 255 for none
+     * @return The quietest channel
+     */
+    uint8_t quietest(uint8_t exclude = 255) const {
+        uint8_t best = 0;
+        uint32_t bestScore = UINT32_MAX;
+        for (uint8_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+            if (channel == exclude) continue;
+            uint32_t score = 2 * (uint32_t)busy[channel];
+            if (channel > 0) score += busy[channel - 1];
+            if (channel + 1 < CHANNEL_COUNT) score += busy[channel + 1];
+            if (score <= bestScore) {
+                best = channel;
+                bestScore = score;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * @brief Prints the busy channels as "channel:occupancy%" pairs on one line
+     */
+    void dump(Print& out) const {
+        char item[16];
+        snprintf(item, sizeof(item), "sweeps=%u", sweeps);
+        out.print(item);
+        for (uint8_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+            if (busy[channel] == 0) continue;
+            snprintf(item, sizeof(item), " %u:%u%%", channel, getOccupancy(channel));
+            out.print(item);
+        }
+        out.println();
+    }
+
+private:
+    uint16_t busy[CHANNEL_COUNT];
+    uint16_t sweeps;
+    unsigned long scanTime;
+};
+
+#endif // RADIO_CHANNEL_SCAN_H
@@ -0,0 +1,297 @@
+#ifndef RADIO_CONFIG_H
+#define RADIO_CONFIG_H
+
+#include <stdint.h>
+
+// Compile-time options shared by the library headers, set them in build_flags (e.g. -DRADIO_MANAGER_GATEWAY)
+
+// #define RADIO_MANAGER_GATEWAY // Gateway mode: multiplex up to RADIO_MANAGER_MAX_PEERS peers over the 5 reading pipes
+
+// #define RADIO_MANAGER_TRACE // Enable the binary event trace
+
+// #define RADIO_MANAGER_PROFILE // Enable the execution-time profiler
+
+// #define RADIO_MANAGER_SMALL_NODE // Preset for memory-constrained nodes: 1 peer, 1-message mailbox, 256-byte messages, 2 KB object
+
+// #define RADIO_MANAGER_HEAP_BUDGET 2048 // Fail the build if the message buffer pool exceeds this many bytes
+
+// #define RADIO_MANAGER_OBJECT_BUDGET 2048 // Fail the build if sizeof(RadioManager) exceeds this many bytes (2048 with RADIO_MANAGER_SMALL_NODE)
+
+// #define RADIO_MANAGER_ADAPTIVE_RATE // Per-peer data rate (250 kbps to 2 Mbps) negotiated from retransmissions, on all nodes
+
+// #define RADIO_MANAGER_ADAPTIVE_POWER // Per-peer PA level lowered while fragments get through without retransmission
+
+// #define RADIO_MANAGER_CHANNEL_SCAN // Scan the 126 RF channels for carriers and move the paired nodes to the quietest one (startScan())
+
+// #define RADIO_MANAGER_HOPPING // Paired nodes hop over RF channels in time slots set by a coordinator (startHopping())
+
+// #define RADIO_MANAGER_LBT // Listen before talk: sense the carrier before each message and back off while the channel is busy
+
+// #define RADIO_MANAGER_TDMA // Nodes transmit in the time slots announced by a coordinator's beacons (startTdma())
+
+// #define RADIO_MANAGER_TIME_SYNC // Clock offset and drift of each peer estimated from timestamp exchanges (syncClock())
+
+// #define RADIO_MANAGER_ACK_PAYLOAD // Replies queued per peer ride on the auto-acks of its frames (setAckPayload()), on all nodes
+
+// #define RADIO_MANAGER_FLOW_CONTROL // Receivers advertise free mailbox room in ack payloads, senders wait for it (on all nodes)
+
+// #define RADIO_MANAGER_STREAM // Unacknowledged telemetry stream with one XOR parity frame per block (sendStream()), on all nodes
+
+// #define RADIO_MANAGER_STATIC_MEMORY // No heap allocation after begin() when sending, receiving and pairing
+
+#if defined(RADIO_MANAGER_FLOW_CONTROL) && !defined(RADIO_MANAGER_ACK_PAYLOAD)
+    #define RADIO_MANAGER_ACK_PAYLOAD // Credits ride on the ack payloads
+#endif
+
+#ifdef RADIO_MANAGER_SMALL_NODE
+    #ifndef RADIO_MANAGER_MAX_PEERS
+        #define RADIO_MANAGER_MAX_PEERS 1
+    #endif
+    #ifndef RADIO_MANAGER_MAILBOX_DEPTH
+        #define RADIO_MANAGER_MAILBOX_DEPTH 1
+    #endif
+    #ifndef RADIO_MANAGER_MAX_MSG_SIZE
+        #define RADIO_MANAGER_MAX_MSG_SIZE 256
+    #endif
+    #ifndef RADIO_MANAGER_MAX_PACKETS_RCV
+        #define RADIO_MANAGER_MAX_PACKETS_RCV 10 // 10 * 28 bytes >= 256 + 12-byte nonce
+    #endif
+    #ifndef RADIO_MANAGER_OBJECT_BUDGET
+        #define RADIO_MANAGER_OBJECT_BUDGET 2048 // 2 KB target of small nodes, without the pool (RADIO_MANAGER_HEAP_BUDGET)
+    #endif
+#endif
+
+#ifndef RADIO_MANAGER_MAX_PEERS
+    #ifdef RADIO_MANAGER_GATEWAY
+        #define RADIO_MANAGER_MAX_PEERS 32 // Number of peers in gateway mode (at most 254)
+    #else
+        #define RADIO_MANAGER_MAX_PEERS 5 // One reading pipe per peer (at most 5)
+    #endif
+#endif
+
+#ifndef RADIO_MANAGER_MAILBOX_DEPTH
+    #define RADIO_MANAGER_MAILBOX_DEPTH 3 // Received messages kept per peer, the oldest is dropped on overflow
+#endif
+
+#ifndef RADIO_MANAGER_MAX_MSG_SIZE
+    #define RADIO_MANAGER_MAX_MSG_SIZE 2048 // Largest cleartext message sent
+#endif
+
+#ifndef RADIO_MANAGER_MAX_PACKETS_RCV
+    #define RADIO_MANAGER_MAX_PACKETS_RCV 100 // Largest number of fragments accepted in a received message
+#endif
+
+#ifndef RADIO_MANAGER_POOL_BLOCK_SIZE
+    #define RADIO_MANAGER_POOL_BLOCK_SIZE 32 // Bytes per block of the message buffer pool
+#endif
+
+// #define RADIO_MANAGER_POOL_SIZE 8192 // Bytes of the message buffer pool (default: worst case, at most 8 KB)
+
+#ifndef RADIO_MANAGER_RECEIVE_TIMEOUT
+    #define RADIO_MANAGER_RECEIVE_TIMEOUT 1000 // Partial message dropped after this many ms without a fragment
+#endif
+
+#ifndef RADIO_MANAGER_PAIRING_TIMEOUT
+    #define RADIO_MANAGER_PAIRING_TIMEOUT 10000 // ms
+#endif
+
+#ifndef RADIO_MANAGER_PAIRING_INTERVAL
+    #define RADIO_MANAGER_PAIRING_INTERVAL 250 // ms between pairing frames
+#endif
+
+#ifndef RADIO_MANAGER_PAIRING_LISTEN_TIME
+    #define RADIO_MANAGER_PAIRING_LISTEN_TIME 5000 // ms spent listening before transmitting
+#endif
+
+#ifndef RADIO_MANAGER_RATE_UP_FRAGMENTS
+    #define RADIO_MANAGER_RATE_UP_FRAGMENTS 64 // Fragments sent with at most 1 retransmission before trying a faster rate
+#endif
+
+#ifndef RADIO_MANAGER_RATE_DOWN_RETRIES
+    #define RADIO_MANAGER_RATE_DOWN_RETRIES 4 // Average retransmissions per fragment above which the rate steps down
+#endif
+
+#ifndef RADIO_MANAGER_POWER_DOWN_FRAGMENTS
+    #define RADIO_MANAGER_POWER_DOWN_FRAGMENTS 32 // Fragments sent without retransmission before lowering the PA level
+#endif
+
+#ifndef RADIO_MANAGER_POWER_UP_RETRIES
+    #define RADIO_MANAGER_POWER_UP_RETRIES 3 // Retransmissions of a fragment that raise the PA level
+#endif
+
+#ifndef RADIO_MANAGER_DATA_CHANNEL
+    #define RADIO_MANAGER_DATA_CHANNEL 108 // Pairing channel, and data channel until another one is selected
+#endif
+
+#ifndef RADIO_MANAGER_CONFIG_CHANNEL
+    #define RADIO_MANAGER_CONFIG_CHANNEL 109 // Rendezvous channel of peers that lost each other after a channel change
+#endif
+
+#ifndef RADIO_MANAGER_RENDEZVOUS_TIMEOUT
+    #define RADIO_MANAGER_RENDEZVOUS_TIMEOUT 60000 // ms without any frame exchanged before returning to the rendezvous channel
+#endif
+
+#ifndef RADIO_MANAGER_HOP_SLOT
+    #define RADIO_MANAGER_HOP_SLOT 50 // ms spent on each channel of the hop sequence
+#endif
+
+#ifndef RADIO_MANAGER_HOP_FIRST_CHANNEL
+    #define RADIO_MANAGER_HOP_FIRST_CHANNEL 2 // First RF channel of the hopping band
+#endif
+
+#ifndef RADIO_MANAGER_HOP_CHANNELS
+    #define RADIO_MANAGER_HOP_CHANNELS 79 // Number of RF channels of the hopping band (2-80 by default)
+#endif
+
+#ifndef RADIO_MANAGER_LBT_SLOT
+    #define RADIO_MANAGER_LBT_SLOT 1000 // us, unit of the random backoff when the channel is busy (about one fragment and its ack at 250 kbps)
+#endif
+
+#ifndef RADIO_MANAGER_LBT_MAX_EXPONENT
+    #define RADIO_MANAGER_LBT_MAX_EXPONENT 5 // Backoff drawn in [1, 2^exponent] slots, the exponent grows with each busy check up to this
+#endif
+
+#ifndef RADIO_MANAGER_LBT_MAX_ATTEMPTS
+    #define RADIO_MANAGER_LBT_MAX_ATTEMPTS 6 // Busy checks before sending anyway
+#endif
+
+#ifndef RADIO_MANAGER_TDMA_SLOT
+    #define RADIO_MANAGER_TDMA_SLOT 20 // ms per TDMA slot, a frame has a beacon slot and one slot per paired node
+#endif
+
+#ifndef RADIO_MANAGER_TDMA_GUARD
+    #define RADIO_MANAGER_TDMA_GUARD 2 // ms at the end of a slot in which no fragment is started
+#endif
+
+#ifndef RADIO_MANAGER_CREDIT_PROBE_INTERVAL
+    #define RADIO_MANAGER_CREDIT_PROBE_INTERVAL 50 // ms between the credit queries of a sender waiting for room at the receiver
+#endif
+
+#ifndef RADIO_MANAGER_CREDIT_TIMEOUT
+    #define RADIO_MANAGER_CREDIT_TIMEOUT 5000 // ms a message waits for credits before it is aborted
+#endif
+
+#ifndef RADIO_MANAGER_STREAM_BLOCK
+    #define RADIO_MANAGER_STREAM_BLOCK 4 // Stream records per parity frame, one lost record per block is rebuilt
+#endif
+
+#ifndef RADIO_MANAGER_HOP_SYNC_INTERVAL
+    #define RADIO_MANAGER_HOP_SYNC_INTERVAL 10000 // ms between the slot counter updates sent to each peer
+#endif
+
+/**
+ * @brief Sizes and timings of RadioManager, resolved at compile time
+ *
+ * Every value comes from the RADIO_MANAGER_* macros above, so a firmware sizes the library
+ * from its build_flags. The message buffers (mailboxes, reassembly buffers and the outgoing
+ * message) dominate the footprint, they are carved from a pool of POOL_BYTES reserved once.
+ */
+struct RadioManagerConfig {
+    static constexpr uint8_t MAX_PEERS = RADIO_MANAGER_MAX_PEERS;
+    static constexpr uint8_t MAILBOX_DEPTH = RADIO_MANAGER_MAILBOX_DEPTH;
+    static constexpr uint16_t MAX_MSG_SIZE = RADIO_MANAGER_MAX_MSG_SIZE;
+    static constexpr uint16_t MAX_PACKETS_RCV = RADIO_MANAGER_MAX_PACKETS_RCV;
+    static constexpr unsigned long RECEIVE_TIMEOUT = RADIO_MANAGER_RECEIVE_TIMEOUT;
+    static constexpr unsigned long PAIRING_TIMEOUT = RADIO_MANAGER_PAIRING_TIMEOUT;
+    static constexpr unsigned long PAIRING_INTERVAL = RADIO_MANAGER_PAIRING_INTERVAL;
+    static constexpr unsigned long PAIRING_LISTEN_TIME = RADIO_MANAGER_PAIRING_LISTEN_TIME;
+    static constexpr uint16_t RATE_UP_FRAGMENTS = RADIO_MANAGER_RATE_UP_FRAGMENTS;
+    static constexpr uint8_t RATE_DOWN_RETRIES = RADIO_MANAGER_RATE_DOWN_RETRIES;
+    static constexpr uint16_t POWER_DOWN_FRAGMENTS = RADIO_MANAGER_POWER_DOWN_FRAGMENTS;
+    static constexpr uint8_t POWER_UP_RETRIES = RADIO_MANAGER_POWER_UP_RETRIES;
+    static constexpr uint8_t DATA_CHANNEL = RADIO_MANAGER_DATA_CHANNEL;
+    static constexpr uint8_t CONFIG_CHANNEL = RADIO_MANAGER_CONFIG_CHANNEL;
+    static constexpr unsigned long RENDEZVOUS_TIMEOUT = RADIO_MANAGER_RENDEZVOUS_TIMEOUT;
+    static constexpr uint16_t HOP_SLOT = RADIO_MANAGER_HOP_SLOT;
+    static constexpr uint8_t HOP_FIRST_CHANNEL = RADIO_MANAGER_HOP_FIRST_CHANNEL;
+    static constexpr uint8_t HOP_CHANNELS = RADIO_MANAGER_HOP_CHANNELS;
+    static constexpr unsigned long HOP_SYNC_INTERVAL = RADIO_MANAGER_HOP_SYNC_INTERVAL;
+    static constexpr uint16_t LBT_SLOT = RADIO_MANAGER_LBT_SLOT;
+    static constexpr uint8_t LBT_MAX_EXPONENT = RADIO_MANAGER_LBT_MAX_EXPONENT;
+    static constexpr uint8_t LBT_MAX_ATTEMPTS = RADIO_MANAGER_LBT_MAX_ATTEMPTS;
+    static constexpr uint8_t TDMA_SLOT = RADIO_MANAGER_TDMA_SLOT;
+    static constexpr uint8_t TDMA_GUARD = RADIO_MANAGER_TDMA_GUARD;
+    static constexpr unsigned long CREDIT_PROBE_INTERVAL = RADIO_MANAGER_CREDIT_PROBE_INTERVAL;
+    static constexpr unsigned long CREDIT_TIMEOUT = RADIO_MANAGER_CREDIT_TIMEOUT;
+    static constexpr uint8_t STREAM_BLOCK = RADIO_MANAGER_STREAM_BLOCK;
+
+    // Radio frame layout
+    static constexpr uint8_t PIPE_COUNT = 5;           // Reading pipes 1-5
+    static constexpr uint8_t PACKET_SIZE = 32;         // nRF24 payload
+    static constexpr uint8_t HEADER_SIZE = 3;          // Code, index
+    static constexpr uint8_t SOURCE_HEADER_SIZE = 4;   // Code, index, source id (gateway peers)
+    static constexpr uint8_t NONCE_SIZE = 12;          // Prepended to encrypted messages
+    static constexpr uint16_t MIN_FRAGMENT_PAYLOAD = PACKET_SIZE - SOURCE_HEADER_SIZE;
+    static constexpr uint16_t MAX_FRAGMENT_PAYLOAD = PACKET_SIZE - HEADER_SIZE;
+    static constexpr uint8_t TDMA_MAX_SLOTS = PACKET_SIZE - HEADER_SIZE - 2; // Nodes listed in a beacon (slot time, count)
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+    static constexpr uint8_t ACK_CREDIT_SIZE = 3;      // Free mailbox slots, free bytes (16 bits)
+#else
+    static constexpr uint8_t ACK_CREDIT_SIZE = 0;
+#endif
+    static constexpr uint8_t ACK_PAYLOAD_SIZE = PACKET_SIZE - 1 - ACK_CREDIT_SIZE; // Application bytes of an ack payload (code, credits)
+    static constexpr uint8_t STREAM_PAYLOAD_SIZE = PACKET_SIZE - SOURCE_HEADER_SIZE - 2; // Bytes of a stream record (length, parity count)
+
+    // Worst-case buffer sizes
+    static constexpr uint32_t MAX_CIPHERTEXT_SIZE = (uint32_t)MAX_MSG_SIZE + NONCE_SIZE;
+    static constexpr uint32_t MAX_RX_MSG_SIZE = (uint32_t)MAX_PACKETS_RCV * MAX_FRAGMENT_PAYLOAD;
+    static constexpr uint32_t PEER_BUFFER_BYTES = (uint32_t)(MAILBOX_DEPTH + 1) * MAX_RX_MSG_SIZE; // Mailbox + reassembly
+    static constexpr uint32_t BUFFER_BYTES = (uint32_t)MAX_PEERS * PEER_BUFFER_BYTES + MAX_CIPHERTEXT_SIZE;
+
+    // Message buffer pool shared by the mailboxes, the reassembly buffers and the outgoing message
+    static constexpr uint16_t POOL_BLOCK_SIZE = RADIO_MANAGER_POOL_BLOCK_SIZE;
+    static constexpr uint32_t RX_MSG_BLOCKS = (MAX_RX_MSG_SIZE + POOL_BLOCK_SIZE - 1) / POOL_BLOCK_SIZE;
+    static constexpr uint32_t TX_MSG_BLOCKS = (MAX_CIPHERTEXT_SIZE + POOL_BLOCK_SIZE - 1) / POOL_BLOCK_SIZE;
+    static constexpr uint32_t PEER_BLOCKS = (uint32_t)(MAILBOX_DEPTH + 1) * RX_MSG_BLOCKS;
+    static constexpr uint32_t WORST_CASE_POOL_BLOCKS = (uint32_t)MAX_PEERS * PEER_BLOCKS + TX_MSG_BLOCKS;
+#ifdef RADIO_MANAGER_POOL_SIZE
+    static constexpr uint32_t POOL_BLOCKS = ((uint32_t)RADIO_MANAGER_POOL_SIZE + POOL_BLOCK_SIZE - 1) / POOL_BLOCK_SIZE;
+#else
+    static constexpr uint32_t POOL_BLOCKS = WORST_CASE_POOL_BLOCKS < 8192 / POOL_BLOCK_SIZE ? WORST_CASE_POOL_BLOCKS : 8192 / POOL_BLOCK_SIZE;
+#endif
+    static constexpr uint32_t POOL_BYTES = POOL_BLOCKS * POOL_BLOCK_SIZE;
+    // Default quota of a peer: its whole mailbox, without taking the room of the outgoing message
+    static constexpr uint32_t PEER_QUOTA_BLOCKS = PEER_BLOCKS < POOL_BLOCKS - TX_MSG_BLOCKS ? PEER_BLOCKS : POOL_BLOCKS - TX_MSG_BLOCKS;
+
+#ifdef RADIO_MANAGER_GATEWAY
+    static_assert(MAX_PEERS >= 1 && MAX_PEERS <= 254, "RADIO_MANAGER_MAX_PEERS must be in [1, 254]");
+#else
+    static_assert(MAX_PEERS >= 1 && MAX_PEERS <= PIPE_COUNT, "RADIO_MANAGER_MAX_PEERS must be in [1, 5] (define RADIO_MANAGER_GATEWAY for more)");
+#endif
+    static_assert(MAILBOX_DEPTH >= 1, "RADIO_MANAGER_MAILBOX_DEPTH must be at least 1");
+    static_assert(MAX_MSG_SIZE >= 1, "RADIO_MANAGER_MAX_MSG_SIZE must be at least 1");
+    static_assert(MAX_PACKETS_RCV >= 1, "RADIO_MANAGER_MAX_PACKETS_RCV must be at least 1");
+    static_assert((uint32_t)MAX_PACKETS_RCV * MIN_FRAGMENT_PAYLOAD >= MAX_CIPHERTEXT_SIZE,
+                  "RADIO_MANAGER_MAX_PACKETS_RCV too small to receive a RADIO_MANAGER_MAX_MSG_SIZE message");
+    static_assert(MAX_RX_MSG_SIZE <= 0xFFFF, "RADIO_MANAGER_MAX_PACKETS_RCV too large (received messages are limited to 64 KB)");
+    static_assert(POOL_BLOCK_SIZE >= 8 && POOL_BLOCK_SIZE <= 1024, "RADIO_MANAGER_POOL_BLOCK_SIZE must be in [8, 1024]");
+    static_assert(POOL_BLOCKS >= TX_MSG_BLOCKS + RX_MSG_BLOCKS && POOL_BLOCKS < 0xFFFF,
+                  "RADIO_MANAGER_POOL_SIZE must hold at least one outgoing and one received message");
+    static_assert(RECEIVE_TIMEOUT > 0, "RADIO_MANAGER_RECEIVE_TIMEOUT must be positive");
+    static_assert(PAIRING_INTERVAL < PAIRING_LISTEN_TIME && PAIRING_LISTEN_TIME < PAIRING_TIMEOUT,
+                  "Pairing timings must satisfy INTERVAL < LISTEN_TIME < TIMEOUT");
+    static_assert(RATE_UP_FRAGMENTS >= 1 && RATE_UP_FRAGMENTS <= 4096, "RADIO_MANAGER_RATE_UP_FRAGMENTS must be in [1, 4096]");
+    static_assert(RATE_DOWN_RETRIES >= 1 && RATE_DOWN_RETRIES <= 15, "RADIO_MANAGER_RATE_DOWN_RETRIES must be in [1, 15] (hardware retries)");
+    static_assert(POWER_DOWN_FRAGMENTS >= 1 && POWER_DOWN_FRAGMENTS <= 4096, "RADIO_MANAGER_POWER_DOWN_FRAGMENTS must be in [1, 4096]");
+    static_assert(POWER_UP_RETRIES >= 1 && POWER_UP_RETRIES <= 15, "RADIO_MANAGER_POWER_UP_RETRIES must be in [1, 15] (hardware retries)");
+    static_assert(DATA_CHANNEL <= 125 && CONFIG_CHANNEL <= 125 && DATA_CHANNEL != CONFIG_CHANNEL,
+                  "RF channels must be distinct and in [0, 125]");
+    static_assert(HOP_SLOT >= 5 && HOP_SLOT < 0xFFFF, "RADIO_MANAGER_HOP_SLOT must be in [5, 65534] ms");
+    static_assert(HOP_CHANNELS >= 1 && HOP_FIRST_CHANNEL + HOP_CHANNELS <= 126, "Hopping band must be within channels [0, 125]");
+    static_assert(CREDIT_PROBE_INTERVAL >= 1 && CREDIT_PROBE_INTERVAL < CREDIT_TIMEOUT,
+                  "RADIO_MANAGER_CREDIT_PROBE_INTERVAL must be shorter than RADIO_MANAGER_CREDIT_TIMEOUT");
+    static_assert(STREAM_BLOCK >= 1 && STREAM_BLOCK <= 8, "RADIO_MANAGER_STREAM_BLOCK must be in [1, 8]");
+    static_assert(MAILBOX_DEPTH < 255, "Mailbox slots are advertised as credits below 255");
+    static_assert(TDMA_SLOT >= 5 && TDMA_GUARD >= 1 && TDMA_GUARD < TDMA_SLOT, "RADIO_MANAGER_TDMA_SLOT must be at least 5 ms, more than RADIO_MANAGER_TDMA_GUARD");
+    static_assert((uint32_t)TDMA_SLOT * (TDMA_MAX_SLOTS + 1) < RECEIVE_TIMEOUT,
+                  "A TDMA frame must be shorter than RADIO_MANAGER_RECEIVE_TIMEOUT (messages span several frames)");
+    static_assert(LBT_SLOT >= 100 && LBT_SLOT <= 10000, "RADIO_MANAGER_LBT_SLOT must be in [100, 10000] us");
+    static_assert(LBT_MAX_EXPONENT >= 1 && LBT_MAX_EXPONENT <= 10, "RADIO_MANAGER_LBT_MAX_EXPONENT must be in [1, 10]");
+    static_assert(LBT_MAX_ATTEMPTS >= 1, "RADIO_MANAGER_LBT_MAX_ATTEMPTS must be at least 1");
+    static_assert(HOP_SYNC_INTERVAL >= HOP_SLOT, "RADIO_MANAGER_HOP_SYNC_INTERVAL must be at least one slot");
+#ifdef RADIO_MANAGER_HEAP_BUDGET
+    static_assert(POOL_BYTES + POOL_BLOCKS * sizeof(uint16_t) <= RADIO_MANAGER_HEAP_BUDGET, "Message buffer pool exceeds RADIO_MANAGER_HEAP_BUDGET");
+#endif
+};
+
+#endif // RADIO_CONFIG_H
@@ -0,0 +1,67 @@
+#ifndef RADIO_FILE_STORAGE_H
+#define RADIO_FILE_STORAGE_H
+
+#include <RadioStore.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+
+/**
+ * @brief RadioStore backend on plain files (Linux/POSIX), for host tests and tools
+ *
+ * Each RadioStorage file is named after a common prefix, e.g. "/tmp/radio.log0".
+ * Appends and writes are flushed and synced before returning.
+ */
+class RadioFileStorage : public RadioStorage {
+public:
+    RadioFileStorage(const char* prefix) {
+        for (uint8_t i = 0; i < FILE_COUNT; i++) {
+            snprintf(paths[i], sizeof(paths[i]), "%s%s", prefix, fileSuffix(i));
+        }
+    }
+
+    size_t read(uint8_t file, uint32_t offset, uint8_t* data, size_t length) override {
+        if (file >= FILE_COUNT) return 0;
+        FILE* f = fopen(paths[file], "rb");
+        if (f == nullptr) return 0;
+        size_t count = (fseek(f, offset, SEEK_SET) == 0) ? fread(data, 1, length, f) : 0;
+        fclose(f);
+        return count;
+    }
+
+    size_t append(uint8_t file, const uint8_t* data, size_t length) override {
+        return file < FILE_COUNT ? writeFile(paths[file], "ab", data, length) : 0;
+    }
+
+    bool write(uint8_t file, const uint8_t* data, size_t length) override {
+        return file < FILE_COUNT && writeFile(paths[file], "wb", data, length) == length;
+    }
+
+    uint32_t size(uint8_t file) override {
+        if (file >= FILE_COUNT) return 0;
+        FILE* f = fopen(paths[file], "rb");
+        if (f == nullptr) return 0;
+        long fileSize = (fseek(f, 0, SEEK_END) == 0) ? ftell(f) : 0;
+        fclose(f);
+        return fileSize > 0 ? fileSize : 0;
+    }
+
+    bool erase(uint8_t file) override {
+        return file < FILE_COUNT && (::remove(paths[file]) == 0 || errno == ENOENT);
+    }
+
+private:
+    char paths[FILE_COUNT][256];
+
+    static size_t writeFile(const char* path, const char* mode, const uint8_t* data, size_t length) {
+        FILE* f = fopen(path, mode);
+        if (f == nullptr) return 0;
+        size_t count = fwrite(data, 1, length, f);
+        fflush(f);
+        fsync(fileno(f));
+        fclose(f);
+        return count;
+    }
+};
+
+#endif // RADIO_FILE_STORAGE_H
@@ -0,0 +1,68 @@
+#ifndef RADIO_FS_STORAGE_H
+#define RADIO_FS_STORAGE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <RadioStore.h>
+
+/**
+ * @brief RadioStore backend on an Arduino file system (SPIFFS, LittleFS...)
+ *
+ * Each RadioStorage file is a small file named after a common prefix, e.g. "/radio.log0".
+ * The file system must be mounted before RadioStore::begin().
+ */
+class RadioFsStorage : public RadioStorage {
+public:
+    RadioFsStorage(fs::FS& fs, const char* prefix = "/radio") : fs(fs) {
+        for (uint8_t i = 0; i < FILE_COUNT; i++) {
+            snprintf(paths[i], sizeof(paths[i]), "%s%s", prefix, fileSuffix(i));
+        }
+    }
+
+    size_t read(uint8_t file, uint32_t offset, uint8_t* data, size_t length) override {
+        if (file >= FILE_COUNT || !fs.exists(paths[file])) return 0;
+        File f = fs.open(paths[file], FILE_READ);
+        if (!f) return 0;
+        size_t count = f.seek(offset) ? f.read(data, length) : 0;
+        f.close();
+        return count;
+    }
+
+    size_t append(uint8_t file, const uint8_t* data, size_t length) override {
+        if (file >= FILE_COUNT) return 0;
+        File f = fs.open(paths[file], FILE_APPEND);
+        if (!f) return 0;
+        size_t count = f.write(data, length);
+        f.close();
+        return count;
+    }
+
+    bool write(uint8_t file, const uint8_t* data, size_t length) override {
+        if (file >= FILE_COUNT) return false;
+        File f = fs.open(paths[file], FILE_WRITE);
+        if (!f) return false;
+        size_t count = f.write(data, length);
+        f.close();
+        return count == length;
+    }
+
+    uint32_t size(uint8_t file) override {
+        if (file >= FILE_COUNT || !fs.exists(paths[file])) return 0;
+        File f = fs.open(paths[file], FILE_READ);
+        if (!f) return 0;
+        uint32_t fileSize = f.size();
+        f.close();
+        return fileSize;
+    }
+
+    bool erase(uint8_t file) override {
+        if (file >= FILE_COUNT) return false;
+        return !fs.exists(paths[file]) || fs.remove(paths[file]);
+    }
+
+private:
+    fs::FS& fs;
+    char paths[FILE_COUNT][32]; // SPIFFS limits paths to 32 characters
+};
+
+#endif // RADIO_FS_STORAGE_H
@@ -0,0 +1,92 @@
+#ifndef RADIO_HOPPER_H
+#define RADIO_HOPPER_H
+
+#include <Arduino.h>
+#include <ChaCha.h>
+
+/**
+ * @brief Pseudo-random hop sequence over a band of RF channels, driven by a slot counter
+ *
+ * The channel of slot n is drawn from the ChaCha keystream of the hop key with n as IV, so
+ * the sequence can't be predicted without the key. Nodes sharing the key and the slot counter
+ * (resync() from the coordinator's time) are on the same channel at the same time. The slot
+ * counter is the time since a common epoch, it wraps with millis() on all nodes alike.
+ */
+class RadioHopper {
+public:
+    static const uint8_t KEY_SIZE = 16;
+
+    RadioHopper(uint8_t firstChannel, uint8_t channelCount, uint16_t slotTime)
+        : firstChannel(firstChannel), channelCount(channelCount), slotTime(slotTime) {
+        clear();
+    }
+
+    // Forget the key and stop hopping
+    void clear() {
+        memset(key, 0, sizeof(key));
+        keySet = false;
+        active = false;
+        epoch = 0;
+        cachedSlot = 0;
+        cachedChannel = 255;
+    }
+
+    void setKey(const uint8_t* newKey) {
+        memcpy(key, newKey, KEY_SIZE);
+        keySet = true;
+        cachedChannel = 255;
+    }
+
+    const uint8_t* getKey() const { return key; }
+    bool hasKey() const { return keySet; }
+
+    // Align the slot counter: slot and elapsed ms in it at the time now (millis())
+    void resync(uint32_t slot, uint16_t elapsed, unsigned long now) {
+        epoch = now - elapsed - slot * (unsigned long)slotTime;
+        active = keySet;
+    }
+
+    // Stop hopping, the key is kept until the next resync
+    void stop() { active = false; }
+
+    bool isActive() const { return active; }
+    uint32_t slotAt(unsigned long now) const { return (now - epoch) / slotTime; }
+    uint16_t elapsedAt(unsigned long now) const { return (now - epoch) % slotTime; }
+    uint8_t channelNow(unsigned long now) { return channelAt(slotAt(now)); }
+
+    /**
+     * @brief Computes the channel of a slot
+     *
+     * @param slot The slot counter
+     * @return The RF channel, in [firstChannel, firstChannel + channelCount)
+     */
+    uint8_t channelAt(uint32_t slot) {
+        if (cachedChannel != 255 && slot == cachedSlot) {
+            return cachedChannel;
+        }
+        uint8_t iv[8] = { (uint8_t)slot, (uint8_t)(slot >> 8), (uint8_t)(slot >> 16), (uint8_t)(slot >> 24) };
+        uint8_t zeros[4] = {};
+        uint8_t stream[4];
+        ChaCha chacha;
+        chacha.setKey(key, KEY_SIZE);
+        chacha.setIV(iv, sizeof(iv));
+        chacha.encrypt(stream, zeros, sizeof(stream));
+        uint32_t random = stream[0] | (stream[1] << 8) | ((uint32_t)stream[2] << 16) | ((uint32_t)stream[3] << 24);
+        cachedSlot = slot;
+        cachedChannel = firstChannel + random % channelCount;
+        return cachedChannel;
+    }
+
+private:
+    const uint8_t firstChannel;
+    const uint8_t channelCount;
+    const uint16_t slotTime;   // ms
+    uint8_t key[KEY_SIZE];
+    bool keySet;
+    bool active;
+    unsigned long epoch;       // millis() at the start of slot 0
+    uint32_t cachedSlot;
+    uint8_t cachedChannel;     // 255 if none
+};
+
+#endif // RADIO_HOPPER_H
@@ -6,9 +6,17 @@
 #include <Base64.h>
 #include <SimpleCha2.h>
 #include <ArduinoJson.h>
+#include <esp_system.h>
+#ifdef RADIO_MANAGER_STATIC_MEMORY
+    #include <Curve25519.h>
+#endif
 
 // #define RADIO_MANAGER_DEBUG // Uncomment to enable serial logs
 
+#if defined(RADIO_MANAGER_DEBUG) && defined(RADIO_MANAGER_STATIC_MEMORY)
+    #warning "RADIO_MANAGER_DEBUG logs allocate Strings, RADIO_MANAGER_STATIC_MEMORY is not heap-free with them"
+#endif
+
 #ifdef RADIO_MANAGER_DEBUG
     #define LOG_(x) Serial.print(x)
     #define LOG_LN(x) Serial.println(x)
@@ -17,6 +25,20 @@
     #define LOG_LN(x)
 #endif
 
+// Binary event trace, enabled with RADIO_MANAGER_TRACE (see RadioConfig.h)
+#ifdef RADIO_MANAGER_TRACE
+    #define TRACE_(event, pipe, fragment, value) trace.record(RadioTrace::event, pipe, fragment, value)
+#else
+    #define TRACE_(event, pipe, fragment, value)
+#endif
+
+// Execution-time profiler, enabled with RADIO_MANAGER_PROFILE (see RadioConfig.h)
+#ifdef RADIO_MANAGER_PROFILE
+    #define PROFILE_SCOPE_(stage) RadioProfiler::Scope profileScope(profiler, stage)
+#else
+    #define PROFILE_SCOPE_(stage)
+#endif
+
 using Bytes = std::vector<uint8_t>;
 
 /**
@@ -25,10 +47,15 @@ using Bytes = std::vector<uint8_t>;
  * @param ce_pin CE pin for the radio module
  * @param csn_pin CSN pin for the radio module
  * @param radio_id Unique identifier for this radio (will be trimmed to 4 characters)
+ * @param allocator Allocator of the message buffers, used in begin() (nullptr: RadioHeapAllocator)
  */
-RadioManager::RadioManager(uint8_t ce_pin, uint8_t csn_pin, const char* radio_id)
+RadioManager::RadioManager(uint8_t ce_pin, uint8_t csn_pin, const char* radio_id, RadioAllocator* allocator)
     : radio(ce_pin, csn_pin), currentState(IDLE),
-      lastPairingAttempt(0), pairingStartTime(0), pairingAttempts(0), tempCha(nullptr), isEnabled(false) {
+      lastPairingAttempt(0), pairingStartTime(0), pairingAttempts(0), tempSharedKey(), pairingCha(tempSharedKey),
+#ifdef RADIO_MANAGER_HOPPING
+      hopper(Config::HOP_FIRST_CHANNEL, Config::HOP_CHANNELS, Config::HOP_SLOT),
+#endif
+      isEnabled(false) {
 
     // Adjust radio_id to ensure it's exactly 4 characters
     String tempID = String(radio_id);
@@ -45,18 +72,96 @@ RadioManager::RadioManager(uint8_t ce_pin, uint8_t csn_pin, const char* radio_id
 
     // Initialize pairedDevices
     for (int i = 0; i < MAX_CHANNELS; i++) {
-        pairedDevices[i].addr = String("");
-        pairedDevices[i].mailbox.clear();
+        pairedDevices[i].addr.clear();
         memset(pairedDevices[i].sharedKey, 0, sizeof(pairedDevices[i].sharedKey));
         memset(pairedDevices[i].publicKey, 0, sizeof(pairedDevices[i].publicKey));
     }
+    globalStats.reset();
+    outgoingChannel = 255;
+#ifdef RADIO_MANAGER_LBT
+    lbtNextTime = 0;
+    lbtAttempts = 0;
+#endif
+#if defined(RADIO_MANAGER_TDMA) || defined(RADIO_MANAGER_FLOW_CONTROL)
+    txListening = false;
+#endif
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+    creditWaiting = false;
+    creditProbing = false;
+    creditUpdated = false;
+    creditWaitStart = 0;
+    creditProbeTime = 0;
+#endif
+    configGeneration = 0;
+    configChangeCallback = nullptr;
+#ifdef RADIO_MANAGER_STREAM
+    streamCallback = nullptr;
+    memset(streamTx, 0, sizeof(streamTx));
+    memset(streamRx, 0, sizeof(streamRx));
+#endif
+#ifndef RADIO_MANAGER_SMALL_NODE
+    pairedDevicesJsonCache[0].valid = false;
+    pairedDevicesJsonCache[1].valid = false;
+#endif
+    captureSink = nullptr;
+    lastTxRetries = 0;
+#ifdef RADIO_MANAGER_TIME_SYNC
+    rxTime = 0;
+#endif
+    writeAddress.clear();
+#ifdef RADIO_MANAGER_ACK_PAYLOAD
+    memset(ackOut, 0, sizeof(ackOut));
+    memset(ackIn, 0, sizeof(ackIn));
+    ackLoadNext = 0;
+#endif
+    listenRate = 0;
+    radioRate = 0;
+    radioPower = RF24_PA_MAX;
+    radioChannel = DATA_CHANNEL;
+    dataChannel = DATA_CHANNEL;
+    agreedChannel = DATA_CHANNEL;
+    previousChannel = DATA_CHANNEL;
+    txChannel = DATA_CHANNEL;
+    lastContactTime = 0;
+#ifdef RADIO_MANAGER_CHANNEL_SCAN
+    scanChannel = 0;
+    scanSweeps = 0;
+    scanSelect = false;
+#endif
+#ifdef RADIO_MANAGER_HOPPING
+    hopCoordinator = HOP_NONE;
+    hopHeardTime = 0;
+    hopSyncNext = 0;
+#endif
+#ifdef RADIO_MANAGER_TDMA
+    tdmaRole = TDMA_NONE;
+    tdmaCoordinator = 255;
+    tdmaSlot = 0;
+    tdmaSlotTime = 0;
+    tdmaFrameTime = 0;
+    tdmaFrameStart = 0;
+    tdmaBeaconTime = 0;
+    tdmaFrameCount = 0;
+#endif
+
+    static RadioHeapAllocator defaultAllocator;
+    this->allocator = allocator ? allocator : &defaultAllocator;
+    poolData = nullptr;
+    poolLinks = nullptr;
 
-    mbedtls_entropy_init(&entropy);
     mbedtls_ctr_drbg_init(&ctr_drbg);
+#ifdef RADIO_MANAGER_SMALL_NODE
+    int (*entropyFunction)(void*, unsigned char*, size_t) = hardwareEntropy;
+    void* entropyContext = nullptr;
+#else
+    mbedtls_entropy_init(&entropy);
+    int (*entropyFunction)(void*, unsigned char*, size_t) = mbedtls_entropy_func;
+    void* entropyContext = &entropy;
+#endif
     
     // Use radioID as part of the personalization string
     String pers = String("radio_manager_") + radioID;
-    if(mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy,
+    if(mbedtls_ctr_drbg_seed(&ctr_drbg, entropyFunction, entropyContext,
                              (const unsigned char *)pers.c_str(), pers.length()) != 0) {
         // Handle initialization error here
     }
@@ -74,6 +179,12 @@ RadioManager::RadioManager(uint8_t ce_pin, uint8_t csn_pin, const char* radio_id
  * @return true if initialization was successful, false otherwise
  */
 bool RadioManager::begin() {
+    if (!allocateBuffers()) {
+        LOG_LN("Message buffer allocation error!");
+        isEnabled = false;
+        return false;
+    }
+
     if (!radio.begin()) {
         LOG_LN("Radio init error!");
         isEnabled = false;
@@ -82,19 +193,63 @@ bool RadioManager::begin() {
     
     isEnabled = true;
     radio.setPALevel(RF24_PA_MAX, true);
-    radio.setDataRate(RF24_250KBPS);
-    radio.setChannel(DATA_CHANNEL);
+    radioPower = RF24_PA_MAX;
+    radio.setDataRate(rateForLevel(0));
+    radioRate = 0;
+    radio.setChannel(dataChannel);
+    radioChannel = dataChannel;
+#if defined(RADIO_MANAGER_TDMA) || defined(RADIO_MANAGER_STREAM)
+    radio.enableDynamicAck(); // Beacons and stream frames are not acknowledged
+#endif
+#ifdef RADIO_MANAGER_ACK_PAYLOAD
+    radio.enableDynamicPayloads(); // On all pipes, ack payloads need them
+    radio.enableAckPayload();
+#endif
     
     for (int i = 0; i < MAX_CHANNELS; i++) {
         if (!pairedDevices[i].addr.isEmpty()) {
-            radio.openReadingPipe(i + 1, (uint8_t*)(String(i) + radioID).c_str());
+            uint8_t pipe = channelPipe(i);
+            uint8_t address[RadioAddress::SIZE];
+            pipeAddress(pipe, address);
+            radio.openReadingPipe(pipe, address);
         }
     }
     
+    setRadioRate(listenRate);
     radio.startListening();
     return true;
 }
 
+/**
+ * @brief Allocates the message buffer pool, once
+ * 
+ * The blocks (message payloads) come from the LARGE tier of the allocator, their links
+ * from the FAST tier. Nothing is allocated afterwards.
+ * 
+ * @return true if the pool is allocated, false if out of memory
+ */
+bool RadioManager::allocateBuffers() {
+    if (poolData != nullptr) {
+        return true;
+    }
+    poolData = static_cast<uint8_t*>(allocator->allocate(Config::POOL_BYTES, RadioAllocator::LARGE));
+    poolLinks = static_cast<uint16_t*>(allocator->allocate(Config::POOL_BLOCKS * sizeof(uint16_t), RadioAllocator::FAST));
+    if (poolData == nullptr || poolLinks == nullptr) {
+        if (poolData) allocator->release(poolData, RadioAllocator::LARGE);
+        if (poolLinks) allocator->release(poolLinks, RadioAllocator::FAST);
+        poolData = nullptr;
+        poolLinks = nullptr;
+        return false;
+    }
+
+    bufferPool.begin(poolData, poolLinks, Config::POOL_BLOCKS);
+    for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+        bufferPool.setQuota(i, Config::PEER_QUOTA_BLOCKS);
+    }
+    bufferPool.setQuota(TX_POOL_OWNER, Config::TX_MSG_BLOCKS);
+    return true;
+}
+
 /**
  * @brief Main function to be called frequently in the program's main loop
  * Manages the different states of the RadioManager
@@ -104,6 +259,14 @@ void RadioManager::loop() {
         return;  // Do nothing if RadioManager is disabled
     }
 
+    PROFILE_SCOPE_(static_cast<RadioProfiler::Stage>(RadioProfiler::LOOP_IDLE + static_cast<uint8_t>(currentState)));
+
+#ifdef RADIO_MANAGER_TDMA
+    if (tdmaRole == TDMA_COORDINATOR && (currentState == IDLE || currentState == TRANSMITTING)) {
+        checkBeacon();
+    }
+#endif
+
     switch (currentState) {
         case PAIRING_LISTEN:
         case PAIRING_TRANSMIT:
@@ -111,18 +274,35 @@ void RadioManager::loop() {
             break;
         case IDLE:
             {
-                delete tempCha;
-                tempCha = nullptr;
                 uint8_t pipe_num;
                 if (radio.available(&pipe_num)) {
                     currentState = RECEIVING;
                     receiveData(pipe_num);
                     LOG_("Radio Packet Received on Pipe ");
                     LOG_LN(pipe_num);
+                } else {
+                    checkRendezvous();
+#ifdef RADIO_MANAGER_HOPPING
+                    checkHopping();
+#endif
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+                    checkRate();
+#endif
                 }
             }
             break;
+        case SCANNING:
+#ifdef RADIO_MANAGER_CHANNEL_SCAN
+            scanStep();
+#endif
+            break;
         case TRANSMITTING:
+#ifdef RADIO_MANAGER_TDMA
+            if (tdmaWindow() == TDMA_WAIT) {
+                waitForSlot();
+                break;
+            }
+#endif
             sendData();
             break;
         case RECEIVING:
@@ -148,6 +328,7 @@ RadioManager::State RadioManager::getCurrentState() {
 bool RadioManager::isBusy() {
     return currentState == PAIRING_LISTEN || 
            currentState == PAIRING_TRANSMIT || 
+           currentState == SCANNING || 
            currentState == TRANSMITTING || 
            currentState == RECEIVING;
 }
@@ -169,7 +350,7 @@ bool RadioManager::isAvailable() {
  */
 uint8_t RadioManager::isMsgAvailable(uint8_t channel) {
     if (channel >= 0 && channel < MAX_CHANNELS && !pairedDevices[channel].addr.isEmpty()) {
-        return pairedDevices[channel].mailbox.size();
+        return pairedDevices[channel].mailboxCount;
     }
     return 0;
 }
@@ -181,9 +362,12 @@ uint8_t RadioManager::isMsgAvailable(uint8_t channel) {
  * @return The read message as a vector of uint8_t, or an empty vector if no message is available
  */
 Bytes RadioManager::readMsg(uint8_t channel) {
-    if (channel >= 0 && channel < MAX_CHANNELS && !pairedDevices[channel].addr.isEmpty() && !pairedDevices[channel].mailbox.empty()) {
-        Bytes msg = pairedDevices[channel].mailbox.front();
-        pairedDevices[channel].mailbox.erase(pairedDevices[channel].mailbox.begin());
+    if (channel >= 0 && channel < MAX_CHANNELS && !pairedDevices[channel].addr.isEmpty() && pairedDevices[channel].mailboxCount > 0) {
+        PairedDevice& device = pairedDevices[channel];
+        const RadioBufferPool::Chain& oldest = device.mailbox[device.mailboxHead];
+        Bytes msg(oldest.length);
+        bufferPool.read(oldest, 0, msg.data(), msg.size());
+        popMailbox(channel);
         LOG_("Message read from mailbox ");
         LOG_LN(channel);
         return msg;
@@ -191,111 +375,188 @@ Bytes RadioManager::readMsg(uint8_t channel) {
     return Bytes();
 }
 
+/**
+ * @brief Reads an available message on a specific channel into a buffer
+ * 
+ * @param channel The channel number to read from
+ * @param buffer Destination buffer
+ * @param size Size of the buffer, at least getMsgSize(channel)
+ * @return The length of the message, or 0 if no message is available or it doesn't fit (message kept)
+ */
+size_t RadioManager::readMsg(uint8_t channel, uint8_t* buffer, size_t size) {
+    size_t length = getMsgSize(channel);
+    if (length == 0 || length > size) {
+        return 0;
+    }
+    PairedDevice& device = pairedDevices[channel];
+    bufferPool.read(device.mailbox[device.mailboxHead], 0, buffer, length);
+    popMailbox(channel);
+    LOG_("Message read from mailbox ");
+    LOG_LN(channel);
+    return length;
+}
+
+/**
+ * @brief Gets the length of the next message available on a specific channel
+ * 
+ * @param channel The channel number to check
+ * @return The length of the message, or 0 if no message is available
+ */
+size_t RadioManager::getMsgSize(uint8_t channel) {
+    if (channel < MAX_CHANNELS && !pairedDevices[channel].addr.isEmpty() && pairedDevices[channel].mailboxCount > 0) {
+        return pairedDevices[channel].mailbox[pairedDevices[channel].mailboxHead].length;
+    }
+    return 0;
+}
+
 /**
  * @brief Sends a message on a specific channel
  * 
  * @param msg The message to send
+ * @param length The length of the message
  * @param channel The channel number on which to send the message
  * @param status Pointer to a variable to track the sending progress (optional) : 0 = in progress, -1 = error, 1 = successful
- * @return true if the sending was successful, false otherwise
+ * @param encryption Whether to encrypt the message (default: false)
+ * @return true if the sending was started, false otherwise
  */
-bool RadioManager::sendMsg(const Bytes& msg, uint8_t channel, uint8_t* status, bool encryption) {
+bool RadioManager::sendMsg(const uint8_t* msg, size_t length, uint8_t channel, uint8_t* status, bool encryption) {
     if (!isEnabled) {
         if (status) *status = -1;
         return false;  // Do not send message if RadioManager is disabled
     }
 
-    if (channel < 0 || channel >= MAX_CHANNELS || pairedDevices[channel].addr.isEmpty()) {
+    if (channel >= MAX_CHANNELS || pairedDevices[channel].addr.isEmpty()) {
         if (status) *status = -1;
         return false;  // Invalid or unpaired channel
     }
-    return sendMsgToAddr(msg, pairedDevices[channel].addr, status, encryption);
+    return startSending(msg, length, pairedDevices[channel].addr, channel, status, encryption);
 }
 
-bool RadioManager::sendMsg(const String& msg, uint8_t channel, uint8_t* status, bool encryption) {
-    if (!isEnabled) {
-        if (status) *status = -1;
-        return false;  // Do not send message if RadioManager is disabled
-    }
+/**
+ * @brief Sends a message on a specific channel
+ * 
+ * @param msg The message to send
+ * @param channel The channel number on which to send the message
+ * @param status Pointer to a variable to track the sending progress (optional) : 0 = in progress, -1 = error, 1 = successful
+ * @return true if the sending was successful, false otherwise
+ */
+bool RadioManager::sendMsg(const Bytes& msg, uint8_t channel, uint8_t* status, bool encryption) {
+    return sendMsg(msg.data(), msg.size(), channel, status, encryption);
+}
 
-    Bytes msgBytes(msg.begin(), msg.end());
-    return sendMsg(msgBytes, channel, status, encryption);
+bool RadioManager::sendMsg(const String& msg, uint8_t channel, uint8_t* status, bool encryption) {
+    return sendMsg(reinterpret_cast<const uint8_t*>(msg.c_str()), msg.length(), channel, status, encryption);
 }
 
 /**
  * @brief Sends a message to a specific device identified by its Addr
  * 
  * @param msg The message to send
+ * @param length The length of the message
  * @param targetAddr The Addr of the target device
  * @param status Pointer to a variable to track the sending progress (optional) : 0 = in progress, -1 = error, 1 = successful
  * @param encryption Whether to encrypt the message (default: false)
  * @return true if the sending was successful, false otherwise
  */
-bool RadioManager::sendMsgToAddr(const Bytes& msg, const String& targetAddr, uint8_t* status, bool encryption) {
+bool RadioManager::sendMsgToAddr(const uint8_t* msg, size_t length, const String& targetAddr, uint8_t* status, bool encryption) {
     if (!isEnabled) {
         if (status) *status = -1;
         return false;  // Do not send message if RadioManager is disabled
     }
 
-    if (currentState != IDLE || msg.size() > MAX_MSG_SIZE) {
+    RadioAddress target;
+    if (!RadioAddress::parse(targetAddr, target)) {
         if (status) *status = -1;
-        return false;
+        return false;  // Invalid address
     }
 
-    currentState = TRANSMITTING;
+    // Find the channel for the target address (for encryption & statistics)
+    return startSending(msg, length, target, findChannel(target), status, encryption);
+}
 
-    // Prepare the message for sending
-    outgoingMsg.clear();
+bool RadioManager::sendMsgToAddr(const Bytes& msg, const String& targetAddr, uint8_t* status, bool encryption) {
+    return sendMsgToAddr(msg.data(), msg.size(), targetAddr, status, encryption);
+}
 
-    if (encryption) {
-        // Find the channel for the target address
-        int targetChannel = -1;
-        for (int i = 0; i < MAX_CHANNELS; i++) {
-            if (pairedDevices[i].addr == targetAddr) {
-                targetChannel = i;
-                break;
-            }
-        }
+bool RadioManager::sendMsgToAddr(const String& msg, const String& targetAddr, uint8_t* status, bool encryption) {
+    return sendMsgToAddr(reinterpret_cast<const uint8_t*>(msg.c_str()), msg.length(), targetAddr, status, encryption);
+}
 
-        if (targetChannel != -1) {
-            outgoingMsg = encryptMessage(targetChannel, msg);
-            LOG_LN("Encrypted message (Base64): " + Base64::encode(outgoingMsg.data(), outgoingMsg.size()));
-        } else {
+/**
+ * @brief Starts sending a message to an address
+ * 
+ * @param msg The message to send
+ * @param length The length of the message
+ * @param target The address of the target device
+ * @param channel The channel of the target device (for encryption & statistics), 255 if not paired
+ * @param status Pointer to a variable to track the sending progress (optional)
+ * @param encryption Whether to encrypt the message
+ * @return true if the sending was started, false otherwise
+ */
+bool RadioManager::startSending(const uint8_t* msg, size_t length, const RadioAddress& target, uint8_t channel, uint8_t* status, bool encryption) {
+    if (currentState != IDLE || length > MAX_MSG_SIZE || (msg == nullptr && length > 0)) {
+        if (status) *status = -1;
+        return false;
+    }
+
+    // Prepare the message for sending
+    bufferPool.release(outgoingMsg);
+    bool stored;
+    if (encryption && channel < MAX_CHANNELS) {
+        stored = encryptMessage(channel, msg, length, outgoingMsg);
+        LOG_LN("Encrypted message: " + String(outgoingMsg.length) + " bytes");
+    } else {
+        if (encryption) {
             LOG_LN("Warning: Target address not found for encryption. Sending unencrypted.");
-            outgoingMsg = msg;
         }
-    } else {
-        outgoingMsg = msg;
+        stored = bufferPool.append(outgoingMsg, TX_POOL_OWNER, msg, length);
+    }
+    if (!stored) {
+        bufferPool.release(outgoingMsg);
+        countDrop(channel, RadioStats::DROP_NO_BUFFER);
+        if (status) *status = -1;
+        LOG_LN("No buffer left for the outgoing message");
+        return false;
     }
 
+    currentState = TRANSMITTING;
+    outgoingChannel = channel;
     outgoingMsgIndex = 0;
-    outgoingTargetAddr = targetAddr;
+    outgoingTargetAddr = target;
+    outgoingStartTime = micros();
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+    creditWaiting = false;
+    creditUpdated = false;
+#endif
+#ifdef RADIO_MANAGER_HOPPING
+    // Devices we coordinate follow the hop sequence once synchronised, the others listen on the data channel
+    bool hopping = hopper.isActive() && (hopCoordinator != HOP_SELF || (channel < MAX_CHANNELS && pairedDevices[channel].hopSynced));
+    txChannel = hopping ? TX_HOP : dataChannel;
+#else
+    txChannel = dataChannel;
+#endif
+#ifdef RADIO_MANAGER_LBT
+    // Random jitter, so that nodes reporting on the same schedule don't sense the channel together
+    lbtAttempts = 0;
+    lbtNextTime = micros() + esp_random() % (4UL * Config::LBT_SLOT);
+#endif
     currentMsgStatus = status;
 
     if (status) *status = 0;  // Initialize status to "in progress"
 
     radio.stopListening();
-    radio.openWritingPipe((uint8_t*)targetAddr.c_str());
+    openWritingPipe(target.bytes());
 
     // Start sending
+    TRACE_(TX_START, target.pipe - '0', 0, outgoingMsg.length);
     sendData();
     LOG_("Start Sending Message to Address ");
-    LOG_LN(targetAddr);
-    LOG_LN("Raw message (Base64): " + Base64::encode(msg.data(), msg.size()));
+    LOG_LN(target.toString());
+    LOG_LN("Raw message (Base64): " + Base64::encode(msg, length));
 
     return true;
 }
 
-bool RadioManager::sendMsgToAddr(const String& msg, const String& targetAddr, uint8_t* status, bool encryption) {
-    if (!isEnabled) {
-        if (status) *status = -1;
-        return false;  // Do not send message if RadioManager is disabled
-    }
-
-    Bytes msgBytes(msg.begin(), msg.end());
-    return sendMsgToAddr(msgBytes, targetAddr, status, encryption);
-}
-
 /**
  * @brief Gets the Addr of the paired device on a specific channel
  * 
@@ -304,7 +565,7 @@ bool RadioManager::sendMsgToAddr(const String& msg, const String& targetAddr, ui
  */
 String RadioManager::getPairedAddr(uint8_t channel) {
     if (channel >= 0 && channel < MAX_CHANNELS) {
-        return pairedDevices[channel].addr;
+        return pairedDevices[channel].addr.toString();
     }
     return "";
 }
@@ -317,7 +578,7 @@ String RadioManager::getPairedAddr(uint8_t channel) {
  */
 String RadioManager::getPairedUID(uint8_t channel) {
     if (channel >= 0 && channel < MAX_CHANNELS) {
-        return pairedDevices[channel].addr.substring(1,5);
+        return pairedDevices[channel].addr.uidToString();
     }
     return "";
 }
@@ -329,15 +590,24 @@ String RadioManager::getPairedUID(uint8_t channel) {
  * @return The pairing channel of the searched UID, or 255 if UID was not found
  */
 uint8_t RadioManager::getPairedChannel(String& uid) {
-    uint8_t ret = 255;
-    for (int i=0 ; i<MAX_CHANNELS ; i++) {
-        String testUID = getPairedUID(i);
-        if (testUID == uid) {
-            ret = i;
-            break;
-        }
+    if (uid.length() != RadioAddress::UID_SIZE) {
+        return 255;
+    }
+    return peerIndex.find(RadioAddress::uidFromChars(uid.c_str()));
+}
+
+/**
+ * @brief Gets the channel of a paired address
+ * 
+ * @param addr The address to search
+ * @return The channel of the address, or 255 if it is not paired
+ */
+uint8_t RadioManager::findChannel(const RadioAddress& addr) {
+    uint8_t channel = peerIndex.find(addr.uid);
+    if (channel < MAX_CHANNELS && pairedDevices[channel].addr == addr) {
+        return channel;
     }
-    return ret;
+    return 255;
 }
 
 /**
@@ -360,20 +630,41 @@ bool RadioManager::setPairedAddr(String& address, uint8_t channel) {
  * @return true if the operation was successful, false otherwise
  */
 bool RadioManager::setPairedAddr(String& address, uint8_t channel, uint8_t* publicKey) {
-    if (channel >= 0 && channel < MAX_CHANNELS) {
+    return pairAddress(address.c_str(), channel, publicKey);
+}
+
+/**
+ * @brief Pairs an address on a specific channel, optionally with its public key
+ * 
+ * @param address The pairing address "<pipe><UID>[:<source id>]"
+ * @param channel The channel number
+ * @param publicKey Pointer to public key (32 bytes), or nullptr
+ * @return true if the operation was successful, false otherwise
+ */
+bool RadioManager::pairAddress(const char* address, uint8_t channel, const uint8_t* publicKey) {
+    if (channel < MAX_CHANNELS) {
         bool hasKey = (publicKey != nullptr);
         uint8_t sharedKey[KEY_SIZE];
         if (hasKey) {
             bool keyGen = generateX25519SharedKey(publicKey, privateKey, sharedKey);
             if (!keyGen) return false;
         }
-        clearPairedAddr(channel);
-        pairedDevices[channel].addr = address;
+        RadioAddress addr;
+        uint8_t sourceId;
+        if (!splitPairingAddr(address, addr, sourceId)) return false;
+        resetChannel(channel);
+        pairedDevices[channel].addr = addr;
+        pairedDevices[channel].sourceId = sourceId;
+        peerIndex.insert(addr.uid, channel);
         if (hasKey) {
             setDevicePublicKey(channel, publicKey);
             setDeviceSharedKey(channel, sharedKey);
         }
-        radio.openReadingPipe(channel + 1, (uint8_t*)(String(channel) + radioID).c_str());
+        uint8_t pipe = channelPipe(channel);
+        uint8_t pipeAddr[RadioAddress::SIZE];
+        pipeAddress(pipe, pipeAddr);
+        radio.openReadingPipe(pipe, pipeAddr);
+        bumpConfigGeneration();
         return true;
     }
     return false;
@@ -399,12 +690,64 @@ bool RadioManager::setPairedAddr(String& address, uint8_t channel, Bytes& public
  */
 void RadioManager::clearPairedAddr(uint8_t channel) {
     if (channel >= 0 && channel < MAX_CHANNELS) {
-        pairedDevices[channel].addr = String("");
-        pairedDevices[channel].mailbox.clear();
+        resetChannel(channel);
+        bumpConfigGeneration();
+    }
+}
+
+/**
+ * @brief Resets a channel to its unpaired state (without notifying a configuration change)
+ * 
+ * @param channel The channel number to reset
+ */
+void RadioManager::resetChannel(uint8_t channel) {
+    if (channel < MAX_CHANNELS) {
+        if (!pairedDevices[channel].addr.isEmpty()) {
+            peerIndex.remove(pairedDevices[channel].addr.uid, channel);
+        }
+        pairedDevices[channel].addr.clear();
+        pairedDevices[channel].sourceId = NO_SOURCE_ID;
+        clearMessages(channel);
+        bufferPool.release(pairedDevices[channel].rxBuffer);
+        pairedDevices[channel].rxDropped = false;
+        pairedDevices[channel].expectedFragments = 0;
+        pairedDevices[channel].receivedFragments = 0;
         memset(pairedDevices[channel].sharedKey, 0, sizeof(pairedDevices[channel].sharedKey));
         memset(pairedDevices[channel].publicKey, 0, sizeof(pairedDevices[channel].publicKey));
         // Reset the chaObject with zeroed sharedKey
         pairedDevices[channel].chaObject.setKey(pairedDevices[channel].sharedKey);
+        pairedDevices[channel].stats.reset();
+        pairedDevices[channel].resetFeatures();
+#ifdef RADIO_MANAGER_STREAM
+        memset(&streamTx[channel], 0, sizeof(streamTx[channel]));
+        memset(&streamRx[channel], 0, sizeof(streamRx[channel]));
+#endif
+#ifdef RADIO_MANAGER_ACK_PAYLOAD
+        ackIn[channel].length = 0;
+        bool loaded = ackOut[channel].loaded;
+        ackOut[channel].length = 0;
+        ackOut[channel].pending = false;
+        ackOut[channel].loaded = false;
+        if (loaded && isEnabled && currentState == IDLE) {
+            loadAckPayloads(true);
+        }
+#endif
+#ifdef RADIO_MANAGER_TDMA
+        if (tdmaRole == TDMA_FOLLOWER && channel == tdmaCoordinator) {
+            stopTdma();
+        }
+#endif
+#ifdef RADIO_MANAGER_HOPPING
+        if (channel == hopCoordinator) {
+            // The coordinator was unpaired, back to the data channel
+            hopper.clear();
+            hopCoordinator = HOP_NONE;
+            if (isEnabled && currentState == IDLE) {
+                setRadioChannel(dataChannel);
+            }
+        }
+#endif
+        updateListenRate();
     }
 }
 
@@ -426,14 +769,14 @@ uint8_t RadioManager::getAvailableChannel() {
  * @brief Initializes the radio module parameters
  */
 void RadioManager::initRadio() {
-    radio.setChannel(DATA_CHANNEL);
-    
     // Open all reading pipes
-    for (int i = 0; i < MAX_CHANNELS; i++) {
-        radio.openReadingPipe(i + 1, (uint8_t*)(String(i+1) + radioID).c_str());
+    for (uint8_t pipe = 1; pipe <= PIPE_COUNT; pipe++) {
+        uint8_t address[RadioAddress::SIZE];
+        pipeAddress(pipe, address);
+        radio.openReadingPipe(pipe, address);
     }
     
-    radio.startListening();
+    resumeListening();
 }
 
 /**
@@ -452,16 +795,18 @@ bool RadioManager::startPairing() {
         isUnpairReq = false;
         memset(tempPublicKey, 0, sizeof(tempPublicKey));
         memset(tempSharedKey, 0, sizeof(tempSharedKey));
-        tempPayload = Bytes();
+        memset(pairingPayload, 0, sizeof(pairingPayload));
         gotPubKey = false;
         sentPubKey = false;
         gotAck = false;
         sentAck = false;
         pairingChannel = getAvailableChannel();
-        radio.setChannel(DATA_CHANNEL);
+        setRadioChannel(DATA_CHANNEL); // Pairing always runs on the default channel, at the slowest rate
+        setRadioRate(0);
         radio.openReadingPipe(1, (uint8_t*)"CFGTX"); 
         radio.startListening();
-        tempCha = new SimpleCha2(tempSharedKey);
+        pairingCha.setKey(tempSharedKey);
+        TRACE_(PAIRING_START, 0, 0, pairingChannel);
 
         return true;
     }
@@ -479,30 +824,29 @@ void RadioManager::handlePairing() {
             // STEP 1: WAIT FOR PUB KEY
             if (radio.available() && !gotPubKey) {
                 uint8_t receivedData[KEY_SIZE];
-                radio.read(receivedData, sizeof(receivedData));
+                readFrame(receivedData, sizeof(receivedData), 1);
                 memcpy(tempPublicKey, receivedData, sizeof(receivedData));
-                String asciiPubKey = Base64::encode(tempPublicKey, sizeof(tempPublicKey));
-                LOG_LN("L1: Received Public Key " + asciiPubKey);
+                LOG_LN("L1: Received Public Key " + Base64::encode(tempPublicKey, sizeof(tempPublicKey)));
                 gotPubKey = true;
                 // Generate Shared Secret
                 generateX25519SharedKey(tempPublicKey, privateKey, tempSharedKey);
-                String asciiSharedKey = Base64::encode(tempSharedKey, sizeof(tempSharedKey));
-                tempCha->setKey(tempSharedKey);
-                LOG_LN("L1: Generated Shared Key " + asciiSharedKey);
+                pairingCha.setKey(tempSharedKey);
+                LOG_LN("L1: Generated Shared Key " + Base64::encode(tempSharedKey, sizeof(tempSharedKey)));
+                TRACE_(PAIRING_STEP, 0, 1, 1);
             } 
 
             // STEP 2: SEND PUB KEY, WAIT FOR PAIRING ADDRESS
             if (gotPubKey && !sentPubKey && (currentTime - lastPairingAttempt) > PAIRING_INTERVAL) {
                 lastPairingAttempt = currentTime;
                 radio.stopListening();
-                radio.openWritingPipe((uint8_t*)"CFGRX");
-                String asciiPubKey = Base64::encode(publicKey, sizeof(publicKey));
-                if (radio.write(publicKey, sizeof(publicKey))) { 
-                    LOG_LN("L2: Sent Public Key " + asciiPubKey + " OK");
-                    sentPubKey = true;
+                openWritingPipe((uint8_t*)"CFGRX");
+                sentPubKey = writeFrame(publicKey, sizeof(publicKey), 0);
+                TRACE_(PAIRING_STEP, 0, 2, sentPubKey);
+                if (sentPubKey) { 
+                    LOG_LN("L2: Sent Public Key " + Base64::encode(publicKey, sizeof(publicKey)) + " OK");
                 }
                 else { 
-                    LOG_LN("L2: Sent Public Key " + asciiPubKey + " unreceived"); 
+                    LOG_LN("L2: Sent Public Key " + Base64::encode(publicKey, sizeof(publicKey)) + " unreceived"); 
                 }
                 radio.openReadingPipe(1, (uint8_t*)"CFGTX");
                 radio.startListening();
@@ -511,41 +855,35 @@ void RadioManager::handlePairing() {
             // STEP 3: WAIT FOR PAIRING ADDRESS, DECRYPT AND CHECK VALIDITY
             if (sentPubKey && !gotAck && radio.available()) {
                 // Wait for ACK return and check validity
-                uint8_t packetSize = radio.getPayloadSize();
-                Bytes packet(packetSize);
-                LOG_LN("RECEIVED PACKET SIZE: "+String(packetSize));
-                radio.read(packet.data(), packetSize);
-                unpad(packet);
-                String cipheredAck = Base64::encode(packet);
-                LOG_LN("L3: Received Ciphered Ack " + cipheredAck);
-                String receivedAddr = tempCha->decryptToStr(packet);
-                LOG_LN("L3: Unciphered Ack = " + receivedAddr);
-                if (checkValidAddr(receivedAddr)) {
+                char receivedAddr[PAIRING_ID_SIZE];
+                bool validAddr = readPairingAddr(receivedAddr);
+                LOG_LN("L3: Unciphered Ack = " + String(receivedAddr));
+                TRACE_(PAIRING_STEP, 0, 3, validAddr);
+                if (validAddr) {
                     gotAck = true;
-                    // Extract UID and pipe num
-                    String receivedUID = receivedAddr.substring(1, 5);
-                    String receivedPipe = receivedAddr.substring(0, 1);
                     // Check if UID exists in database and must be unpaired
-                    if (clearPairedUID(receivedUID)) {
-                        LOG_LN("L3: Address " + receivedAddr + " successfully unpaired.");
+                    if (unpairUID(RadioAddress::uidFromChars(receivedAddr + 1))) {
+                        LOG_LN("L3: Address " + String(receivedAddr) + " successfully unpaired.");
                         isUnpairReq = true;
                     }
                     // If received unknown addr starting with 0, exit pairing
-                    else if (receivedPipe == "0") {
-                        LOG_LN("L3: Received invalid Unpair request from unknown Address " + receivedAddr + ", pairing aborted.");
+                    else if (receivedAddr[0] == '0') {
+                        LOG_LN("L3: Received invalid Unpair request from unknown Address " + String(receivedAddr) + ", pairing aborted.");
+                        TRACE_(PAIRING_ABORT, 0, 3, 1);
                         currentState = IDLE;
                         initRadio();
                         return;
                     }
                     // Otherwise, pair the received address on the available channel if we have room
                     else if (pairingChannel < MAX_CHANNELS) {
-                        setPairedAddr(receivedAddr, pairingChannel, tempPublicKey);
-                        LOG_LN("L3: Received Valid ACK from Address " + receivedAddr);
+                        pairAddress(receivedAddr, pairingChannel, tempPublicKey);
+                        LOG_LN("L3: Received Valid ACK from Address " + String(receivedAddr));
                         LOG_LN("L3: Paired on Channel " + String(pairingChannel));
                     }
                     // All channels are occupied, we abort pairing
                     else {
                         LOG_LN("L3: All channels occupied, pairing aborted...");
+                        TRACE_(PAIRING_ABORT, 0, 3, 2);
                         currentState = IDLE;
                         initRadio();
                         return;
@@ -560,15 +898,13 @@ void RadioManager::handlePairing() {
             if (gotAck && !sentAck) {
                 lastPairingAttempt = currentTime;
                 radio.stopListening();
-                radio.openWritingPipe((uint8_t*)"CFGRX");
-                uint8_t pipeID = isUnpairReq ? 0 : (pairingChannel + 1);
-                String pairingID = String(pipeID) + radioID;
-                tempPayload = tempCha->encrypt(pairingID);
-                LOG_LN("L4: Unciphered pairing address = " + pairingID);
-                LOG_LN("L4: Ciphered pairing address = " + Base64::encode(tempPayload));
-                pad(tempPayload, MAX_PACKET_SIZE);
-                if (radio.write(tempPayload.data(), tempPayload.size())) { 
+                openWritingPipe((uint8_t*)"CFGRX");
+                size_t payloadSize = encryptPairingID(isUnpairReq);
+                (void)payloadSize; // Only logged
+                LOG_LN("L4: Ciphered pairing address = " + Base64::encode(pairingPayload, payloadSize));
+                if (writeFrame(pairingPayload, MAX_PACKET_SIZE, 0)) { 
                     LOG_LN("L4: Sent ciphered pairing address OK, pairing successful.");
+                    TRACE_(PAIRING_DONE, pairingChannel, 4, !isUnpairReq);
                     sentAck = true;
                     currentState = IDLE;
                     initRadio();
@@ -586,7 +922,7 @@ void RadioManager::handlePairing() {
                 LOG_LN("Switching to Pairing Transmit Mode...");
                 currentState = PAIRING_TRANSMIT;
                 radio.stopListening();
-                radio.openWritingPipe((uint8_t*)"CFGTX");
+                openWritingPipe((uint8_t*)"CFGTX");
                 pairingStartTime = currentTime;
             }
             break;
@@ -596,14 +932,14 @@ void RadioManager::handlePairing() {
             if (!sentPubKey && (currentTime - lastPairingAttempt) > PAIRING_INTERVAL) {
                 lastPairingAttempt = currentTime;
                 radio.stopListening();
-                radio.openWritingPipe((uint8_t*)"CFGTX");
-                String asciiPubKey = Base64::encode(publicKey, sizeof(publicKey));
-                if (radio.write(publicKey, sizeof(publicKey))) { 
-                    LOG_LN("T1: Sent Public Key " + asciiPubKey + " OK");
-                    sentPubKey = true;
+                openWritingPipe((uint8_t*)"CFGTX");
+                sentPubKey = writeFrame(publicKey, sizeof(publicKey), 0);
+                TRACE_(PAIRING_STEP, 0, 1, sentPubKey);
+                if (sentPubKey) { 
+                    LOG_LN("T1: Sent Public Key " + Base64::encode(publicKey, sizeof(publicKey)) + " OK");
                 }
                 else { 
-                    LOG_LN("T1: Sent Public Key " + asciiPubKey + " unreceived"); 
+                    LOG_LN("T1: Sent Public Key " + Base64::encode(publicKey, sizeof(publicKey)) + " unreceived"); 
                 }
                 radio.openReadingPipe(1, (uint8_t*)"CFGRX");
                 radio.startListening();
@@ -612,30 +948,25 @@ void RadioManager::handlePairing() {
             // STEP 2: WAIT FOR PEER PUBLIC KEY
             if (sentPubKey && !gotPubKey && radio.available()) {
                 uint8_t receivedData[KEY_SIZE];
-                radio.read(receivedData, sizeof(receivedData));
+                readFrame(receivedData, sizeof(receivedData), 1);
                 memcpy(tempPublicKey, receivedData, sizeof(receivedData));
-                String asciiPubKey = Base64::encode(tempPublicKey, sizeof(tempPublicKey));
-                LOG_LN("T2: Received Public Key " + asciiPubKey);
+                LOG_LN("T2: Received Public Key " + Base64::encode(tempPublicKey, sizeof(tempPublicKey)));
                 gotPubKey = true;
 
                 // Generate Shared Secret
                 generateX25519SharedKey(tempPublicKey, privateKey, tempSharedKey);
-                String asciiSharedKey = Base64::encode(tempSharedKey, sizeof(tempSharedKey));
-                tempCha->setKey(tempSharedKey);
-                LOG_LN("T2: Generated Shared Key " + asciiSharedKey);
+                pairingCha.setKey(tempSharedKey);
+                LOG_LN("T2: Generated Shared Key " + Base64::encode(tempSharedKey, sizeof(tempSharedKey)));
+                TRACE_(PAIRING_STEP, 0, 2, 1);
 
                 // Compute and encrypt pairing address
-                uint8_t pipeID;
                 if (pairingChannel >= MAX_CHANNELS) { 
                     isUnpairReq = true; 
-                    pipeID = 0; 
                     LOG_LN("T2: Sending Unpair request...");
                 }
-                else if (pairingChannel < MAX_CHANNELS) pipeID = pairingChannel + 1;
-                String pairingID = String(pipeID) + radioID;
-                tempPayload = tempCha->encrypt(pairingID);
-                LOG_LN("T2: Unciphered pairing address = " + pairingID);
-                LOG_LN("T2: Ciphered pairing address = " + Base64::encode(tempPayload));
+                size_t payloadSize = encryptPairingID(isUnpairReq);
+                (void)payloadSize; // Only logged
+                LOG_LN("T2: Ciphered pairing address = " + Base64::encode(pairingPayload, payloadSize));
             }
 
             // STEP 3: SEND ENCRYPTED PAIRING ADDRESS AND WAIT FOR ACKNOWLEDGEMENT
@@ -643,15 +974,15 @@ void RadioManager::handlePairing() {
                 lastPairingAttempt = currentTime;
                 // Send ciphered pairing address in Hex format
                 radio.stopListening();
-                radio.openWritingPipe((uint8_t*)"CFGTX");
-                pad(tempPayload, MAX_PACKET_SIZE);
-                if (radio.write(tempPayload.data(), tempPayload.size())) { 
+                openWritingPipe((uint8_t*)"CFGTX");
+                if (writeFrame(pairingPayload, MAX_PACKET_SIZE, 0)) { 
                     LOG_LN("T3: Sent ciphered pairing address OK");
                     sentAck = true;
                 }
                 else { 
                     LOG_LN("T3: Sent ciphered pairing address, unreceived"); 
                 }
+                TRACE_(PAIRING_STEP, 0, 3, sentAck);
                 radio.openReadingPipe(1, (uint8_t*)"CFGRX");
                 radio.startListening();
             }
@@ -659,22 +990,16 @@ void RadioManager::handlePairing() {
             // STEP 4: DECRYPT ACK, CHECK VALIDITY AND COMPLETE PAIRING
             if (sentAck && !gotAck && radio.available()) {
                 // Wait for ACK return and check validity
-                uint8_t packetSize = radio.getPayloadSize();
-                Bytes packet(packetSize);
-                radio.read(packet.data(), packetSize);
-                unpad(packet);
-                String cipheredAck = Base64::encode(packet);
-                LOG_LN("T4: Received Ciphered Ack " + cipheredAck);
-                String receivedAddr = tempCha->decryptToStr(packet);
-                LOG_LN("T4: Unciphered Ack = " + receivedAddr);
-                if (checkValidAddr(receivedAddr)) {
+                char receivedAddr[PAIRING_ID_SIZE];
+                bool validAddr = readPairingAddr(receivedAddr);
+                LOG_LN("T4: Unciphered Ack = " + String(receivedAddr));
+                TRACE_(PAIRING_STEP, 0, 4, validAddr);
+                if (validAddr) {
                     gotAck = true;
-                    // Extract UID and pipe num
-                    String receivedUID = receivedAddr.substring(1, 5);
-                    String receivedPipe = receivedAddr.substring(0, 1);
                     // If address starting by 0, try to unpair
-                    if (receivedPipe == "0") {
-                        if (clearPairedUID(receivedUID)) {
+                    if (receivedAddr[0] == '0') {
+                        if (unpairUID(RadioAddress::uidFromChars(receivedAddr + 1))) {
+                            TRACE_(PAIRING_DONE, 0, 4, 0);
                             LOG_("T4: Received valid Unpair ACK from Address ");
                             LOG_(receivedAddr);
                             LOG_LN(", pairing successful.");
@@ -690,17 +1015,18 @@ void RadioManager::handlePairing() {
                     }
                     // Unpair request with invalid response
                     else if (isUnpairReq) {
-                        LOG_LN("T4: Received invalid ACK to Unpair request from Address " + receivedAddr + ", pairing aborted");
+                        LOG_LN("T4: Received invalid ACK to Unpair request from Address " + String(receivedAddr) + ", pairing aborted");
                         currentState = IDLE;
                         initRadio();
                         return;
                     }
                     // Otherwise, pair the received address on the available channel
                     else if (!isUnpairReq) {
-                        setPairedAddr(receivedAddr, pairingChannel, tempPublicKey);
-                        LOG_LN("T4: Received Valid ACK from Address " + receivedAddr);
+                        pairAddress(receivedAddr, pairingChannel, tempPublicKey);
+                        LOG_LN("T4: Received Valid ACK from Address " + String(receivedAddr));
                         LOG_LN("T4: Paired on Channel " + String(pairingChannel));
                         LOG_LN("T4: Pairing success!");
+                        TRACE_(PAIRING_DONE, pairingChannel, 4, 1);
                         currentState = IDLE;
                         initRadio();
                         return;
@@ -718,157 +1044,2502 @@ void RadioManager::handlePairing() {
     // If we exceed the pairing timeout, we abort pairing
     if (currentTime - pairingStartTime > PAIRING_TIMEOUT) {
         LOG_LN("Pairing Timeout, Returning Idle...");
+        TRACE_(PAIRING_ABORT, 0, 0, 0);
         currentState = IDLE;
         initRadio();
         return;
     }
 }
 
+/**
+ * @brief Reads and decrypts the pairing address sent by the peer
+ * 
+ * @param address Buffer of PAIRING_ID_SIZE bytes receiving the null-terminated address (empty if undecryptable)
+ * @return true if the address is valid, false otherwise
+ */
+bool RadioManager::readPairingAddr(char* address) {
+    uint8_t packet[NRF_BUF_SIZE];
+    uint8_t packetSize = std::min<uint8_t>(payloadSize(), sizeof(packet));
+    readFrame(packet, packetSize, 1);
+    size_t length = unpad(packet, packetSize);
+    LOG_LN("Received Ciphered Ack " + Base64::encode(packet, length));
+
+    address[0] = '\0';
+    if (length <= SimpleCha2::NONCE_SIZE || length - SimpleCha2::NONCE_SIZE >= PAIRING_ID_SIZE || !pairingCha.beginDecrypt(packet)) {
+        return false;
+    }
+    length -= SimpleCha2::NONCE_SIZE;
+    pairingCha.process(reinterpret_cast<uint8_t*>(address), packet + SimpleCha2::NONCE_SIZE, length);
+    address[length] = '\0';
+    return checkValidAddr(address);
+}
+
+/**
+ * @brief Encrypts our pairing address in pairingPayload, padded to a full packet
+ * 
+ * @param unpair Whether to send an unpair request instead of the address of pairingChannel
+ * @return The length of the ciphertext (nonce included)
+ */
+size_t RadioManager::encryptPairingID(bool unpair) {
+    char pairingID[PAIRING_ID_SIZE];
+    size_t length = formatPairingID(pairingChannel, unpair, pairingID);
+    LOG_LN("Unciphered pairing address = " + String(pairingID));
+    pairingCha.beginEncrypt(pairingPayload);
+    pairingCha.process(pairingPayload + SimpleCha2::NONCE_SIZE, reinterpret_cast<const uint8_t*>(pairingID), length);
+    pad(pairingPayload, SimpleCha2::NONCE_SIZE + length, MAX_PACKET_SIZE);
+    return SimpleCha2::NONCE_SIZE + length;
+}
+
 /**
  * @brief Sends the data
  */
 void RadioManager::sendData() {
-    const uint16_t PAYLOAD_SIZE = MAX_PACKET_SIZE - HEADER_SIZE;
-    size_t msgSize = outgoingMsg.size();
+    PROFILE_SCOPE_(RadioProfiler::SEND_DATA);
+#ifdef RADIO_MANAGER_TDMA
+    if (tdmaWindow() == TDMA_WAIT) {
+        return; // Sent in our slot, see waitForSlot()
+    }
+#endif
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+    if (outgoingMsgIndex == 0 && !waitForCredit()) {
+        return; // No room at the receiver, queried again from loop()
+    }
+#endif
+#if defined(RADIO_MANAGER_TDMA) || defined(RADIO_MANAGER_FLOW_CONTROL)
+    if (txListening) {
+        // Our slot started, or credits came, while we listened
+        radio.stopListening();
+        openWritingPipe(outgoingTargetAddr.bytes());
+        txListening = false;
+    }
+#endif
+#ifdef RADIO_MANAGER_LBT
+    if (outgoingMsgIndex == 0 && !clearToSend()) {
+        return; // Backing off, sensed again from loop()
+    }
+#endif
+    // Peers sharing a pipe at the receiver need our source id in each fragment
+    uint8_t sourceId = outgoingChannel < MAX_CHANNELS ? pairedDevices[outgoingChannel].sourceId : NO_SOURCE_ID;
+    const uint8_t headerSize = (sourceId != NO_SOURCE_ID) ? SOURCE_HEADER_SIZE : HEADER_SIZE;
+    const uint16_t PAYLOAD_SIZE = MAX_PACKET_SIZE - headerSize;
+    size_t msgSize = outgoingMsg.length;
     size_t totalFragments = (msgSize + PAYLOAD_SIZE - 1) / PAYLOAD_SIZE; // Calculate total fragments
 
     if (outgoingMsgIndex < msgSize) {
         size_t remainingSize = msgSize - outgoingMsgIndex;
         size_t packetSize = std::min<size_t>(PAYLOAD_SIZE, remainingSize);
         
-        Bytes packet(MAX_PACKET_SIZE);
         PacketHeader header;
         
         // Prepare the header
         if (outgoingMsgIndex == 0) {
-            header.code = START_CODE;
+            header.code = (sourceId != NO_SOURCE_ID) ? SOURCE_START_CODE : START_CODE;
             header.index = totalFragments - 1; // Start with total fragments - 1
         } else {
-            header.code = CONTINUE_CODE;
+            header.code = (sourceId != NO_SOURCE_ID) ? SOURCE_CONTINUE_CODE : CONTINUE_CODE;
             header.index = (remainingSize <= PAYLOAD_SIZE) ? 0 : (totalFragments - 1 - outgoingMsgIndex / PAYLOAD_SIZE);
         }
         
         // Copy header and data
-        memcpy(packet.data(), &header, HEADER_SIZE);
-        memcpy(packet.data() + HEADER_SIZE, &outgoingMsg[outgoingMsgIndex], packetSize);
+        memcpy(txBuffer, &header, HEADER_SIZE);
+        if (sourceId != NO_SOURCE_ID) {
+            txBuffer[HEADER_SIZE] = sourceId;
+        }
+        bufferPool.read(outgoingMsg, outgoingMsgIndex, txBuffer + headerSize, packetSize);
 
         // Pad the packet to 32 bits
-        pad(packet, MAX_PACKET_SIZE);
+        pad(txBuffer, headerSize + packetSize, MAX_PACKET_SIZE);
         
-        if (!radio.write(packet.data(), HEADER_SIZE + packetSize)) {
+        // Fragments go out at the rate the peer listens at, unknown peers listen at the slowest one
+        setLinkRadio(outgoingChannel);
+        setRadioChannel(txChannel == TX_HOP ? listenChannel() : txChannel);
+        bool sent = writeFrame(txBuffer, headerSize + packetSize, outgoingTargetAddr.pipe - '0');
+        uint8_t retries = lastTxRetries;
+#ifdef RADIO_MANAGER_ADAPTIVE_POWER
+        if (sent) {
+            trackPower(outgoingChannel, retries);
+        } else {
+            // Resend at full power first, a weak link is more likely than a rate change
+            sent = boostPower(outgoingChannel, headerSize + packetSize);
+        }
+#endif
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+        if (sent) {
+            trackRetries(outgoingChannel, lastTxRetries);
+        } else {
+            // The peer may have changed its rate, look for it before giving up
+            sent = probeRate(outgoingChannel, headerSize + packetSize);
+        }
+#endif
+        // Only a device that changed channel can have lost the change, the default
+        // build stays on DATA_CHANNEL and a failed fragment is simply reported
+        bool channelChanged = agreedChannel != DATA_CHANNEL || previousChannel != DATA_CHANNEL;
+#ifdef RADIO_MANAGER_HOPPING
+        channelChanged = channelChanged || hopper.isActive();
+#endif
+        if (!sent && channelChanged) {
+            // The peer may have lost a channel change, look for it on the other known channels
+            sent = fallbackChannel(headerSize + packetSize);
+        }
+        if (sent) {
+            noteContact(outgoingChannel);
+        }
+        RadioStats* peerStats = outgoingChannel < MAX_CHANNELS ? &pairedDevices[outgoingChannel].stats : nullptr;
+        for (RadioStats* stats : { &globalStats, peerStats }) {
+            if (!stats) continue;
+            stats->retries += retries;
+            if (sent) {
+                stats->fragmentsSent++;
+                stats->bytesSent += packetSize;
+            }
+        }
+
+        if (!sent) {
             // Sending failed, we reset
+            TRACE_(TX_FAIL, outgoingTargetAddr.pipe - '0', header.index, outgoingMsgIndex);
+            countDrop(outgoingChannel, RadioStats::DROP_TX_FAILURE);
+            bufferPool.release(outgoingMsg);
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+            adaptRate(outgoingChannel, true);
+#endif
             currentState = IDLE;
-            radio.startListening();
+            resumeListening();
             if (currentMsgStatus) *currentMsgStatus = -1;  // Sending aborted with error
             LOG_LN("Failed to Send Radio Packet...");
             return;
         }
 
+        TRACE_(TX_FRAGMENT, outgoingTargetAddr.pipe - '0', header.index, packetSize);
         outgoingMsgIndex += packetSize;
 
         // If we've sent the entire message, we finish
         if (outgoingMsgIndex >= msgSize) {
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+            if (outgoingChannel < MAX_CHANNELS && !creditUpdated) {
+                // No ack carried credits, count the message ourselves
+                readCredits(outgoingChannel, nullptr);
+            }
+#endif
+            bufferPool.release(outgoingMsg);
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+            adaptRate(outgoingChannel, false);
+#endif
+            if (txChannel != TX_HOP && txChannel != agreedChannel && agreedChannel != DATA_CHANNEL && outgoingChannel < MAX_CHANNELS) {
+                // The device was found on another channel: it missed our last channel change
+                uint8_t length = buildControlFrame(outgoingChannel, CHANNEL_CODE, SOURCE_CHANNEL_CODE, agreedChannel);
+                writeFrame(txBuffer, length, outgoingTargetAddr.pipe - '0');
+            }
             currentState = IDLE;
-            radio.startListening();
+            resumeListening();
             if (currentMsgStatus) *currentMsgStatus = 1;  // Message sent successfully
+            TRACE_(TX_DONE, outgoingTargetAddr.pipe - '0', 0, msgSize);
+            uint32_t latency = micros() - outgoingStartTime;
+            for (RadioStats* stats : { &globalStats, peerStats }) {
+                if (!stats) continue;
+                stats->messagesSent++;
+                stats->sendLatency.add(latency);
+            }
             LOG_("Radio Packet Sent to ");
-            LOG_LN(outgoingTargetAddr);
+            LOG_LN(outgoingTargetAddr.toString());
         }
         // Otherwise, we let the function end and it will be called again in the next loop()
     }
 }
 
+#ifdef RADIO_MANAGER_LBT
 /**
- * @brief Receives data on a specific channel
+ * @brief Senses the channel before the first fragment of a message, and backs off while it is busy
  * 
- * @param pipe_num The channel number on which to receive data
+ * The channel is busy when a carrier above -64 dBm (RPD) is heard. The backoff is drawn in
+ * [1, 2^n] slots of RADIO_MANAGER_LBT_SLOT us, n growing with each busy check up to
+ * RADIO_MANAGER_LBT_MAX_EXPONENT. After RADIO_MANAGER_LBT_MAX_ATTEMPTS busy checks the message
+ * is sent anyway, relying on the hardware retransmissions, whose delay is drawn for each message:
+ * with a delay shared by all nodes, two senders that collide collide again on every retransmission.
+ * The rest of the message follows without sensing: the peer acknowledges each fragment, so the
+ * burst holds the channel.
+ * 
+ * @return true to send now, false while backing off
  */
-void RadioManager::receiveData(uint8_t pipe_num) {
-    if (!isEnabled) {
-        return;  // Do not receive data if RadioManager is disabled
+bool RadioManager::clearToSend() {
+#ifdef RADIO_MANAGER_TDMA
+    if (tdmaWindow() == TDMA_OWN) {
+        return true; // Nobody else sends in our slot
+    }
+#endif
+    if ((long)(micros() - lbtNextTime) < 0) {
+        return false;
+    }
+    setRadioChannel(txChannel == TX_HOP ? listenChannel() : txChannel);
+    radio.startListening();
+    delayMicroseconds(SCAN_DWELL_US);
+    bool busy = radio.testRPD();
+    radio.stopListening();
+    if (!busy || lbtAttempts >= Config::LBT_MAX_ATTEMPTS) {
+        // Senders that collide anyway retransmit after different delays
+        radio.setRetries(ARD_MIN + esp_random() % (16 - ARD_MIN), 15);
+        return true;
     }
 
-    static unsigned long lastReceiveTime = 0;
-    static uint16_t expectedFragments = 0;
-    static uint16_t receivedFragments = 0;
-    uint8_t channel = pipe_num - 1;  // Convert pipe number to channel index
+    lbtAttempts++;
+    uint8_t exponent = std::min<uint8_t>(lbtAttempts, Config::LBT_MAX_EXPONENT);
+    uint32_t backoff = (esp_random() % (1UL << exponent) + 1) * Config::LBT_SLOT;
+    lbtNextTime = micros() + backoff;
+    TRACE_(LBT_BACKOFF, outgoingTargetAddr.pipe - '0', lbtAttempts, backoff);
+    globalStats.channelBusy++;
+    if (outgoingChannel < MAX_CHANNELS) {
+        pairedDevices[outgoingChannel].stats.channelBusy++;
+    }
+    return false;
+}
+#endif
 
-    uint8_t packetSize = radio.getPayloadSize();
-    
-    if (packetSize >= HEADER_SIZE && packetSize <= NRF_BUF_SIZE) {
-        Bytes packet(packetSize);
-        radio.read(packet.data(), packetSize);
-        unpad(packet);
-        
-        PacketHeader header;
-        memcpy(&header, packet.data(), HEADER_SIZE);
-        
-        if (header.code == START_CODE) {
-            // New message, clear everything that came before
-            rxBuffer.clear();
-            expectedFragments = header.index + 1; // Set expected fragments
-            receivedFragments = 0;
-        }
-        
-        // Add the fragment to the buffer
-        if (receivedFragments < MAX_PACKETS_RCV) {
-            rxBuffer.insert(rxBuffer.end(), packet.begin() + HEADER_SIZE, packet.end());
-            lastReceiveTime = millis();
-            receivedFragments++;
-        }
-        
-        // Check if it's the last fragment
-        if (header.index == 0) {
-            if (receivedFragments == expectedFragments) {
-                // Process the complete message
-                if (!pairedDevices[channel].addr.isEmpty()) {
-                    LOG_LN("Received message (Base64): " + Base64::encode(rxBuffer.data(), rxBuffer.size()));
-
-                    // Attempt to decrypt the message
-                    Bytes decryptedData = decryptMessage(channel, rxBuffer);
-                    
-                    Bytes messageToStore;
-                    if (!decryptedData.empty()) {
-                        messageToStore = decryptedData;
-                        LOG_LN("Decrypted message!");
-                    } else {
-                        messageToStore = rxBuffer;
-                        LOG_LN("Message not decrypted (possibly unencrypted)");
-                    }
-                    LOG_LN("Decrypted message (Base64): " + Base64::encode(messageToStore.data(), messageToStore.size()));
-                    LOG_LN("Decrypted message (Str): " + String(messageToStore.data(), messageToStore.size()));
-
-                    if (pairedDevices[channel].mailbox.size() < MAX_MAILBOX_MSG) {
-                        pairedDevices[channel].mailbox.push_back(messageToStore);
-                    } else {
-                        pairedDevices[channel].mailbox.erase(pairedDevices[channel].mailbox.begin());
-                        pairedDevices[channel].mailbox.push_back(messageToStore);
-                    }
-                }
-            } else {
-                LOG_LN("Error: Incomplete message received. Expected " + String(expectedFragments) + " fragments, got " + String(receivedFragments));
-            }
-            
-            // Reset the buffer and counters
-            rxBuffer.clear();
-            expectedFragments = 0;
-            receivedFragments = 0;
-        }
+/**
+ * @brief Writes a frame to the currently opened writing pipe and tees it to the capture sink
+ * 
+ * @param buf Frame data
+ * @param len Frame length
+ * @param pipe Pipe digit of the target address (0 for pairing frames and beacons), for capture only
+ * @param multicast Whether to send the frame without asking for an acknowledgement
+ * @return true if the frame was acknowledged (or sent, for multicast), false otherwise
+ */
+bool RadioManager::writeFrame(const void* buf, uint8_t len, uint8_t pipe, bool multicast) {
+    bool acked = radio.write(buf, len, multicast);
+    lastTxRetries = radio.getARC();
+    if (captureSink) {
+        captureSink->capture(RadioCaptureFrame::TX, pipe, lastTxRetries,
+                             acked ? RadioCaptureFrame::FLAG_ACKED : 0, buf, len);
     }
-    
-    // Check if a partial message has expired
-    if (!rxBuffer.empty() && millis() - lastReceiveTime > RECEIVE_TIMEOUT) {
-        LOG_LN("Error: Message reception timeout. Clearing buffer.");
-        rxBuffer.clear();
-        expectedFragments = 0;
-        receivedFragments = 0;
+#ifdef RADIO_MANAGER_ACK_PAYLOAD
+    if (acked) {
+        readAckPayloads(pipe);
     }
-    
-    currentState = IDLE;
+#endif
+    return acked;
 }
 
 /**
- * @brief Generates an X25519 key pair
+ * @brief Opens the writing pipe, remembering the address to attribute the ack payloads
+ * 
+ * @param address The 5-byte address of the receiver
+ */
+void RadioManager::openWritingPipe(const uint8_t* address) {
+    radio.openWritingPipe(address);
+    memcpy(&writeAddress, address, RadioAddress::SIZE);
+}
+
+/**
+ * @brief Reads the pending frame from the radio and tees it to the capture sink
+ * 
+ * @param buf Destination buffer
+ * @param len Number of bytes to read
+ * @param pipe Pipe the frame was received on, for capture only
+ * @param flags Capture flags (RadioCaptureFrame::Flags)
+ */
+void RadioManager::readFrame(void* buf, uint8_t len, uint8_t pipe, uint8_t flags) {
+    radio.read(buf, len);
+    if (captureSink) {
+        captureSink->capture(RadioCaptureFrame::RX, pipe, 0, flags, buf, len);
+    }
+}
+
+/**
+ * @brief Gets the length of the pending frame
+ * 
+ * @return The payload length, 0 if the frame was corrupted (and flushed)
+ */
+uint8_t RadioManager::payloadSize() {
+#ifdef RADIO_MANAGER_ACK_PAYLOAD
+    return radio.getDynamicPayloadSize();
+#else
+    return radio.getPayloadSize(); // Static payloads, frames are padded
+#endif
+}
+
+/**
+ * @brief Returns to listening at the rate asked by the paired devices
+ */
+void RadioManager::resumeListening() {
+    setRadioChannel(listenChannel());
+    setRadioRate(listenRate);
+    setRadioPower(RF24_PA_MAX); // Auto-acks must reach every device
+    radio.startListening();
+#ifdef RADIO_MANAGER_ACK_PAYLOAD
+    loadAckPayloads(true); // Switching modes flushed them
+#endif
+}
+
+/**
+ * @brief Sets the data rate of the radio, if it changed
+ * 
+ * @param level Rate level (see rateForLevel)
+ */
+void RadioManager::setRadioRate(uint8_t level) {
+    if (level != radioRate && level < RATE_LEVELS) {
+        radio.setDataRate(rateForLevel(level));
+        radioRate = level;
+    }
+}
+
+/**
+ * @brief Sets the PA level of the radio, if it changed
+ * 
+ * @param level PA level (rf24_pa_dbm_e)
+ */
+void RadioManager::setRadioPower(uint8_t level) {
+    if (level != radioPower && level <= RF24_PA_MAX) {
+        radio.setPALevel(level, true);
+        radioPower = level;
+    }
+}
+
+/**
+ * @brief Sets the data rate and PA level used to send to a device
+ * 
+ * Without RADIO_MANAGER_ADAPTIVE_RATE and RADIO_MANAGER_ADAPTIVE_POWER every link uses
+ * the slowest rate and RF24_PA_MAX, which the radio is already set to.
+ * 
+ * @param channel Channel of the device, MAX_CHANNELS or more for an unpaired address
+ */
+void RadioManager::setLinkRadio(uint8_t channel) {
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+    setRadioRate(channel < MAX_CHANNELS ? pairedDevices[channel].txRate : 0);
+#endif
+#ifdef RADIO_MANAGER_ADAPTIVE_POWER
+    setRadioPower(channel < MAX_CHANNELS ? pairedDevices[channel].paLevel : (uint8_t)RF24_PA_MAX);
+#endif
+}
+
+/**
+ * @brief Tunes the radio to an RF channel, if it changed
+ * 
+ * @param rfChannel RF channel (0 to 125)
+ */
+void RadioManager::setRadioChannel(uint8_t rfChannel) {
+    if (rfChannel != radioChannel && rfChannel < RadioChannelScan::CHANNEL_COUNT) {
+        radio.setChannel(rfChannel);
+        radioChannel = rfChannel;
+    }
+}
+
+/**
+ * @brief Writes a control frame for a paired device in txBuffer
+ * 
+ * Control frames reuse the fragment header, with the value in the index field.
+ * 
+ * @param channel The channel of the device
+ * @param code Code of the frame
+ * @param sourceCode Code of the frame for devices that identify us by source id
+ * @param value Value of the frame
+ * @return The length of the frame
+ */
+uint8_t RadioManager::buildControlFrame(uint8_t channel, uint8_t code, uint8_t sourceCode, uint16_t value) {
+    PairedDevice& device = pairedDevices[channel];
+    PacketHeader header;
+    header.code = (device.sourceId != NO_SOURCE_ID) ? sourceCode : code;
+    header.index = value;
+    memcpy(txBuffer, &header, HEADER_SIZE);
+    uint8_t length = HEADER_SIZE;
+    if (device.sourceId != NO_SOURCE_ID) {
+        txBuffer[length++] = device.sourceId;
+    }
+    return length;
+}
+
+/**
+ * @brief Handles a control frame received from a paired device
+ * 
+ * @param channel The channel of the device
+ * @param code Code of the frame (without source id variant)
+ * @param value Value of the frame
+ * @param payload Bytes following the header (and source id)
+ * @param length Number of bytes of the payload
+ */
+void RadioManager::handleControlFrame(uint8_t channel, uint8_t code, uint16_t value, const uint8_t* payload, uint8_t length) {
+    switch (code) {
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+        case RATE_CODE:
+        case SOURCE_RATE_CODE:
+            handleRateFrame(channel, value);
+            break;
+#endif
+        case CHANNEL_CODE:
+        case SOURCE_CHANNEL_CODE:
+            if (value < RadioChannelScan::CHANNEL_COUNT) {
+                agreeChannel(value, 1);
+            }
+            break;
+        case CREDIT_CODE:
+        case SOURCE_CREDIT_CODE:
+            break; // Answered by the ack payload
+#ifdef RADIO_MANAGER_STREAM
+        case STREAM_CODE:
+        case SOURCE_STREAM_CODE:
+            handleStream(channel, value, payload, length);
+            break;
+#endif
+#ifdef RADIO_MANAGER_TIME_SYNC
+        case TIME_CODE:
+        case SOURCE_TIME_CODE:
+            handleTimestamps(channel, value, payload, length);
+            break;
+#endif
+#ifdef RADIO_MANAGER_HOPPING
+        case HOP_KEY_CODE:
+        case SOURCE_HOP_KEY_CODE:
+            handleHopKey(channel, payload, length);
+            break;
+        case HOP_SYNC_CODE:
+        case SOURCE_HOP_SYNC_CODE:
+            handleHopSync(channel, value, payload, length);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Starts a scan of the RF channels
+ * 
+ * Each sweep listens about 170 us on each of the 126 channels and records the channels on
+ * which a carrier above -64 dBm was detected. Sweeps are spread over several loop() calls,
+ * frames sent to us meanwhile are lost. The results are kept until the next scan.
+ * 
+ * @param sweeps Number of sweeps (about 60 ms each)
+ * @param select Whether to move to the quietest channel at the end of the scan (see setDataChannel)
+ * @return true if the scan was started, false if not compiled in, disabled or busy
+ */
+bool RadioManager::startScan(uint8_t sweeps, bool select) {
+#ifdef RADIO_MANAGER_CHANNEL_SCAN
+    if (!isEnabled || currentState != IDLE || sweeps == 0) {
+        return false;
+    }
+    channelScan.reset();
+    scanChannel = 0;
+    scanSweeps = sweeps;
+    scanSelect = select;
+    currentState = SCANNING;
+    radio.stopListening();
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Gets the results of the last channel scan
+ * 
+ * @return The occupancy histogram (getSweeps() is 0 before the first scan, or if not compiled in)
+ */
+const RadioChannelScan& RadioManager::getChannelScan() {
+#ifdef RADIO_MANAGER_CHANNEL_SCAN
+    return channelScan;
+#else
+    static const RadioChannelScan empty;
+    return empty;
+#endif
+}
+
+/**
+ * @brief Moves the data channel and asks every paired device to follow
+ * 
+ * The change is announced to each device on the current channel. Devices that miss it are
+ * found again when sending to them (previous, rendezvous and default channels are tried),
+ * and devices that lose us return to the rendezvous channel (CONFIG_CHANNEL) after
+ * RENDEZVOUS_TIMEOUT without traffic.
+ * 
+ * @param rfChannel The new RF channel (0 to 125)
+ * @return true if the channel was changed, false if invalid, disabled or busy
+ */
+bool RadioManager::setDataChannel(uint8_t rfChannel) {
+    if (!isEnabled || currentState != IDLE || rfChannel >= RadioChannelScan::CHANNEL_COUNT) {
+        return false;
+    }
+    radio.stopListening();
+    for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+        PairedDevice& device = pairedDevices[i];
+        if (device.addr.isEmpty()) {
+            continue;
+        }
+        openWritingPipe(device.addr.bytes());
+        uint8_t length = buildControlFrame(i, CHANNEL_CODE, SOURCE_CHANNEL_CODE, rfChannel);
+        setLinkRadio(i);
+        if (!writeFrame(txBuffer, length, device.addr.pipe - '0')) {
+            LOG_LN("Channel " + String(i) + " missed the RF channel change");
+        }
+    }
+    agreeChannel(rfChannel, 0);
+    resumeListening();
+    return true;
+}
+
+/**
+ * @brief Gets the RF channel we currently listen on
+ * 
+ * @return The RF channel (CONFIG_CHANNEL while waiting for lost peers)
+ */
+uint8_t RadioManager::getDataChannel() {
+    return dataChannel;
+}
+
+#ifdef RADIO_MANAGER_CHANNEL_SCAN
+/**
+ * @brief Scans the next channels of the current sweep, and ends the scan after the last sweep
+ */
+void RadioManager::scanStep() {
+    for (uint8_t i = 0; i < SCAN_CHANNELS_PER_LOOP && scanChannel < RadioChannelScan::CHANNEL_COUNT; i++) {
+        setRadioChannel(scanChannel);
+        radio.startListening();
+        delayMicroseconds(SCAN_DWELL_US);
+        channelScan.record(scanChannel, radio.testRPD());
+        radio.stopListening();
+        scanChannel++;
+    }
+    if (scanChannel < RadioChannelScan::CHANNEL_COUNT) {
+        return;
+    }
+    channelScan.endSweep();
+    scanChannel = 0;
+    if (--scanSweeps > 0) {
+        return;
+    }
+
+    channelScan.finish(millis());
+    uint8_t quietest = channelScan.quietest(CONFIG_CHANNEL);
+    TRACE_(SCAN_DONE, 0, channelScan.getSweeps(), quietest);
+    LOG_LN("Channel scan done, quietest channel " + String(quietest));
+    currentState = IDLE;
+    resumeListening();
+    if (scanSelect) {
+        setDataChannel(quietest);
+    }
+}
+#endif
+
+/**
+ * @brief Records a new agreed data channel and moves to it
+ * 
+ * @param rfChannel The agreed RF channel
+ * @param reason 0 selected, 1 requested by a peer (trace only)
+ */
+void RadioManager::agreeChannel(uint8_t rfChannel, uint8_t reason) {
+    if (rfChannel != agreedChannel) {
+        previousChannel = agreedChannel;
+        agreedChannel = rfChannel;
+        bumpConfigGeneration();
+    }
+    switchChannel(rfChannel, reason);
+}
+
+/**
+ * @brief Moves the listening channel
+ * 
+ * @param rfChannel The new RF channel
+ * @param reason 0 selected, 1 requested by a peer, 3 rendezvous timeout (trace only)
+ */
+void RadioManager::switchChannel(uint8_t rfChannel, uint8_t reason) {
+    if (rfChannel == dataChannel) {
+        return;
+    }
+    TRACE_(CHANNEL_CHANGE, 0, reason, rfChannel);
+    LOG_LN("RF channel " + String(dataChannel) + " -> " + String(rfChannel));
+    dataChannel = rfChannel;
+    setRadioChannel(rfChannel);
+}
+
+/**
+ * @brief Resends the fragment in txBuffer on the other channels the device may listen on
+ * 
+ * The current hop or data channel, then the agreed, previous, rendezvous and default channels
+ * are tried, the rest of the message is sent on the channel where the device answers.
+ * 
+ * @param length Length of the fragment
+ * @return true if the fragment was acknowledged on another channel, false otherwise
+ */
+bool RadioManager::fallbackChannel(uint8_t length) {
+    // The hop channel may have changed while the fragment was retransmitted
+    const uint8_t candidates[] = { listenChannel(), agreedChannel, previousChannel, CONFIG_CHANNEL, DATA_CHANNEL };
+    const uint8_t failedChannel = radioChannel;
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+    setRadioRate(outgoingChannel < MAX_CHANNELS ? pairedDevices[outgoingChannel].txRate : 0);
+#endif
+    for (uint8_t i = 0; i < sizeof(candidates); i++) {
+        bool tried = candidates[i] == failedChannel;
+        for (uint8_t j = 0; j < i && !tried; j++) {
+            tried = candidates[j] == candidates[i];
+        }
+        if (tried) {
+            continue;
+        }
+        setRadioChannel(candidates[i]);
+        if (writeFrame(txBuffer, length, outgoingTargetAddr.pipe - '0')) {
+            if (txChannel == TX_HOP && i == 0) {
+                return true; // Still in sequence, one slot later
+            }
+            TRACE_(CHANNEL_CHANGE, outgoingTargetAddr.pipe - '0', 2, candidates[i]);
+            txChannel = candidates[i];
+#ifdef RADIO_MANAGER_HOPPING
+            if (hopCoordinator == HOP_SELF && outgoingChannel < MAX_CHANNELS) {
+                // The device lost the hop sequence, synchronise it again at the next loop()
+                pairedDevices[outgoingChannel].hopSynced = false;
+                pairedDevices[outgoingChannel].hopSyncTime = millis() - Config::HOP_SYNC_INTERVAL;
+            }
+#endif
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Alternates between the agreed and rendezvous channels while nothing is exchanged
+ * 
+ * Only after a channel change: a device that missed it, or whose peers did, meets them on the
+ * rendezvous channel, where the next message sent re-announces the agreed channel.
+ */
+void RadioManager::checkRendezvous() {
+    if (Config::RENDEZVOUS_TIMEOUT == 0 || agreedChannel == DATA_CHANNEL ||
+        millis() - lastContactTime < Config::RENDEZVOUS_TIMEOUT) {
+        return;
+    }
+#ifdef RADIO_MANAGER_HOPPING
+    if (hopper.isActive()) {
+        return;
+    }
+#endif
+    lastContactTime = millis();
+    switchChannel(dataChannel == CONFIG_CHANNEL ? agreedChannel : CONFIG_CHANNEL, 3);
+}
+
+/**
+ * @brief Records a frame exchanged with a paired device
+ * 
+ * @param channel The channel of the device (ignored if not paired)
+ */
+void RadioManager::noteContact(uint8_t channel) {
+    if (channel >= MAX_CHANNELS) {
+        return;
+    }
+    lastContactTime = millis();
+#ifdef RADIO_MANAGER_HOPPING
+    if (channel == hopCoordinator) {
+        hopHeardTime = lastContactTime;
+    }
+#endif
+}
+
+/**
+ * @brief Gets the channel to listen on: the channel of the current hop slot, or the data channel
+ * 
+ * @return The RF channel
+ */
+uint8_t RadioManager::listenChannel() {
+#ifdef RADIO_MANAGER_HOPPING
+    if (hopper.isActive()) {
+        return hopper.channelNow(millis());
+    }
+#endif
+    return dataChannel;
+}
+
+/**
+ * @brief Starts coordinating the frequency hopping of the paired devices
+ * 
+ * A random hop key is drawn, and sent to each paired device, encrypted with its shared key,
+ * together with our slot counter. Then the devices and us move to the channel of the current
+ * slot every RADIO_MANAGER_HOP_SLOT ms. Devices that don't acknowledge keep being sent messages
+ * on the data channel and get the key again every RADIO_MANAGER_HOP_SYNC_INTERVAL.
+ * 
+ * @return true if the hopping was started, false if not compiled in, disabled, busy, or following another node
+ */
+bool RadioManager::startHopping() {
+#ifdef RADIO_MANAGER_HOPPING
+    if (!isEnabled || currentState != IDLE || (hopCoordinator != HOP_NONE && hopCoordinator != HOP_SELF)) {
+        return false;
+    }
+    uint8_t key[RadioHopper::KEY_SIZE];
+    esp_fill_random(key, sizeof(key));
+    hopper.setKey(key);
+    memset(key, 0, sizeof(key));
+    hopper.resync(0, 0, millis());
+    hopCoordinator = HOP_SELF;
+    for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+        // Synchronise every device from the next loop() calls
+        pairedDevices[i].hopSynced = false;
+        pairedDevices[i].hopSyncTime = millis() - Config::HOP_SYNC_INTERVAL;
+    }
+    TRACE_(HOP_SYNC, 0, 2, 0);
+    setRadioChannel(listenChannel());
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Stops the frequency hopping we coordinate, the devices return to the data channel
+ * 
+ * Devices that miss the stop frame return to it after losing the hop sequence.
+ * 
+ * @return true if the hopping was stopped, false if we don't coordinate it or are busy
+ */
+bool RadioManager::stopHopping() {
+#ifdef RADIO_MANAGER_HOPPING
+    if (hopCoordinator != HOP_SELF || currentState != IDLE) {
+        return false;
+    }
+    radio.stopListening();
+    for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+        PairedDevice& device = pairedDevices[i];
+        if (device.addr.isEmpty() || !device.hopSynced) {
+            continue;
+        }
+        openWritingPipe(device.addr.bytes());
+        setLinkRadio(i);
+        setRadioChannel(listenChannel());
+        writeHopSync(i, true);
+        device.hopSynced = false;
+    }
+    TRACE_(HOP_SYNC, 0, 3, hopper.slotAt(millis()));
+    hopper.clear();
+    hopCoordinator = HOP_NONE;
+    resumeListening();
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Checks if we hop over the RF channels, as coordinator or following one
+ * 
+ * @return true if hopping, false if on the data channel
+ */
+bool RadioManager::isHopping() {
+#ifdef RADIO_MANAGER_HOPPING
+    return hopper.isActive();
+#else
+    return false;
+#endif
+}
+
+#ifdef RADIO_MANAGER_HOPPING
+/**
+ * @brief Follows the hop sequence while idle, and keeps the devices synchronised
+ * 
+ * As coordinator, one device due for synchronisation is handled per call. As follower, the
+ * hopping stops when nothing was exchanged with the coordinator for 3 sync intervals: we wait
+ * on the data channel, where the coordinator looks for devices that don't answer.
+ */
+void RadioManager::checkHopping() {
+    unsigned long now = millis();
+    if (hopCoordinator == HOP_SELF) {
+        for (uint8_t n = 0; n < MAX_CHANNELS; n++) {
+            uint8_t i = (hopSyncNext + n) % MAX_CHANNELS;
+            if (!pairedDevices[i].addr.isEmpty() && now - pairedDevices[i].hopSyncTime >= Config::HOP_SYNC_INTERVAL) {
+                hopSyncNext = (i + 1) % MAX_CHANNELS;
+                syncHopPeer(i);
+                break;
+            }
+        }
+    } else if (hopper.isActive() && now - hopHeardTime > 3 * Config::HOP_SYNC_INTERVAL) {
+        TRACE_(HOP_SYNC, channelPipe(hopCoordinator), 1, hopper.slotAt(now));
+        LOG_LN("Hop sequence lost, back to the data channel");
+        hopper.stop();
+    }
+    setRadioChannel(listenChannel());
+}
+
+/**
+ * @brief Sends the slot counter to a device, and the hop key if it isn't synchronised
+ * 
+ * Synchronised devices are looked for on the hop channel first, then on the data channel.
+ * 
+ * @param channel The channel of the device
+ * @return true if the device is synchronised, false otherwise
+ */
+bool RadioManager::syncHopPeer(uint8_t channel) {
+    PairedDevice& device = pairedDevices[channel];
+    radio.stopListening();
+    openWritingPipe(device.addr.bytes());
+    setLinkRadio(channel);
+    bool synced = false;
+    if (device.hopSynced) {
+        setRadioChannel(listenChannel());
+        synced = writeHopSync(channel, false);
+    }
+    if (!synced) {
+        setRadioChannel(dataChannel);
+        synced = writeHopKey(channel) && writeHopSync(channel, false);
+    }
+    if (synced != device.hopSynced) {
+        TRACE_(HOP_SYNC, channelPipe(channel), synced ? 0 : 1, hopper.slotAt(millis()));
+    }
+    if (synced) {
+        noteContact(channel);
+    }
+    device.hopSynced = synced;
+    device.hopSyncTime = millis();
+    resumeListening();
+    return synced;
+}
+
+/**
+ * @brief Sends the hop key to a device, encrypted with the shared key of the link
+ * 
+ * @param channel The channel of the device
+ * @return true if the frame was acknowledged, false otherwise
+ */
+bool RadioManager::writeHopKey(uint8_t channel) {
+    PairedDevice& device = pairedDevices[channel];
+    uint8_t length = buildControlFrame(channel, HOP_KEY_CODE, SOURCE_HOP_KEY_CODE, 0);
+    device.chaObject.beginEncrypt(txBuffer + length);
+    device.chaObject.process(txBuffer + length + SimpleCha2::NONCE_SIZE, hopper.getKey(), RadioHopper::KEY_SIZE);
+    length += SimpleCha2::NONCE_SIZE + RadioHopper::KEY_SIZE;
+    return writeFrame(txBuffer, length, device.addr.pipe - '0');
+}
+
+/**
+ * @brief Sends our slot counter to a device
+ * 
+ * @param channel The channel of the device
+ * @param stop Whether to ask the device to stop hopping instead
+ * @return true if the frame was acknowledged, false otherwise
+ */
+bool RadioManager::writeHopSync(uint8_t channel, bool stop) {
+    unsigned long now = millis();
+    uint32_t slot = hopper.slotAt(now);
+    uint8_t length = buildControlFrame(channel, HOP_SYNC_CODE, SOURCE_HOP_SYNC_CODE, stop ? HOP_STOP : hopper.elapsedAt(now));
+    memcpy(txBuffer + length, &slot, sizeof(slot));
+    length += sizeof(slot);
+    return writeFrame(txBuffer, length, pairedDevices[channel].addr.pipe - '0');
+}
+
+/**
+ * @brief Stores the hop key sent by a device, which becomes the coordinator we follow
+ * 
+ * The key is used once the slot counter is received.
+ * 
+ * @param channel The channel of the device
+ * @param payload Nonce and encrypted key
+ * @param length Length of the payload
+ */
+void RadioManager::handleHopKey(uint8_t channel, const uint8_t* payload, uint8_t length) {
+    if (hopCoordinator == HOP_SELF || length < SimpleCha2::NONCE_SIZE + RadioHopper::KEY_SIZE) {
+        return;
+    }
+    PairedDevice& device = pairedDevices[channel];
+    if (!device.chaObject.beginDecrypt(payload)) {
+        return; // Replayed frame
+    }
+    uint8_t key[RadioHopper::KEY_SIZE];
+    device.chaObject.process(key, payload + SimpleCha2::NONCE_SIZE, sizeof(key));
+    hopper.stop();
+    hopper.setKey(key);
+    memset(key, 0, sizeof(key));
+    hopCoordinator = channel;
+}
+
+/**
+ * @brief Aligns our slot counter on the coordinator's, or stops hopping
+ * 
+ * The slot counter is taken as of the reception of the frame, so the error is the latency
+ * of loop(), to keep well below RADIO_MANAGER_HOP_SLOT.
+ * 
+ * @param channel The channel of the device
+ * @param elapsed ms elapsed in the slot, HOP_STOP to stop hopping
+ * @param payload Slot counter
+ * @param length Length of the payload
+ */
+void RadioManager::handleHopSync(uint8_t channel, uint16_t elapsed, const uint8_t* payload, uint8_t length) {
+    uint32_t slot;
+    if (channel != hopCoordinator || !hopper.hasKey() || length < sizeof(slot)) {
+        return;
+    }
+    memcpy(&slot, payload, sizeof(slot));
+    if (elapsed == HOP_STOP) {
+        TRACE_(HOP_SYNC, channelPipe(channel), 3, slot);
+        hopper.clear();
+        hopCoordinator = HOP_NONE;
+    } else {
+        if (!hopper.isActive()) {
+            TRACE_(HOP_SYNC, channelPipe(channel), 0, slot);
+        }
+        hopper.resync(slot, elapsed, millis());
+        hopHeardTime = millis();
+    }
+    setRadioChannel(listenChannel());
+}
+#endif
+
+/**
+ * @brief Starts coordinating TDMA: a beacon starts each frame and lists the nodes allowed a slot
+ * 
+ * The frame has our slot (0, after the beacon) then one slot of RADIO_MANAGER_TDMA_SLOT ms per
+ * paired device, in channel order, up to RadioManagerConfig::TDMA_MAX_SLOTS devices. Devices
+ * that call followTdma() send only in their slot, the others keep contending for the channel.
+ * 
+ * @return true if TDMA was started, false if not compiled in, disabled, busy or following another node
+ */
+bool RadioManager::startTdma() {
+#ifdef RADIO_MANAGER_TDMA
+    if (!isEnabled || currentState != IDLE || tdmaRole == TDMA_FOLLOWER) {
+        return false;
+    }
+    tdmaRole = TDMA_COORDINATOR;
+    tdmaSlot = 0;
+    tdmaSlotTime = Config::TDMA_SLOT * 1000UL;
+    tdmaFrameCount = 0;
+    sendBeacon();
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Follows the TDMA frames of a paired device (usually the gateway)
+ * 
+ * Beacons are received on pipe 0. While they are received and list us, messages are only sent
+ * in our slot; otherwise, or 3 frames after the last beacon, they are sent at will.
+ * 
+ * @param channel The channel of the coordinator
+ * @return true if the beacons are listened to, false if not compiled in, disabled, not paired or coordinating
+ */
+bool RadioManager::followTdma(uint8_t channel) {
+#ifdef RADIO_MANAGER_TDMA
+    if (!isEnabled || channel >= MAX_CHANNELS || pairedDevices[channel].addr.isEmpty() || tdmaRole == TDMA_COORDINATOR) {
+        return false;
+    }
+    // Pipe 0 address of the coordinator
+    uint8_t address[RadioAddress::SIZE];
+    address[0] = '0';
+    memcpy(address + 1, &pairedDevices[channel].addr.uid, RadioAddress::UID_SIZE);
+    radio.openReadingPipe(0, address);
+    tdmaRole = TDMA_FOLLOWER;
+    tdmaCoordinator = channel;
+    tdmaSlot = 0;
+    tdmaFrameTime = 0;
+    return true;
+#else
+    (void)channel;
+    return false;
+#endif
+}
+
+/**
+ * @brief Stops coordinating or following TDMA, messages are sent at will again
+ */
+void RadioManager::stopTdma() {
+#ifdef RADIO_MANAGER_TDMA
+    if (tdmaRole == TDMA_FOLLOWER) {
+        radio.closeReadingPipe(0);
+    }
+    tdmaRole = TDMA_NONE;
+    tdmaCoordinator = 255;
+    tdmaSlot = 0;
+    tdmaFrameTime = 0;
+#endif
+}
+
+/**
+ * @brief Gets our TDMA slot
+ * 
+ * @return Our slot in the frame (0 for the coordinator), 255 when messages are sent at will
+ */
+uint8_t RadioManager::getTdmaSlot() {
+#ifdef RADIO_MANAGER_TDMA
+    return tdmaWindow() == TDMA_CONTENTION ? 255 : tdmaSlot;
+#else
+    return 255;
+#endif
+}
+
+#ifdef RADIO_MANAGER_TDMA
+/**
+ * @brief Tells whether the outgoing message may be sent now
+ * 
+ * A fragment isn't started in the last RADIO_MANAGER_TDMA_GUARD ms of the slot, which absorb
+ * the beacon reception latency and the retransmissions.
+ * 
+ * @return TDMA_OWN in our slot, TDMA_WAIT outside of it, TDMA_CONTENTION when not scheduled
+ */
+uint8_t RadioManager::tdmaWindow() {
+    if (tdmaRole == TDMA_NONE || tdmaFrameTime == 0) {
+        return TDMA_CONTENTION;
+    }
+    if (tdmaRole == TDMA_FOLLOWER &&
+        (tdmaSlot == 0 || millis() - tdmaBeaconTime > 3 * (tdmaFrameTime / 1000) + Config::TDMA_SLOT)) {
+        return TDMA_CONTENTION;
+    }
+    uint32_t offset = (micros() - tdmaFrameStart) % tdmaFrameTime;
+    uint32_t start = tdmaSlot * tdmaSlotTime;
+    uint32_t end = start + tdmaSlotTime - Config::TDMA_GUARD * 1000UL;
+    return (offset >= start && offset < end) ? TDMA_OWN : TDMA_WAIT;
+}
+
+/**
+ * @brief Sends the beacon when the current frame is over
+ */
+void RadioManager::checkBeacon() {
+    if (micros() - tdmaFrameStart >= tdmaFrameTime) {
+        sendBeacon();
+    }
+}
+
+/**
+ * @brief Broadcasts the beacon that starts a frame to our pipe 0 address
+ * 
+ * The beacon goes at full power and at the slowest rate our devices listen at. An outgoing
+ * message in progress resumes afterwards.
+ */
+void RadioManager::sendBeacon() {
+    bool listening = currentState == IDLE || txListening; // Listening again afterwards
+    radio.stopListening();
+    uint8_t address[RadioAddress::SIZE];
+    pipeAddress(0, address);
+    openWritingPipe(address);
+
+    PacketHeader header;
+    header.code = BEACON_CODE;
+    header.index = tdmaFrameCount++;
+    memcpy(txBuffer, &header, HEADER_SIZE);
+    uint8_t length = HEADER_SIZE + 2;
+    uint8_t count = 0;
+    uint8_t rate = RATE_LEVELS - 1;
+    for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+        if (pairedDevices[i].addr.isEmpty()) {
+            continue;
+        }
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+        rate = std::min(rate, pairedDevices[i].txRate);
+#else
+        rate = 0;
+#endif
+        if (count < Config::TDMA_MAX_SLOTS) {
+            txBuffer[length++] = i;
+            count++;
+        }
+    }
+    txBuffer[HEADER_SIZE] = Config::TDMA_SLOT;
+    txBuffer[HEADER_SIZE + 1] = count;
+
+    setRadioRate(rate);
+    setRadioPower(RF24_PA_MAX);
+    setRadioChannel(listenChannel());
+    writeFrame(txBuffer, length, 0, true);
+    tdmaFrameStart = micros();
+    tdmaBeaconTime = millis();
+    tdmaFrameTime = (count + 1) * tdmaSlotTime;
+    TRACE_(TDMA_BEACON, 0, count, header.index);
+
+    if (listening) {
+        resumeListening();
+    } else {
+        openWritingPipe(outgoingTargetAddr.bytes());
+    }
+}
+
+/**
+ * @brief Aligns our frame on a beacon of the coordinator and finds our slot in it
+ * 
+ * The frame is taken as starting at the processing of the beacon, the loop() latency
+ * must stay well below RADIO_MANAGER_TDMA_GUARD.
+ * 
+ * @param payload Slot time, number of nodes and their channels at the coordinator
+ * @param length Length of the payload
+ * @param frameCount Frame counter of the coordinator
+ */
+void RadioManager::handleBeacon(const uint8_t* payload, uint8_t length, uint16_t frameCount) {
+    unsigned long now = micros();
+    if (tdmaRole != TDMA_FOLLOWER || length < 2 || payload[0] == 0) {
+        return;
+    }
+    // Our channel at the coordinator: our source id in gateway mode, otherwise the pipe we send to
+    PairedDevice& coordinator = pairedDevices[tdmaCoordinator];
+    uint8_t id = coordinator.sourceId != NO_SOURCE_ID ? coordinator.sourceId : coordinator.addr.pipe - '1';
+    uint8_t count = std::min<uint8_t>(std::min<uint8_t>(payload[1], length - 2), Config::TDMA_MAX_SLOTS);
+    uint8_t slot = 0;
+    for (uint8_t k = 0; k < count; k++) {
+        if (payload[2 + k] == id) {
+            slot = k + 1;
+            break;
+        }
+    }
+    if (slot != tdmaSlot) {
+        TRACE_(TDMA_BEACON, 0, slot, frameCount);
+        LOG_LN("TDMA slot " + String(slot) + " of " + String(count));
+    }
+    tdmaSlot = slot;
+    tdmaSlotTime = payload[0] * 1000UL;
+    tdmaFrameTime = (count + 1) * tdmaSlotTime;
+    tdmaFrameStart = now;
+    tdmaBeaconTime = millis();
+    noteContact(tdmaCoordinator);
+}
+
+/**
+ * @brief Listens while the outgoing message waits for our slot
+ * 
+ * Frames received meanwhile are handled, including the beacons that keep the frame aligned.
+ */
+void RadioManager::waitForSlot() {
+    if (!txListening) {
+        resumeListening();
+        txListening = true;
+    }
+    setRadioChannel(listenChannel());
+    uint8_t pipe_num;
+    if (radio.available(&pipe_num)) {
+        currentState = RECEIVING;
+        receiveData(pipe_num);
+        currentState = TRANSMITTING;
+    }
+}
+#endif
+
+/**
+ * @brief Starts a timestamp exchange with a paired device, to estimate its clock offset and drift
+ * 
+ * The device answers at once with the time it received the request and the time it sent the
+ * answer (NTP-style), which updates the estimate when received by loop(). The accuracy is
+ * limited by the loop() latency of both nodes. Call it periodically (e.g. every minute) to
+ * track the drift.
+ * 
+ * @param channel The channel of the device
+ * @return true if the request was acknowledged, false if not compiled in, disabled, busy or not paired
+ */
+bool RadioManager::syncClock(uint8_t channel) {
+#ifdef RADIO_MANAGER_TIME_SYNC
+    if (!isEnabled || currentState != IDLE || channel >= MAX_CHANNELS || pairedDevices[channel].addr.isEmpty()) {
+        return false;
+    }
+    radio.stopListening();
+    uint32_t t1 = micros();
+    bool sent = writeTimestamps(channel, TIME_REQUEST, &t1, 1);
+    pairedDevices[channel].clockRequest = t1;
+    resumeListening();
+    return sent;
+#else
+    (void)channel;
+    return false;
+#endif
+}
+
+/**
+ * @brief Checks if the clock of a device was estimated
+ * 
+ * @param channel The channel of the device
+ * @return true once a timestamp exchange completed, false otherwise
+ */
+bool RadioManager::isClockSynced(uint8_t channel) {
+#ifdef RADIO_MANAGER_TIME_SYNC
+    return channel < MAX_CHANNELS && pairedDevices[channel].clockValid;
+#else
+    (void)channel;
+    return false;
+#endif
+}
+
+/**
+ * @brief Gets the clock offset of a device at the last exchange
+ * 
+ * @param channel The channel of the device
+ * @return The device micros() minus ours (us), 0 if not estimated
+ */
+int32_t RadioManager::getClockOffset(uint8_t channel) {
+#ifdef RADIO_MANAGER_TIME_SYNC
+    return isClockSynced(channel) ? pairedDevices[channel].clockOffset : 0;
+#else
+    (void)channel;
+    return 0;
+#endif
+}
+
+/**
+ * @brief Gets the clock drift of a device, estimated from two exchanges or more
+ * 
+ * @param channel The channel of the device
+ * @return The rate of the device clock minus ours, in parts per billion
+ */
+int32_t RadioManager::getClockDrift(uint8_t channel) {
+#ifdef RADIO_MANAGER_TIME_SYNC
+    return isClockSynced(channel) ? pairedDevices[channel].clockDrift : 0;
+#else
+    (void)channel;
+    return 0;
+#endif
+}
+
+/**
+ * @brief Gets the round trip of the last timestamp exchange, without the device processing time
+ * 
+ * @param channel The channel of the device
+ * @return The round trip (us), 0 if not estimated
+ */
+uint32_t RadioManager::getClockRoundTrip(uint8_t channel) {
+#ifdef RADIO_MANAGER_TIME_SYNC
+    return isClockSynced(channel) ? pairedDevices[channel].clockRoundTrip : 0;
+#else
+    (void)channel;
+    return 0;
+#endif
+}
+
+/**
+ * @brief Converts a time of our clock to the clock of a device
+ * 
+ * @param channel The channel of the device
+ * @param localMicros Our micros() value
+ * @return The device micros() value at the same time (unchanged if not estimated)
+ */
+uint32_t RadioManager::toPeerMicros(uint8_t channel, uint32_t localMicros) {
+#ifdef RADIO_MANAGER_TIME_SYNC
+    if (!isClockSynced(channel)) {
+        return localMicros;
+    }
+    const PairedDevice& device = pairedDevices[channel];
+    int32_t elapsed = (int32_t)(localMicros - device.clockTime);
+    int64_t correction = (int64_t)elapsed * device.clockDrift / 1000000000LL;
+    return localMicros + device.clockOffset + (int32_t)correction;
+#else
+    (void)channel;
+    return localMicros;
+#endif
+}
+
+/**
+ * @brief Converts a time of the clock of a device to ours, e.g. a timestamp carried in a message
+ * 
+ * @param channel The channel of the device
+ * @param peerMicros The device micros() value
+ * @return Our micros() value at the same time (unchanged if not estimated)
+ */
+uint32_t RadioManager::fromPeerMicros(uint8_t channel, uint32_t peerMicros) {
+    if (!isClockSynced(channel)) {
+        return peerMicros;
+    }
+    // The drift correction is small, computing it from the uncorrected time is enough
+    uint32_t localMicros = peerMicros - getClockOffset(channel);
+    return localMicros - (toPeerMicros(channel, localMicros) - peerMicros);
+}
+
+#ifdef RADIO_MANAGER_TIME_SYNC
+/**
+ * @brief Sends timestamps to a device, the radio must not be listening
+ * 
+ * @param channel The channel of the device
+ * @param kind TIME_REQUEST or TIME_ANSWER
+ * @param stamps Timestamps (micros())
+ * @param count Number of timestamps
+ * @return true if the frame was acknowledged, false otherwise
+ */
+bool RadioManager::writeTimestamps(uint8_t channel, uint16_t kind, const uint32_t* stamps, uint8_t count) {
+    PairedDevice& device = pairedDevices[channel];
+    openWritingPipe(device.addr.bytes());
+    setLinkRadio(channel);
+    setRadioChannel(listenChannel());
+    uint8_t length = buildControlFrame(channel, TIME_CODE, SOURCE_TIME_CODE, kind);
+    memcpy(txBuffer + length, stamps, count * sizeof(uint32_t));
+    length += count * sizeof(uint32_t);
+    if (kind == TIME_ANSWER) {
+        // Time of sending, as late as possible
+        uint32_t t3 = micros();
+        memcpy(txBuffer + length - sizeof(t3), &t3, sizeof(t3));
+    }
+    return writeFrame(txBuffer, length, device.addr.pipe - '0');
+}
+
+/**
+ * @brief Answers a timestamp request, or updates the clock estimate of a device from an answer
+ * 
+ * With t1 (request sent), t2 (received by the device), t3 (answer sent) and t4 (answer received):
+ * offset = ((t2 - t1) + (t3 - t4)) / 2 and round trip = (t4 - t1) - (t3 - t2). The drift is
+ * smoothed from the offset changes between exchanges.
+ * 
+ * @param channel The channel of the device
+ * @param kind TIME_REQUEST or TIME_ANSWER
+ * @param payload Timestamps
+ * @param length Length of the payload
+ */
+void RadioManager::handleTimestamps(uint8_t channel, uint16_t kind, const uint8_t* payload, uint8_t length) {
+    PairedDevice& device = pairedDevices[channel];
+    uint32_t stamps[3];
+    if (kind == TIME_REQUEST && length >= sizeof(uint32_t)) {
+        memcpy(&stamps[0], payload, sizeof(uint32_t));
+        stamps[1] = rxTime;
+        stamps[2] = 0; // Set when sent
+        radio.stopListening();
+        writeTimestamps(channel, TIME_ANSWER, stamps, 3);
+        resumeListening();
+        TRACE_(CLOCK_SYNC, channelPipe(channel), 0, 0);
+        return;
+    }
+    if (kind != TIME_ANSWER || length < sizeof(stamps)) {
+        return;
+    }
+    memcpy(stamps, payload, sizeof(stamps));
+    if (stamps[0] != device.clockRequest) {
+        return; // Not the answer to our last request
+    }
+    uint32_t t4 = rxTime;
+    int32_t offset = ((int32_t)(stamps[1] - stamps[0]) + (int32_t)(stamps[2] - t4)) / 2;
+    uint32_t roundTrip = (t4 - stamps[0]) - (stamps[2] - stamps[1]);
+    // Midpoint of the exchange on our clock
+    uint32_t time = stamps[0] + (t4 - stamps[0]) / 2;
+
+    if (device.clockValid) {
+        int32_t elapsed = (int32_t)(time - device.clockTime);
+        if (elapsed > 1000000) {
+            // Drift measured over this interval, smoothed by 1/4
+            int64_t drift = (int64_t)(offset - device.clockOffset) * 1000000000LL / elapsed;
+            device.clockDrift += (int32_t)((drift - device.clockDrift) / 4);
+        }
+    }
+    device.clockOffset = offset;
+    device.clockTime = time;
+    device.clockRoundTrip = roundTrip;
+    device.clockValid = true;
+    device.clockRequest = 0;
+    TRACE_(CLOCK_SYNC, channelPipe(channel), 1, roundTrip);
+}
+#endif
+
+/**
+ * @brief Queues a payload for the auto-ack of the next frame received from a paired device
+ * 
+ * The reply costs no transmission of its own: it reaches the device when it sends us
+ * anything (message fragment or control frame), which suits sleepy sensors that only
+ * listen right after sending. A new payload replaces the pending one. Devices sharing a
+ * pipe (gateway mode) can't be told apart by the radio before it acks, they are refused.
+ * 
+ * @param channel The channel of the device
+ * @param data The payload (nullptr with length 0 cancels the pending one)
+ * @param length Length of the payload, at most ACK_PAYLOAD_SIZE
+ * @return true if queued, false if not compiled in, too long, not paired or the pipe is shared
+ */
+bool RadioManager::setAckPayload(uint8_t channel, const uint8_t* data, uint8_t length) {
+#ifdef RADIO_MANAGER_ACK_PAYLOAD
+    if (channel >= MAX_CHANNELS || pairedDevices[channel].addr.isEmpty() || length > ACK_PAYLOAD_SIZE || pipeShared(channel)) {
+        return false;
+    }
+    AckPayload& payload = ackOut[channel];
+    bool reload = payload.loaded;
+    payload.loaded = false;
+    payload.pending = length > 0;
+    payload.length = length;
+    memcpy(payload.data, data, length);
+    if (isEnabled && currentState == IDLE) {
+        loadAckPayloads(reload); // Otherwise when listening again
+    }
+    return true;
+#else
+    (void)channel;
+    (void)data;
+    (void)length;
+    return false;
+#endif
+}
+
+/**
+ * @brief Checks if the payload queued for a device is still waiting for a frame of the device
+ * 
+ * @param channel The channel of the device
+ * @return true if not sent yet, false otherwise
+ */
+bool RadioManager::isAckPayloadPending(uint8_t channel) {
+#ifdef RADIO_MANAGER_ACK_PAYLOAD
+    return channel < MAX_CHANNELS && ackOut[channel].pending;
+#else
+    (void)channel;
+    return false;
+#endif
+}
+
+/**
+ * @brief Reads the last payload received with an acknowledgement from a device
+ * 
+ * Only the last one is kept: read it after each message sent to the device.
+ * 
+ * @param channel The channel of the device
+ * @param buffer Destination buffer
+ * @param size Size of the buffer
+ * @return The length of the payload (truncated to size), 0 if none was received since the last read
+ */
+uint8_t RadioManager::readAckPayload(uint8_t channel, uint8_t* buffer, uint8_t size) {
+#ifdef RADIO_MANAGER_ACK_PAYLOAD
+    if (channel >= MAX_CHANNELS || buffer == nullptr) {
+        return 0;
+    }
+    uint8_t length = std::min(ackIn[channel].length, size);
+    memcpy(buffer, ackIn[channel].data, length);
+    ackIn[channel].length = 0;
+    return length;
+#else
+    (void)channel;
+    (void)buffer;
+    (void)size;
+    return 0;
+#endif
+}
+
+/**
+ * @brief Sends a record of the telemetry stream of a paired device, without acknowledgement
+ * 
+ * Records are written at once and never retransmitted: a stream trades completeness for
+ * throughput and freshness. Every RADIO_MANAGER_STREAM_BLOCK records, a parity frame (XOR of
+ * the block) follows, from which the receiver rebuilds one lost record per block. Records
+ * are not encrypted.
+ * 
+ * @param channel The channel of the device
+ * @param data The record
+ * @param length Length of the record, at most STREAM_PAYLOAD_SIZE
+ * @return true if written, false if not compiled in, disabled, busy, too long or not paired
+ */
+bool RadioManager::sendStream(uint8_t channel, const uint8_t* data, uint8_t length) {
+#ifdef RADIO_MANAGER_STREAM
+    if (!isEnabled || currentState != IDLE || channel >= MAX_CHANNELS || pairedDevices[channel].addr.isEmpty() ||
+        length > STREAM_PAYLOAD_SIZE || (data == nullptr && length > 0)) {
+        return false;
+    }
+    StreamTx& tx = streamTx[channel];
+    openStream(channel);
+    uint8_t frameLength = buildControlFrame(channel, STREAM_CODE, SOURCE_STREAM_CODE, (tx.block << 4) | tx.position);
+    txBuffer[frameLength++] = length;
+    memcpy(txBuffer + frameLength, data, length);
+    writeFrame(txBuffer, frameLength + length, pairedDevices[channel].addr.pipe - '0', true);
+
+    tx.parity[0] ^= length;
+    for (uint8_t i = 0; i < length; i++) {
+        tx.parity[1 + i] ^= data[i];
+    }
+    tx.position++;
+    if (tx.position >= Config::STREAM_BLOCK) {
+        writeStreamParity(channel);
+    }
+    resumeListening();
+    globalStats.streamSent++;
+    pairedDevices[channel].stats.streamSent++;
+    return true;
+#else
+    (void)channel;
+    (void)data;
+    (void)length;
+    return false;
+#endif
+}
+
+/**
+ * @brief Sends the parity of the records of the current block now, e.g. at the end of a burst
+ * 
+ * @param channel The channel of the device
+ * @return true if a parity frame was written, false if the block is empty or the stream can't be sent
+ */
+bool RadioManager::flushStream(uint8_t channel) {
+#ifdef RADIO_MANAGER_STREAM
+    if (!isEnabled || currentState != IDLE || channel >= MAX_CHANNELS || pairedDevices[channel].addr.isEmpty() ||
+        streamTx[channel].position == 0) {
+        return false;
+    }
+    openStream(channel);
+    writeStreamParity(channel);
+    resumeListening();
+    return true;
+#else
+    (void)channel;
+    return false;
+#endif
+}
+
+/**
+ * @brief Sets the function called with each stream record received, from loop()
+ * 
+ * @param callback Called with the channel of the sender, the record and its length (nullptr to drop the records)
+ */
+void RadioManager::onStream(StreamCallback callback) {
+#ifdef RADIO_MANAGER_STREAM
+    streamCallback = callback;
+#else
+    (void)callback;
+#endif
+}
+
+#ifdef RADIO_MANAGER_STREAM
+/**
+ * @brief Prepares the radio to write stream frames to a device
+ * 
+ * @param channel The channel of the device
+ */
+void RadioManager::openStream(uint8_t channel) {
+    PairedDevice& device = pairedDevices[channel];
+    radio.stopListening();
+    openWritingPipe(device.addr.bytes());
+    setLinkRadio(channel);
+    setRadioChannel(listenChannel());
+}
+
+/**
+ * @brief Writes the parity frame of the current block and starts the next block
+ * 
+ * The parity frame holds the number of records of the block, then the XOR of their length
+ * byte and data (zero-padded).
+ * 
+ * @param channel The channel of the device
+ */
+void RadioManager::writeStreamParity(uint8_t channel) {
+    StreamTx& tx = streamTx[channel];
+    uint8_t frameLength = buildControlFrame(channel, STREAM_CODE, SOURCE_STREAM_CODE, (tx.block << 4) | STREAM_PARITY);
+    txBuffer[frameLength++] = tx.position;
+    memcpy(txBuffer + frameLength, tx.parity, sizeof(tx.parity));
+    writeFrame(txBuffer, frameLength + sizeof(tx.parity), pairedDevices[channel].addr.pipe - '0', true);
+    tx.block = (tx.block + 1) & STREAM_BLOCK_MASK;
+    tx.position = 0;
+    memset(tx.parity, 0, sizeof(tx.parity));
+}
+
+/**
+ * @brief Handles a stream frame: delivers a record, or rebuilds the one lost record of a block from its parity
+ * 
+ * @param channel The channel of the sender
+ * @param index Block counter (12 bits) and position in the block (4 bits, STREAM_PARITY for parity)
+ * @param payload Length byte and record, or record count and parity
+ * @param length Length of the payload
+ */
+void RadioManager::handleStream(uint8_t channel, uint16_t index, const uint8_t* payload, uint8_t length) {
+    StreamRx& rx = streamRx[channel];
+    uint16_t block = index >> 4;
+    uint8_t position = index & 0x0F;
+    if (length < 1 || (position != STREAM_PARITY && (position >= Config::STREAM_BLOCK || payload[0] > STREAM_PAYLOAD_SIZE ||
+                                                     length < 1 + payload[0]))) {
+        return;
+    }
+    if (!rx.active || block != rx.block) {
+        if (rx.active) {
+            closeStreamBlock(channel, block);
+        }
+        rx.active = true;
+        rx.block = block;
+        rx.received = 0;
+        rx.count = 0;
+    }
+
+    if (position == STREAM_PARITY) {
+        if (rx.count > 0 || length < 1 + STREAM_RECORD_SIZE) {
+            return; // Duplicate, or truncated
+        }
+        rx.count = std::min<uint8_t>(std::max<uint8_t>(payload[0], 1), Config::STREAM_BLOCK);
+        uint8_t missing = ((1 << rx.count) - 1) & ~rx.received;
+        if (missing == 0 || (missing & (missing - 1)) != 0) {
+            return; // Complete, or more than one record lost
+        }
+        uint8_t lost = __builtin_ctz(missing);
+        uint8_t* record = rx.records[lost];
+        memcpy(record, payload + 1, STREAM_RECORD_SIZE);
+        for (uint8_t i = 0; i < rx.count; i++) {
+            if (i == lost) continue;
+            for (uint8_t j = 0; j < STREAM_RECORD_SIZE; j++) {
+                record[j] ^= rx.records[i][j];
+            }
+        }
+        if (record[0] > STREAM_PAYLOAD_SIZE) {
+            return; // Inconsistent block, the sender restarted
+        }
+        rx.received |= missing;
+        TRACE_(STREAM_FEC, channelPipe(channel), 0, block);
+        globalStats.streamRecovered++;
+        pairedDevices[channel].stats.streamRecovered++;
+        if (streamCallback) {
+            streamCallback(channel, record + 1, record[0]);
+        }
+        return;
+    }
+
+    uint8_t bit = 1 << position;
+    if (rx.received & bit) {
+        return;
+    }
+    rx.received |= bit;
+    memset(rx.records[position], 0, STREAM_RECORD_SIZE);
+    memcpy(rx.records[position], payload, 1 + payload[0]);
+    globalStats.streamReceived++;
+    pairedDevices[channel].stats.streamReceived++;
+    if (streamCallback) {
+        streamCallback(channel, payload + 1, payload[0]);
+    }
+}
+
+/**
+ * @brief Counts the records lost in the block being closed and in the blocks skipped before the next one
+ * 
+ * @param channel The channel of the sender
+ * @param nextBlock The block that starts
+ */
+void RadioManager::closeStreamBlock(uint8_t channel, uint16_t nextBlock) {
+    StreamRx& rx = streamRx[channel];
+    // Without parity the block is assumed full (blocks are only cut short by flushStream())
+    uint8_t count = rx.count > 0 ? rx.count : Config::STREAM_BLOCK;
+    uint32_t lost = count - __builtin_popcount(rx.received & ((1 << count) - 1));
+    uint16_t gap = (nextBlock - rx.block) & STREAM_BLOCK_MASK;
+    if (gap > 1 && gap <= STREAM_MAX_GAP) {
+        lost += (uint32_t)(gap - 1) * Config::STREAM_BLOCK;
+    }
+    if (lost > 0) {
+        TRACE_(STREAM_FEC, channelPipe(channel), 1, lost);
+        globalStats.streamLost += lost;
+        pairedDevices[channel].stats.streamLost += lost;
+    }
+}
+#endif
+
+/**
+ * @brief Gets the free mailbox slots last advertised by a device
+ * 
+ * @param channel The channel of the device
+ * @return The number of messages the device can still store from us, CREDIT_UNKNOWN if it didn't advertise it
+ */
+uint8_t RadioManager::getCreditSlots(uint8_t channel) {
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+    return channel < MAX_CHANNELS ? pairedDevices[channel].creditSlots : CREDIT_UNKNOWN;
+#else
+    (void)channel;
+    return CREDIT_UNKNOWN;
+#endif
+}
+
+/**
+ * @brief Gets the free buffer bytes last advertised by a device
+ * 
+ * @param channel The channel of the device
+ * @return The number of message bytes the device can still store from us (valid with getCreditSlots())
+ */
+uint16_t RadioManager::getCreditBytes(uint8_t channel) {
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+    return channel < MAX_CHANNELS ? pairedDevices[channel].creditBytes : 0;
+#else
+    (void)channel;
+    return 0;
+#endif
+}
+
+#ifdef RADIO_MANAGER_ACK_PAYLOAD
+/**
+ * @brief Checks if another paired device sends to the reading pipe of a device (gateway mode)
+ * 
+ * @param channel The channel of the device
+ * @return true if the pipe is shared, false otherwise
+ */
+bool RadioManager::pipeShared(uint8_t channel) {
+    for (uint8_t other = 0; other < MAX_CHANNELS; other++) {
+        if (other != channel && channelPipe(other) == channelPipe(channel) && !pairedDevices[other].addr.isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Loads the ack payloads into the radio, which must be listening
+ * 
+ * Devices are taken in turn, since the TX FIFO only holds ACK_FIFO_SIZE payloads. With flow
+ * control every device on its own pipe has one, holding at least our credits.
+ * 
+ * @param reload Whether to flush the TX FIFO and load all of them again (after switching modes)
+ */
+void RadioManager::loadAckPayloads(bool reload) {
+    uint8_t loaded = 0;
+    if (reload) {
+        radio.flush_tx();
+    }
+    for (uint8_t channel = 0; channel < MAX_CHANNELS; channel++) {
+        if (reload) {
+            ackOut[channel].loaded = false;
+        } else if (ackOut[channel].loaded) {
+            loaded++;
+        }
+    }
+    for (uint8_t i = 0; i < MAX_CHANNELS && loaded < ACK_FIFO_SIZE; i++) {
+        uint8_t channel = (ackLoadNext + i) % MAX_CHANNELS;
+        AckPayload& payload = ackOut[channel];
+        if (payload.loaded || pairedDevices[channel].addr.isEmpty()) {
+            continue;
+        }
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+        if (!payload.pending && pipeShared(channel)) {
+            continue;
+        }
+#else
+        if (!payload.pending) {
+            continue;
+        }
+#endif
+        uint8_t frame[NRF_BUF_SIZE];
+        uint8_t length = buildAckPayload(channel, frame);
+        if (radio.writeAckPayload(channelPipe(channel), frame, length)) {
+            payload.loaded = true;
+            loaded++;
+            ackLoadNext = (channel + 1) % MAX_CHANNELS;
+        }
+    }
+}
+
+/**
+ * @brief Builds the ack payload of a device: code, credits (flow control), application bytes
+ * 
+ * @param channel The channel of the device
+ * @param payload Buffer of NRF_BUF_SIZE bytes
+ * @return The length of the payload
+ */
+uint8_t RadioManager::buildAckPayload(uint8_t channel, uint8_t* payload) {
+    const AckPayload& queued = ackOut[channel];
+    payload[0] = queued.pending ? ACK_DATA_CODE : ACK_CREDIT_CODE;
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+    writeCredits(channel, payload + 1);
+#endif
+    uint8_t length = 1 + ACK_CREDIT_SIZE;
+    if (queued.pending) {
+        memcpy(payload + length, queued.data, queued.length);
+        length += queued.length;
+    }
+    return length;
+}
+
+/**
+ * @brief Drops the ack payload of a pipe after a frame was received on it (it went with the auto-ack)
+ * 
+ * @param pipe The pipe the frame was received on
+ */
+void RadioManager::ackPayloadSent(uint8_t pipe) {
+    for (uint8_t channel = 0; channel < MAX_CHANNELS; channel++) {
+        AckPayload& payload = ackOut[channel];
+        if (payload.loaded && channelPipe(channel) == pipe) {
+            if (payload.pending) {
+                TRACE_(ACK_PAYLOAD, pipe, 0, payload.length);
+                globalStats.ackPayloadsSent++;
+                pairedDevices[channel].stats.ackPayloadsSent++;
+                payload.pending = false;
+                payload.length = 0;
+            }
+            payload.loaded = false;
+            loadAckPayloads(false); // A TX FIFO entry is free, credits are loaded again up to date
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Reads the payloads that came with the acknowledgement of the last frame written
+ * 
+ * @param pipe Pipe digit of the target address, for capture only
+ */
+void RadioManager::readAckPayloads(uint8_t pipe) {
+    uint8_t channel = findChannel(writeAddress);
+    while (radio.available()) {
+        uint8_t length = payloadSize();
+        if (length == 0) {
+            break; // Corrupted, flushed by the radio
+        }
+        uint8_t payload[NRF_BUF_SIZE];
+        readFrame(payload, length, pipe, RadioCaptureFrame::FLAG_ACK_PAYLOAD);
+        if (channel < MAX_CHANNELS && length >= 1 + ACK_CREDIT_SIZE) {
+            handleAckPayload(channel, payload, length);
+        }
+    }
+}
+
+/**
+ * @brief Handles a payload received with an acknowledgement
+ * 
+ * @param channel The channel of the device that acknowledged
+ * @param payload Code, credits (flow control), application bytes
+ * @param length Length of the payload
+ */
+void RadioManager::handleAckPayload(uint8_t channel, const uint8_t* payload, uint8_t length) {
+    if (payload[0] != ACK_DATA_CODE && payload[0] != ACK_CREDIT_CODE) {
+        return;
+    }
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+    readCredits(channel, payload + 1);
+#endif
+    if (payload[0] != ACK_DATA_CODE) {
+        return;
+    }
+    AckPayload& received = ackIn[channel];
+    received.length = length - 1 - ACK_CREDIT_SIZE;
+    memcpy(received.data, payload + 1 + ACK_CREDIT_SIZE, received.length);
+    globalStats.ackPayloadsReceived++;
+    pairedDevices[channel].stats.ackPayloadsReceived++;
+    TRACE_(ACK_PAYLOAD, channelPipe(channel), 1, received.length);
+}
+#endif
+
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+/**
+ * @brief Holds the outgoing message while the receiver advertised no room for it
+ * 
+ * Meanwhile the receiver is queried every RADIO_MANAGER_CREDIT_PROBE_INTERVAL with a credit
+ * frame, whose ack payload carries its credits, and we keep receiving. The message is
+ * aborted after RADIO_MANAGER_CREDIT_TIMEOUT.
+ * 
+ * @return true to send the message, false while waiting (or aborted)
+ */
+bool RadioManager::waitForCredit() {
+    if (outgoingChannel >= MAX_CHANNELS) {
+        return true;
+    }
+    PairedDevice& device = pairedDevices[outgoingChannel];
+    uint8_t pipe = outgoingTargetAddr.pipe - '0';
+    if (device.creditSlots == CREDIT_UNKNOWN || (device.creditSlots > 0 && device.creditBytes >= outgoingMsg.length)) {
+        if (creditWaiting) {
+            TRACE_(CREDIT_WAIT, pipe, 1, ((uint32_t)device.creditSlots << 16) | device.creditBytes);
+            creditWaiting = false;
+        }
+        return true;
+    }
+
+    unsigned long now = millis();
+    if (!creditWaiting) {
+        creditWaiting = true;
+        creditWaitStart = now;
+        creditProbeTime = now - Config::CREDIT_PROBE_INTERVAL; // Query at once
+        globalStats.creditWaits++;
+        device.stats.creditWaits++;
+        TRACE_(CREDIT_WAIT, pipe, 0, ((uint32_t)device.creditSlots << 16) | device.creditBytes);
+    }
+    if (now - creditWaitStart >= Config::CREDIT_TIMEOUT) {
+        TRACE_(CREDIT_WAIT, pipe, 2, outgoingMsg.length);
+        countDrop(outgoingChannel, RadioStats::DROP_NO_CREDIT);
+        bufferPool.release(outgoingMsg);
+        creditWaiting = false;
+        txListening = false;
+        currentState = IDLE;
+        resumeListening();
+        if (currentMsgStatus) *currentMsgStatus = -1;
+        LOG_LN("No credit from the receiver, message aborted");
+        return false;
+    }
+
+    if (now - creditProbeTime >= Config::CREDIT_PROBE_INTERVAL) {
+        creditProbeTime = now;
+        if (txListening) {
+            radio.stopListening();
+            openWritingPipe(outgoingTargetAddr.bytes());
+            txListening = false;
+        }
+        setLinkRadio(outgoingChannel);
+        setRadioChannel(txChannel == TX_HOP ? listenChannel() : txChannel);
+        uint8_t length = buildControlFrame(outgoingChannel, CREDIT_CODE, SOURCE_CREDIT_CODE, 0);
+        creditProbing = true;
+        writeFrame(txBuffer, length, pipe);
+        creditProbing = false;
+    }
+
+    // Receive meanwhile, the application may be waiting for the message that frees the receiver
+    if (!txListening) {
+        resumeListening();
+        txListening = true;
+    }
+    uint8_t pipe_num;
+    if (radio.available(&pipe_num)) {
+        currentState = RECEIVING;
+        receiveData(pipe_num);
+        currentState = TRANSMITTING;
+    }
+    return false;
+}
+
+/**
+ * @brief Writes the room left for the messages of a device: free mailbox slots and buffer bytes
+ * 
+ * @param channel The channel of the device
+ * @param credits ACK_CREDIT_SIZE bytes
+ */
+void RadioManager::writeCredits(uint8_t channel, uint8_t* credits) {
+    const PairedDevice& device = pairedDevices[channel];
+    uint16_t quota = bufferPool.getQuota(channel);
+    uint16_t used = bufferPool.getUsedBlocks(channel);
+    uint32_t blocks = std::min<uint32_t>(quota > used ? quota - used : 0, bufferPool.getFreeBlocks());
+    uint16_t bytes = std::min<uint32_t>(blocks * RadioBufferPool::BLOCK_SIZE, 0xFFFF);
+    credits[0] = MAX_MAILBOX_MSG - device.mailboxCount;
+    memcpy(credits + 1, &bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Updates the credits of a device from an ack payload, or counts the message just sent
+ * 
+ * The ack of a fragment describes the device before our message was stored, the message is
+ * deducted from it.
+ * 
+ * @param channel The channel of the device
+ * @param credits ACK_CREDIT_SIZE bytes, nullptr to deduct the outgoing message from the known credits
+ */
+void RadioManager::readCredits(uint8_t channel, const uint8_t* credits) {
+    PairedDevice& device = pairedDevices[channel];
+    bool inFlight = currentState == TRANSMITTING && channel == outgoingChannel && !creditProbing;
+    if (credits != nullptr) {
+        device.creditSlots = std::min<uint8_t>(credits[0], CREDIT_UNKNOWN - 1);
+        memcpy(&device.creditBytes, credits + 1, sizeof(device.creditBytes));
+        creditUpdated = creditUpdated || inFlight;
+    } else if (device.creditSlots == CREDIT_UNKNOWN) {
+        return;
+    }
+    if (inFlight) {
+        device.creditSlots = device.creditSlots > 0 ? device.creditSlots - 1 : 0;
+        device.creditBytes = device.creditBytes > outgoingMsg.length ? device.creditBytes - outgoingMsg.length : 0;
+    }
+}
+#endif
+
+/**
+ * @brief Computes the listening rate: the slowest rate asked by a paired device
+ * 
+ * The radio can only listen at one rate, so the devices sending to us all use this one.
+ */
+void RadioManager::updateListenRate() {
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+    uint8_t level = RATE_LEVELS;
+    for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+        if (!pairedDevices[i].addr.isEmpty() && pairedDevices[i].rxRate < level) {
+            level = pairedDevices[i].rxRate;
+        }
+    }
+    listenRate = (level < RATE_LEVELS) ? level : 0;
+#endif
+}
+
+/**
+ * @brief Gets the nRF24 data rate of a rate level
+ * 
+ * @param level Rate level, from the slowest (0) to the fastest (RATE_LEVELS - 1)
+ * @return The data rate
+ */
+rf24_datarate_e RadioManager::rateForLevel(uint8_t level) {
+    switch (level) {
+        case 1: return RF24_1MBPS;
+        case 2: return RF24_2MBPS;
+        default: return RF24_250KBPS;
+    }
+}
+
+#ifdef RADIO_MANAGER_ADAPTIVE_POWER
+/**
+ * @brief Adapts the PA level of a device to the retransmissions of a fragment it acknowledged
+ * 
+ * The level is raised as soon as a fragment needs POWER_UP_RETRIES retransmissions, and that
+ * level becomes the floor for a while (margin). It is lowered by one after POWER_DOWN_FRAGMENTS
+ * fragments without retransmission, below RF24_PA_LOW only if the device was last heard above
+ * -64 dBm (RPD), or never heard.
+ * 
+ * @param channel The channel of the device (ignored if not paired)
+ * @param retries Hardware retransmissions of the fragment (ARC)
+ */
+void RadioManager::trackPower(uint8_t channel, uint8_t retries) {
+    if (channel >= MAX_CHANNELS) {
+        return;
+    }
+    PairedDevice& device = pairedDevices[channel];
+    if (retries >= Config::POWER_UP_RETRIES) {
+        device.quietFragments = 0;
+        if (device.paLevel < RF24_PA_MAX) {
+            device.paFloor = device.paLevel + 1;
+            device.floorHoldoff = (uint16_t)Config::POWER_DOWN_FRAGMENTS * 8;
+            setPeerPower(channel, device.paLevel + 1, 1);
+        }
+        return;
+    }
+    if (retries > 0) {
+        device.quietFragments = 0;
+        return;
+    }
+
+    if (device.floorHoldoff > 0 && --device.floorHoldoff == 0 && device.paFloor > RF24_PA_MIN) {
+        device.paFloor--;
+        if (device.paFloor > RF24_PA_MIN) device.floorHoldoff = (uint16_t)Config::POWER_DOWN_FRAGMENTS * 8;
+    }
+    if (++device.quietFragments >= Config::POWER_DOWN_FRAGMENTS) {
+        device.quietFragments = 0;
+        bool margin = device.paLevel > RF24_PA_LOW || device.rpd != RPD_WEAK;
+        if (device.paLevel > device.paFloor && margin) {
+            setPeerPower(channel, device.paLevel - 1, 0);
+        }
+    }
+}
+
+/**
+ * @brief Resends the fragment in txBuffer at full power after a failure at a lower PA level
+ * 
+ * @param channel The channel of the device (ignored if not paired)
+ * @param length Length of the fragment
+ * @return true if the fragment was acknowledged, false otherwise (or if already at full power)
+ */
+bool RadioManager::boostPower(uint8_t channel, uint8_t length) {
+    if (channel >= MAX_CHANNELS || pairedDevices[channel].paLevel >= RF24_PA_MAX) {
+        return false;
+    }
+    PairedDevice& device = pairedDevices[channel];
+    device.paFloor = RF24_PA_MAX;
+    device.floorHoldoff = (uint16_t)Config::POWER_DOWN_FRAGMENTS * 8;
+    device.quietFragments = 0;
+    setPeerPower(channel, RF24_PA_MAX, 2);
+    setRadioPower(RF24_PA_MAX);
+    return writeFrame(txBuffer, length, outgoingTargetAddr.pipe - '0');
+}
+
+/**
+ * @brief Changes the PA level of a device, counted in its statistics
+ * 
+ * @param channel The channel of the device
+ * @param level The new PA level
+ * @param reason 0 step down, 1 step up, 2 boost (trace only)
+ */
+void RadioManager::setPeerPower(uint8_t channel, uint8_t level, uint8_t reason) {
+    PairedDevice& device = pairedDevices[channel];
+    TRACE_(POWER_CHANGE, channelPipe(channel), reason, level);
+    LOG_LN("Channel " + String(channel) + " PA level " + String(device.paLevel) + " -> " + String(level));
+    device.paLevel = level;
+    device.stats.powerChanges++;
+    globalStats.powerChanges++;
+}
+#endif
+
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+/**
+ * @brief Applies a data rate request received from a paired device
+ * 
+ * @param channel The channel of the device
+ * @param level Rate level the device asks us to listen at
+ */
+void RadioManager::handleRateFrame(uint8_t channel, uint8_t level) {
+    if (level >= RATE_LEVELS) {
+        return;
+    }
+    PairedDevice& device = pairedDevices[channel];
+    // A faster rate is kept once the device confirms it, by the same request sent at it
+    if (level > device.rxRate) {
+        device.rxRateFallback = device.rxRate;
+        device.rxRateTime = millis();
+    } else {
+        device.rxRateFallback = RATE_LEVELS;
+    }
+    device.rxRate = level;
+    updateListenRate();
+    if (listenRate != radioRate) {
+        radio.stopListening();
+        resumeListening();
+    }
+    TRACE_(RATE_CHANGE, channelPipe(channel), 3, level);
+    LOG_LN("Channel " + String(channel) + " asked for rate level " + String(level) + ", listening at level " + String(listenRate));
+}
+
+/**
+ * @brief Keeps the rate a device asked us to listen at, a message or control frame of the device was received at it
+ * 
+ * A single fragment isn't enough: on a link too weak for the rate, a few get through among the retransmissions.
+ * 
+ * @param channel The channel of the device
+ */
+void RadioManager::confirmRate(uint8_t channel) {
+    pairedDevices[channel].rxRateFallback = RATE_LEVELS;
+}
+
+/**
+ * @brief Listens again at the previous rate of the devices that didn't confirm the faster one they asked for
+ * 
+ * The device sent its request on a link that may be too weak for the new rate: its confirmation,
+ * and then its fragments and rate requests, are lost there.
+ */
+void RadioManager::checkRate() {
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+        PairedDevice& device = pairedDevices[i];
+        if (device.rxRateFallback < RATE_LEVELS && now - device.rxRateTime > RATE_CONFIRM_TIME) {
+            LOG_LN("Channel " + String(i) + " not heard at rate level " + String(device.rxRate) + ", back to " + String(device.rxRateFallback));
+            TRACE_(RATE_CHANGE, channelPipe(i), 4, device.rxRateFallback);
+            device.rxRate = device.rxRateFallback;
+            device.rxRateFallback = RATE_LEVELS;
+            updateListenRate();
+            if (listenRate != radioRate) {
+                radio.stopListening();
+                resumeListening();
+            }
+        }
+    }
+}
+
+/**
+ * @brief Updates the link quality of a device with the retransmissions of a fragment it acknowledged
+ * 
+ * @param channel The channel of the device (ignored if not paired)
+ * @param retries Hardware retransmissions of the fragment (ARC)
+ */
+void RadioManager::trackRetries(uint8_t channel, uint8_t retries) {
+    if (channel >= MAX_CHANNELS) {
+        return;
+    }
+    PairedDevice& device = pairedDevices[channel];
+    // Exponential moving average (1/8) in 1/16th of retransmission
+    int32_t average = device.retryAverage;
+    average += ((int32_t)retries * 16 - average) / 8;
+    device.retryAverage = average;
+    if (retries <= 1) {
+        if (device.cleanFragments < 0xFFFF) device.cleanFragments++;
+    } else {
+        device.cleanFragments = 0;
+    }
+    if (device.rateHoldoff > 0) {
+        device.rateHoldoff--;
+    }
+}
+
+/**
+ * @brief Steps the data rate of a device down or up after a message, depending on its link quality
+ * 
+ * Steps down when the retransmissions average RATE_DOWN_RETRIES, or when the message failed:
+ * the retransmissions of a fragment that is never acknowledged are not in the average, and the
+ * device keeps listening at the rate it was asked, so probing can't find it at a slower one. A
+ * failure also holds the next step up off, the faster rate just failed. Steps up after
+ * RATE_UP_FRAGMENTS fragments with at most 1 retransmission. The device is asked to listen at
+ * the new rate by a rate request, sent at the current rate while the writing pipe is still open,
+ * and a faster rate is confirmed by the same request sent at it. Without confirmation the device
+ * listens at the current rate again after RATE_CONFIRM_TIME, which we wait for.
+ * 
+ * @param channel The channel of the device (ignored if not paired)
+ * @param failed The message was aborted after a fragment failed
+ */
+void RadioManager::adaptRate(uint8_t channel, bool failed) {
+    if (channel >= MAX_CHANNELS) {
+        return;
+    }
+    PairedDevice& device = pairedDevices[channel];
+    uint8_t level;
+    if ((failed || device.retryAverage >= (uint16_t)Config::RATE_DOWN_RETRIES * 16) && device.txRate > 0) {
+        level = device.txRate - 1;
+    } else if (device.cleanFragments >= Config::RATE_UP_FRAGMENTS && device.rateHoldoff == 0 &&
+               device.txRate + 1 < RATE_LEVELS) {
+        level = device.txRate + 1;
+    } else {
+        return;
+    }
+
+    uint8_t length = buildControlFrame(channel, RATE_CODE, SOURCE_RATE_CODE, level);
+    setRadioRate(device.txRate);
+    if (!writeFrame(txBuffer, length, device.addr.pipe - '0')) {
+        return; // Link lost, the next message will probe the rate
+    }
+    if (level > device.txRate) {
+        // The same request at the new rate confirms it, otherwise the device listens at the current one again
+        setRadioRate(level);
+        if (!writeFrame(txBuffer, length, device.addr.pipe - '0')) {
+            TRACE_(RATE_CHANGE, device.addr.pipe - '0', 4, device.txRate);
+            device.rateHoldoff = (uint16_t)Config::RATE_UP_FRAGMENTS * 4;
+            device.cleanFragments = 0;
+            delay(RATE_CONFIRM_TIME);
+            return;
+        }
+    }
+
+    TRACE_(RATE_CHANGE, device.addr.pipe - '0', level > device.txRate, level);
+    LOG_LN("Channel " + String(channel) + " data rate level " + String(device.txRate) + " -> " + String(level));
+    if (failed) {
+        device.rateHoldoff = (uint16_t)Config::RATE_UP_FRAGMENTS * 4;
+    }
+    device.txRate = level;
+    device.retryAverage = 0;
+    device.cleanFragments = 0;
+    device.stats.rateChanges++;
+    globalStats.rateChanges++;
+}
+
+/**
+ * @brief Resends the fragment in txBuffer at the other rates, to find the rate the device listens at
+ * 
+ * The device listens at the slowest rate asked by its own peers, which may not be the one we asked.
+ * Probing doesn't duplicate fragments: the device can't have received the ones sent at another rate.
+ * 
+ * @param channel The channel of the device (255 for unpaired addresses)
+ * @param length Length of the fragment
+ * @return true if the fragment was acknowledged at another rate, false otherwise
+ */
+bool RadioManager::probeRate(uint8_t channel, uint8_t length) {
+    uint8_t current = radioRate;
+    for (uint8_t i = 1; i < RATE_LEVELS; i++) {
+        // Slower rates first, they are the most likely after a failure
+        uint8_t level = (current + RATE_LEVELS - i) % RATE_LEVELS;
+        setRadioRate(level);
+        if (writeFrame(txBuffer, length, outgoingTargetAddr.pipe - '0')) {
+            TRACE_(RATE_CHANGE, outgoingTargetAddr.pipe - '0', 2, level);
+            if (channel < MAX_CHANNELS) {
+                PairedDevice& device = pairedDevices[channel];
+                // Don't ask for a faster rate again soon if the device stays slower than asked
+                if (level < device.txRate) {
+                    device.rateHoldoff = (uint16_t)Config::RATE_UP_FRAGMENTS * 4;
+                }
+                device.txRate = level;
+                device.retryAverage = 0;
+                device.cleanFragments = 0;
+                device.stats.rateChanges++;
+                globalStats.rateChanges++;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+/**
+ * @brief Receives data on a specific channel
+ * 
+ * @param pipe_num The channel number on which to receive data
+ */
+void RadioManager::receiveData(uint8_t pipe_num) {
+    if (!isEnabled) {
+        return;  // Do not receive data if RadioManager is disabled
+    }
+
+    PROFILE_SCOPE_(RadioProfiler::RECEIVE_DATA);
+#ifdef RADIO_MANAGER_TIME_SYNC
+    rxTime = micros();
+#endif
+    uint8_t packetSize = payloadSize();
+    
+    if (packetSize >= HEADER_SIZE && packetSize <= NRF_BUF_SIZE) {
+        // A full RX FIFO means the radio may have discarded the following packets
+        bool fifoFull = radio.rxFifoFull();
+
+        uint8_t packet[NRF_BUF_SIZE];
+        readFrame(packet, packetSize, pipe_num, fifoFull ? RadioCaptureFrame::FLAG_RX_FIFO_FULL : 0);
+        // Zeros of the header removed by unpad() are kept
+        size_t length = std::max<size_t>(unpad(packet, packetSize), HEADER_SIZE);
+        
+        PacketHeader header;
+        memcpy(&header, packet, HEADER_SIZE);
+#ifdef RADIO_MANAGER_ACK_PAYLOAD
+        if (header.code != STREAM_CODE && header.code != SOURCE_STREAM_CODE && header.code != BEACON_CODE) {
+            ackPayloadSent(pipe_num); // Stream frames and beacons are not acknowledged
+        }
+#endif
+
+#ifdef RADIO_MANAGER_TDMA
+        if (pipe_num == 0) {
+            // Pipe 0 only listens to the beacons of the coordinator we follow
+            if (header.code == BEACON_CODE) {
+                handleBeacon(packet + HEADER_SIZE, packetSize - HEADER_SIZE, header.index);
+            }
+            currentState = IDLE;
+            return;
+        }
+#endif
+
+        // Identify the sender: source id in the header for peers sharing a pipe, otherwise the pipe itself
+        uint8_t channel = pipe_num - 1;  // Convert pipe number to channel index
+        uint8_t headerSize = HEADER_SIZE;
+        bool isStart = (header.code == START_CODE);
+        if (header.code >= 'a' && header.code <= 'z') {
+            // Lowercase codes are followed by the source id of the sender
+            headerSize = SOURCE_HEADER_SIZE;
+            isStart = (header.code == SOURCE_START_CODE);
+            length = std::max<size_t>(length, headerSize);
+            channel = (packetSize > HEADER_SIZE) ? packet[HEADER_SIZE] : 0;
+            if (channel < MAX_CHANNELS && channelPipe(channel) != pipe_num) {
+                channel = 255; // Source id not assigned to this pipe
+            }
+        }
+
+        if (header.code != START_CODE && header.code != CONTINUE_CODE &&
+            header.code != SOURCE_START_CODE && header.code != SOURCE_CONTINUE_CODE) {
+            // Not a fragment: control frame of a paired device, or garbage
+            if (channel < MAX_CHANNELS && !pairedDevices[channel].addr.isEmpty() && packetSize >= headerSize) {
+                noteContact(channel);
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+                confirmRate(channel);
+#endif
+                // Control frames have a fixed layout, their trailing zeros are kept
+                handleControlFrame(channel, header.code, header.index, packet + headerSize, packetSize - headerSize);
+            }
+            currentState = IDLE;
+            return;
+        }
+
+        if (fifoFull) {
+            countDrop(channel, RadioStats::DROP_RX_FIFO_FULL);
+        }
+        TRACE_(RX_FRAGMENT, pipe_num, header.index, length - headerSize);
+
+        if (channel >= MAX_CHANNELS || pairedDevices[channel].addr.isEmpty()) {
+            // Count unknown senders once per message
+            globalStats.fragmentsReceived++;
+            globalStats.bytesReceived += length - headerSize;
+            if (isStart) {
+                countDrop(channel, RadioStats::DROP_UNPAIRED);
+            }
+            expireReassembly();
+            currentState = IDLE;
+            return;
+        }
+
+        PairedDevice& device = pairedDevices[channel];
+        noteContact(channel);
+#ifdef RADIO_MANAGER_ADAPTIVE_POWER
+        // Received power of the fragment, the margin of the link for lowering our PA level
+        device.rpd = radio.testRPD() ? RPD_STRONG : RPD_WEAK;
+#endif
+        RadioStats* peerStats = &device.stats;
+        for (RadioStats* stats : { &globalStats, peerStats }) {
+            stats->fragmentsReceived++;
+            stats->bytesReceived += length - headerSize;
+        }
+        
+        if (isStart) {
+            // New message, clear everything that came before
+            bufferPool.release(device.rxBuffer);
+            device.rxDropped = false;
+            device.expectedFragments = header.index + 1; // Set expected fragments
+            device.receivedFragments = 0;
+            device.rxStartTime = micros();
+        }
+        
+        // Add the fragment to the buffer
+        if (device.receivedFragments < MAX_PACKETS_RCV && !device.rxDropped) {
+            if (appendFragment(channel, packet + headerSize, length - headerSize)) {
+                device.lastReceiveTime = millis();
+                device.receivedFragments++;
+            } else {
+                TRACE_(RX_NO_BUFFER, pipe_num, header.index, device.rxBuffer.length);
+                countDrop(channel, RadioStats::DROP_NO_BUFFER);
+                LOG_LN("Error: No buffer left for the incoming message");
+                bufferPool.release(device.rxBuffer);
+                device.rxDropped = true;
+            }
+        }
+        
+        // Check if it's the last fragment
+        if (header.index == 0) {
+            if (device.rxDropped) {
+                // Already counted when the buffer ran out
+            } else if (device.receivedFragments == device.expectedFragments) {
+                // Process the complete message
+                LOG_LN("Received message: " + String(device.rxBuffer.length) + " bytes");
+
+                // Attempt to decrypt the message (in place)
+                if (decryptMessage(channel, device.rxBuffer)) {
+                    TRACE_(DECRYPT_OK, pipe_num, 0, device.rxBuffer.length);
+                    LOG_LN("Decrypted message!");
+                } else {
+                    TRACE_(DECRYPT_FAIL, pipe_num, 0, device.rxBuffer.length);
+                    globalStats.decryptRejected++;
+                    peerStats->decryptRejected++;
+                    LOG_LN("Message not decrypted (possibly unencrypted)");
+                }
+
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+                confirmRate(channel);
+#endif
+                TRACE_(RX_COMPLETE, pipe_num, 0, device.rxBuffer.length);
+                pushMailbox(channel, device.rxBuffer);
+                uint32_t latency = micros() - device.rxStartTime;
+                for (RadioStats* stats : { &globalStats, peerStats }) {
+                    stats->messagesReceived++;
+                    stats->reassemblyLatency.add(latency);
+                }
+            } else {
+                TRACE_(RX_INCOMPLETE, pipe_num, 0, ((uint32_t)device.expectedFragments << 16) | device.receivedFragments);
+                countDrop(channel, RadioStats::DROP_FRAGMENT_MISMATCH);
+                LOG_LN("Error: Incomplete message received. Expected " + String(device.expectedFragments) + " fragments, got " + String(device.receivedFragments));
+            }
+            
+            // Reset the buffer and counters
+            bufferPool.release(device.rxBuffer);
+            device.rxDropped = false;
+            device.expectedFragments = 0;
+            device.receivedFragments = 0;
+        }
+    }
+    
+    expireReassembly();
+    currentState = IDLE;
+}
+
+/**
+ * @brief Appends a received fragment to the reassembly buffer of a channel
+ * 
+ * When the pool or the quota of the channel is exhausted, the oldest unread messages of the
+ * channel are dropped to make room.
+ * 
+ * @param channel The channel number
+ * @param data Fragment payload
+ * @param length Payload length
+ * @return true if the fragment was stored, false if no buffer is left
+ */
+bool RadioManager::appendFragment(uint8_t channel, const uint8_t* data, size_t length) {
+    PairedDevice& device = pairedDevices[channel];
+    while (!bufferPool.append(device.rxBuffer, channel, data, length)) {
+        if (device.mailboxCount == 0) {
+            return false;
+        }
+        TRACE_(MAILBOX_DROP, channelPipe(channel), 0, device.mailboxCount);
+        countDrop(channel, RadioStats::DROP_MAILBOX_OVERFLOW);
+        popMailbox(channel);
+    }
+    return true;
+}
+
+/**
+ * @brief Moves a complete message to the mailbox of a channel, dropping the oldest one if full
+ * 
+ * @param channel The channel number
+ * @param msg The message, left empty
+ */
+void RadioManager::pushMailbox(uint8_t channel, RadioBufferPool::Chain& msg) {
+    PairedDevice& device = pairedDevices[channel];
+    if (device.mailboxCount >= MAX_MAILBOX_MSG) {
+        TRACE_(MAILBOX_DROP, channelPipe(channel), 0, device.mailboxCount);
+        countDrop(channel, RadioStats::DROP_MAILBOX_OVERFLOW);
+        popMailbox(channel);
+    }
+    device.mailbox[(device.mailboxHead + device.mailboxCount) % MAX_MAILBOX_MSG] = msg;
+    device.mailboxCount++;
+    msg = RadioBufferPool::Chain();
+}
+
+/**
+ * @brief Drops the oldest message of the mailbox of a channel
+ * 
+ * @param channel The channel number
+ */
+void RadioManager::popMailbox(uint8_t channel) {
+    PairedDevice& device = pairedDevices[channel];
+    if (device.mailboxCount > 0) {
+        bufferPool.release(device.mailbox[device.mailboxHead]);
+        device.mailboxHead = (device.mailboxHead + 1) % MAX_MAILBOX_MSG;
+        device.mailboxCount--;
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+        if (isEnabled && currentState == IDLE && ackOut[channel].loaded) {
+            loadAckPayloads(true); // Advertise the free slot
+        }
+#endif
+    }
+}
+
+/**
+ * @brief Drops the partial messages that have expired
+ */
+void RadioManager::expireReassembly() {
+    unsigned long now = millis();
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        PairedDevice& device = pairedDevices[i];
+        if (!device.rxBuffer.empty() && now - device.lastReceiveTime > RECEIVE_TIMEOUT) {
+            TRACE_(RX_TIMEOUT, channelPipe(i), 0, device.rxBuffer.length);
+            countDrop(i, RadioStats::DROP_REASSEMBLY_TIMEOUT);
+            LOG_LN("Error: Message reception timeout. Clearing buffer.");
+            bufferPool.release(device.rxBuffer);
+            device.expectedFragments = 0;
+            device.receivedFragments = 0;
+        }
+    }
+}
+
+/**
+ * @brief Generates an X25519 key pair
  * 
  * @return true if generation was successful, false otherwise
  */
@@ -889,15 +3560,282 @@ bool RadioManager::generateX25519KeyPair(uint8_t* publicKey, uint8_t* privateKey
         return false;
     }
 
-    size_t olen;
-    ret = mbedtls_ecp_point_write_binary(&ctx.grp, &ctx.Q, MBEDTLS_ECP_PF_COMPRESSED,
-                                         &olen, publicKey, KEY_SIZE);
+    size_t olen;
+    ret = mbedtls_ecp_point_write_binary(&ctx.grp, &ctx.Q, MBEDTLS_ECP_PF_COMPRESSED,
+                                         &olen, publicKey, KEY_SIZE);
+    if (ret != 0) {
+        mbedtls_ecdh_free(&ctx);
+        return false;
+    }
+
+    ret = mbedtls_mpi_write_binary(&ctx.d, privateKey, KEY_SIZE);
+    if (ret != 0) {
+        mbedtls_ecdh_free(&ctx);
+        return false;
+    }
+
+    mbedtls_ecdh_free(&ctx);
+    return true;
+}
+
+/**
+ * @brief Destructor for RadioManager
+ * Frees allocated resources
+ */
+RadioManager::~RadioManager() {
+    mbedtls_ctr_drbg_free(&ctr_drbg);
+#ifndef RADIO_MANAGER_SMALL_NODE
+    mbedtls_entropy_free(&entropy);
+#endif
+    if (poolData) allocator->release(poolData, RadioAllocator::LARGE);
+    if (poolLinks) allocator->release(poolLinks, RadioAllocator::FAST);
+}
+
+/**
+ * @brief Gets the list of paired Addrs & keys as a string
+ * 
+ * @return A string containing the list of paired Addrs & keys, as a JSON object. 
+ *         "0" represents an unpaired channel.
+ */
+String RadioManager::getPairedDevicesJson(bool keys) {
+#ifndef RADIO_MANAGER_SMALL_NODE
+    // Serialize only once per configuration generation (small nodes don't keep the strings)
+    CachedJson& cache = pairedDevicesJsonCache[keys ? 1 : 0];
+    if (cache.valid && cache.generation == configGeneration) {
+        return cache.json;
+    }
+#endif
+
+    String addrList;
+    JsonDocument doc;
+    writePairedDevicesJson(doc.to<JsonObject>(), keys);
+    serializeJson(doc, addrList);
+
+#ifndef RADIO_MANAGER_SMALL_NODE
+    cache.json = addrList;
+    cache.generation = configGeneration;
+    cache.valid = true;
+#endif
+    return addrList;
+}
+
+/**
+ * @brief Sets the list of paired Addrs from a string
+ * 
+ * @param addrJson A JSON string containing the list of Addrs & pubKeys to set, separated by commas.
+ *                "0" represents an unpaired channel.
+ * @return true if the operation was successful, false otherwise
+ */
+bool RadioManager::setPairedDevicesJson(const String& addrJson) {
+    JsonDocument doc;
+    if (deserializeJson(doc, addrJson)) {
+        return false;
+    }
+    return readPairedDevicesJson(doc.as<JsonObjectConst>());
+}
+
+/**
+ * @brief Fills a JSON object with the list of paired Addrs & keys
+ * 
+ * @param devices The object to fill, receives an "addr" array and, if keys is set, a "pubKey" array
+ * @param keys Whether to include the public keys of the paired devices
+ */
+void RadioManager::writePairedDevicesJson(JsonObject devices, bool keys) {
+    static const uint8_t ZERO_KEY[KEY_SIZE] = {0};
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        if (pairedDevices[i].addr.isEmpty()) {
+            devices["addr"][i] = "0";
+        } else {
+            devices["addr"][i] = formatPairedAddr(i);
+            // Channels paired without key get no "pubKey" entry
+            if (keys && memcmp(pairedDevices[i].publicKey, ZERO_KEY, KEY_SIZE) != 0) {
+                char pubKey[Base64::encodedLength(KEY_SIZE) + 1];
+                Base64::encode(pairedDevices[i].publicKey, KEY_SIZE, pubKey, sizeof(pubKey));
+                devices["pubKey"][i] = pubKey;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Applies a list of paired Addrs & keys read from a JSON object
+ * 
+ * A channel without a "pubKey" entry, or with the zero key older exports wrote for it, is
+ * paired without a key. A channel whose key can't be decoded to KEY_SIZE bytes or is not a
+ * valid public key keeps its current pairing.
+ * 
+ * @param devices Object holding an "addr" array and an optional "pubKey" array
+ * @return true if the operation was successful, false if the object is invalid or a key was rejected
+ */
+bool RadioManager::readPairedDevicesJson(JsonObjectConst devices) {
+    if (!devices["addr"].is<JsonArrayConst>()) {
+        return false;
+    }
+
+    bool valid = true;
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        if (devices["addr"][i].isNull()) continue;
+        if (devices["addr"][i] == "0") {
+            clearPairedAddr(i);
+        } else {
+            String addr = devices["addr"][i].as<String>();
+            if (devices["pubKey"][i].isNull()) {
+                setPairedAddr(addr, i);
+                continue;
+            }
+            const char* pubKey = devices["pubKey"][i] | "";
+            uint8_t pubKeyBytes[KEY_SIZE];
+            Base64::Error error;
+            size_t keyLen = Base64::decode(pubKey, strlen(pubKey), pubKeyBytes, sizeof(pubKeyBytes), &error);
+            static const uint8_t ZERO_KEY[KEY_SIZE] = {0};
+            if (keyLen == KEY_SIZE && memcmp(pubKeyBytes, ZERO_KEY, KEY_SIZE) == 0) {
+                // Older exports wrote a zero key for the channels paired without key
+                setPairedAddr(addr, i);
+            } else if (keyLen == KEY_SIZE) {
+                if (!setPairedAddr(addr, i, pubKeyBytes)) {
+                    LOG_LN("Public key rejected for channel " + String(i));
+                    valid = false;
+                }
+            } else {
+                // A short key decodes without error, report its length instead of "OK"
+                LOG_LN("Invalid public key for channel " + String(i) + ": " +
+                       (error != Base64::OK ? String(Base64::errorToStr(error)) :
+                        String(keyLen) + " bytes instead of " + String(KEY_SIZE)));
+                valid = false;
+            }
+        }
+    }
+
+    // Reinitialize the radio to apply the new pairing configuration
+    initRadio();
+
+    return valid;
+}
+
+/**
+ * @brief Set personal public & private key (used for shared secret gen)
+ * 
+ * @param publicKey Reference to Bytes containing pub key
+ * @param privateKey Reference to Bytes containing private key
+ * 
+ * @return True if keys set, false if invalid key(s)
+ * 
+ */
+bool RadioManager::setPersonalKeys(const Bytes& publicKey, const Bytes& privateKey) {
+    if (publicKey.size() == KEY_SIZE && privateKey.size() == KEY_SIZE) {
+        memcpy(this->publicKey, publicKey.data(), KEY_SIZE);
+        memcpy(this->privateKey, privateKey.data(), KEY_SIZE);
+        bumpConfigGeneration();
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Get personal public & private keys (used for shared secret generation)
+ * 
+ * @param publicKey Reference to Bytes to store the public key
+ * @param privateKey Reference to Bytes to store the private key
+ * 
+ * This function copies the current personal public and private keys into the provided Bytes vectors.
+ * The vectors will be resized to KEY_SIZE if necessary.
+ */
+void RadioManager::getPersonalKeys(Bytes& publicKey, Bytes& privateKey) {
+    publicKey.resize(KEY_SIZE);
+    privateKey.resize(KEY_SIZE);
+    memcpy(publicKey.data(), this->publicKey, KEY_SIZE);
+    memcpy(privateKey.data(), this->privateKey, KEY_SIZE);
+}
+
+/**
+ * @brief Set paired channel public & shared keys (used for pairing & E2EE)
+ * 
+ * @param channel Pairing channel
+ * @param publicKey Reference to Bytes containing pub key
+ * 
+ * @return True if keys set, false if invalid key(s)
+ * 
+ */
+bool RadioManager::setPairedDeviceKeys(uint8_t channel, const Bytes& publicKey) {
+    if (channel < MAX_CHANNELS) {
+        if (publicKey.size() == KEY_SIZE) {
+            uint8_t sharedKey[KEY_SIZE];
+            bool keyGen = generateX25519SharedKey(publicKey.data(), privateKey, sharedKey);
+            if (!keyGen) return false;
+            memcpy(this->pairedDevices[channel].publicKey, publicKey.data(), KEY_SIZE);
+            memcpy(this->pairedDevices[channel].sharedKey, sharedKey, KEY_SIZE);
+            this->pairedDevices[channel].chaObject.setKey(this->pairedDevices[channel].sharedKey);
+            bumpConfigGeneration();
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Generate X25519 shared key
+ * 
+ * With RADIO_MANAGER_STATIC_MEMORY, the key is computed on the stack by Curve25519 instead of
+ * the mbedtls bignums (heap). The keys keep the mbedtls byte order: big-endian private key and
+ * shared secret, little-endian public key.
+ * 
+ * @param peerPublicKey Pointer to peer public key (KEY_SIZE)
+ * @param privateKey Pointer to own private key (KEY_SIZE)
+ * @param sharedKey Pointer to generated shared key (KEY_SIZE)
+ * @return true if the key was generated, false otherwise
+ */
+bool RadioManager::generateX25519SharedKey(const uint8_t* peerPublicKey, const uint8_t* privateKey, uint8_t* sharedKey) {
+#ifdef RADIO_MANAGER_STATIC_MEMORY
+    uint8_t scalar[KEY_SIZE];
+    uint8_t point[KEY_SIZE];
+    uint8_t result[KEY_SIZE];
+    for (size_t i = 0; i < KEY_SIZE; i++) {
+        scalar[i] = privateKey[KEY_SIZE - 1 - i];
+    }
+    scalar[0] &= 0xF8;
+    scalar[KEY_SIZE - 1] = (scalar[KEY_SIZE - 1] & 0x7F) | 0x40;
+    memcpy(point, peerPublicKey, KEY_SIZE);
+    point[KEY_SIZE - 1] &= 0x7F;
+
+    bool ok = Curve25519::eval(result, scalar, point);
+    if (ok) {
+        for (size_t i = 0; i < KEY_SIZE; i++) {
+            sharedKey[i] = result[KEY_SIZE - 1 - i];
+        }
+    }
+    memset(scalar, 0, sizeof(scalar));
+    memset(result, 0, sizeof(result));
+    return ok;
+#else
+    mbedtls_ecdh_context ctx;
+    mbedtls_ecdh_init(&ctx);
+
+    int ret = mbedtls_ecp_group_load(&ctx.grp, MBEDTLS_ECP_DP_CURVE25519);
+    if (ret != 0) {
+        mbedtls_ecdh_free(&ctx);
+        return false;
+    }
+
+    ret = mbedtls_mpi_read_binary(&ctx.d, privateKey, KEY_SIZE);
+    if (ret != 0) {
+        mbedtls_ecdh_free(&ctx);
+        return false;
+    }
+
+    ret = mbedtls_ecp_point_read_binary(&ctx.grp, &ctx.Qp, peerPublicKey, KEY_SIZE);
+    if (ret != 0) {
+        mbedtls_ecdh_free(&ctx);
+        return false;
+    }
+
+    ret = mbedtls_ecdh_compute_shared(&ctx.grp, &ctx.z, &ctx.Qp, &ctx.d,
+                                      mbedtls_ctr_drbg_random, &ctr_drbg);
     if (ret != 0) {
         mbedtls_ecdh_free(&ctx);
         return false;
     }
 
-    ret = mbedtls_mpi_write_binary(&ctx.d, privateKey, KEY_SIZE);
+    ret = mbedtls_mpi_write_binary(&ctx.z, sharedKey, KEY_SIZE);
     if (ret != 0) {
         mbedtls_ecdh_free(&ctx);
         return false;
@@ -905,399 +3843,839 @@ bool RadioManager::generateX25519KeyPair(uint8_t* publicKey, uint8_t* privateKey
 
     mbedtls_ecdh_free(&ctx);
     return true;
+#endif
 }
 
 /**
- * @brief Destructor for RadioManager
- * Frees allocated resources
+ * @brief Gets the radio module ID
+ * 
+ * @return The radio module ID as a String
  */
-RadioManager::~RadioManager() {
-    mbedtls_ctr_drbg_free(&ctr_drbg);
-    mbedtls_entropy_free(&entropy);
+String RadioManager::getRadioID() {
+    return radioID;
+}
+
+/**
+ * @brief Check validity of a given address
+ * 
+ * The address may be followed by ":<source id>" (1-2 hex digits), the slot assigned by a gateway.
+ * 
+ * @param addr The address to be checked
+ * @return true if the address is valid, false otherwise
+ */
+bool RadioManager::checkValidAddr(const char* addr) {
+    size_t length = strlen(addr);
+
+    // Check the optional source id suffix
+    if (length > 5) {
+        if (length > 8 || addr[5] != ':' || length == 6) {
+            return false;
+        }
+        for (size_t i = 6; i < length; i++) {
+            if (!isHexadecimalDigit(addr[i])) {
+                return false;
+            }
+        }
+    }
+
+    // Check if address is encoded on 5 characters
+    if (length < 5) {
+        return false;
+    }
+
+    // Check if 1st char is a number [0,5]
+    char firstChar = addr[0];
+    if (firstChar < '0' || firstChar > '5') {
+        return false;
+    }
 
-    if (tempCha != nullptr) {
-        delete tempCha;
+    // Check if next 4 char are alphanumeric
+    for (int i = 1; i < 5; i++) {
+        if (!isAlphaNumeric(addr[i])) {
+            return false;
+        }
     }
+
+    // Valid if fell through all checks
+    return true;
 }
 
 /**
- * @brief Gets the list of paired Addrs & keys as a string
+ * @brief Splits a pairing address "<pipe><UID>[:<source id>]" into the address and the source id
  * 
- * @return A string containing the list of paired Addrs & keys, as a JSON object. 
- *         "0" represents an unpaired channel.
+ * @param pairingAddr The pairing address
+ * @param addr Receives the address
+ * @param sourceId Receives the source id, or NO_SOURCE_ID if there is none
+ * @return false if the address is not 5 characters long
  */
-String RadioManager::getPairedDevicesJson(bool keys) {
-    String addrList;
-    JsonDocument doc;
-    for (int i = 0; i < MAX_CHANNELS; i++) {
-        if (pairedDevices[i].addr.isEmpty()) {
-            doc["addr"][i] = "0";
-        } else {
-            doc["addr"][i] = pairedDevices[i].addr;
-            if (keys) {
-                doc["pubKey"][i] = Base64::encode(pairedDevices[i].publicKey, KEY_SIZE);
-            }
+bool RadioManager::splitPairingAddr(const char* pairingAddr, RadioAddress& addr, uint8_t& sourceId) {
+    const char* separator = strchr(pairingAddr, ':');
+    if (separator == nullptr) {
+        sourceId = NO_SOURCE_ID;
+        return RadioAddress::parse(pairingAddr, strlen(pairingAddr), addr);
+    }
+    sourceId = strtoul(separator + 1, nullptr, 16);
+    return RadioAddress::parse(pairingAddr, separator - pairingAddr, addr);
+}
+
+/**
+ * @brief Gets the address of the paired device on a channel with its source id, as in pairing
+ * 
+ * @param channel The channel number
+ * @return "<pipe><UID>[:<source id>]", or an empty string if no device is paired on this channel
+ */
+String RadioManager::formatPairedAddr(uint8_t channel) {
+    if (channel >= MAX_CHANNELS || pairedDevices[channel].sourceId == NO_SOURCE_ID) {
+        return getPairedAddr(channel);
+    }
+    char suffix[4];
+    snprintf(suffix, sizeof(suffix), ":%02X", pairedDevices[channel].sourceId);
+    return pairedDevices[channel].addr.toString() + suffix;
+}
+
+/**
+ * @brief Writes the address sent to a peer paired on a channel
+ * 
+ * In gateway mode, peers share the reading pipes and the address carries the channel
+ * as source id, that the peer includes in the header of each fragment it sends.
+ * 
+ * @param channel The channel number
+ * @param unpair Whether to write an unpair request ("0<radioID>") instead
+ * @param pairingID Buffer of PAIRING_ID_SIZE bytes receiving "<pipe><radioID>", followed by ":<channel>" in gateway mode
+ * @return The length of the pairing address
+ */
+size_t RadioManager::formatPairingID(uint8_t channel, bool unpair, char* pairingID) {
+    pipeAddress(unpair ? 0 : channelPipe(channel), reinterpret_cast<uint8_t*>(pairingID));
+    pairingID[RadioAddress::SIZE] = '\0';
+#ifdef RADIO_MANAGER_GATEWAY
+    if (!unpair) {
+        snprintf(pairingID + RadioAddress::SIZE, PAIRING_ID_SIZE - RadioAddress::SIZE, ":%02X", channel);
+    }
+#endif
+    return strlen(pairingID);
+}
+
+/**
+ * @brief Writes our address on a reading pipe
+ * 
+ * @param pipe The pipe number (0 for unpair requests)
+ * @param address Buffer of RadioAddress::SIZE bytes receiving "<pipe><radioID>" (not terminated)
+ */
+void RadioManager::pipeAddress(uint8_t pipe, uint8_t* address) {
+    address[0] = '0' + pipe;
+    memcpy(address + 1, radioID.c_str(), RadioAddress::UID_SIZE);
+}
+
+/**
+ * @brief Gets the reading pipe used by the peer paired on a channel
+ * 
+ * @param channel The channel number
+ * @return The pipe number (1-5)
+ */
+uint8_t RadioManager::channelPipe(uint8_t channel) {
+    return channel % PIPE_COUNT + 1;
+}
+
+/**
+ * @brief Check if UID exists in paired devices and unpair corresponding address
+ * 
+ * @param uid The 4-character UID to be unpaired
+ * @return true if an address was unpaired, false otherwise
+ */
+bool RadioManager::clearPairedUID(String& uid) {
+    if (uid.length() != RadioAddress::UID_SIZE) {
+        return false;
+    }
+    return unpairUID(RadioAddress::uidFromChars(uid.c_str()));
+}
+
+/**
+ * @brief Unpairs the address with a given UID, if it is paired
+ * 
+ * @param uid The UID characters (see RadioAddress::uidFromChars)
+ * @return true if an address was unpaired, false otherwise
+ */
+bool RadioManager::unpairUID(uint32_t uid) {
+    uint8_t channel = peerIndex.find(uid);
+    if (channel < MAX_CHANNELS) {
+        clearPairedAddr(channel);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Set the public key for a paired device
+ * 
+ * @param channel The channel number of the paired device
+ * @param newPublicKey Pointer to the new public key
+ */
+void RadioManager::setDevicePublicKey(uint8_t channel, const uint8_t* newPublicKey) {
+    if (channel < MAX_CHANNELS) {
+        memcpy(pairedDevices[channel].publicKey, newPublicKey, KEY_SIZE);
+    }
+}
+
+/**
+ * @brief Set the shared key for a paired device and update the chaObject
+ * 
+ * @param channel The channel number of the paired device
+ * @param newSharedKey Pointer to the new shared key
+ */
+void RadioManager::setDeviceSharedKey(uint8_t channel, const uint8_t* newSharedKey) {
+    if (channel < MAX_CHANNELS) {
+        memcpy(pairedDevices[channel].sharedKey, newSharedKey, KEY_SIZE);
+        pairedDevices[channel].chaObject.setKey(newSharedKey);
+    }
+}
+
+#ifdef RADIO_MANAGER_SMALL_NODE
+/**
+ * @brief Entropy source of the DRBG on small nodes: the hardware RNG
+ * 
+ * mbedtls_entropy_func polls the same RNG on the ESP32, through an accumulator of about
+ * 600 bytes that small nodes can't afford.
+ * 
+ * @param context Unused
+ * @param output Buffer to fill
+ * @param length Number of bytes
+ * @return 0 (the hardware RNG doesn't fail)
+ */
+int RadioManager::hardwareEntropy(void* context, unsigned char* output, size_t length) {
+    (void)context;
+    esp_fill_random(output, length);
+    return 0;
+}
+#endif
+
+/**
+ * @brief Encrypt a message into the buffer pool using the chaObject of the specified channel
+ * 
+ * @param channel The channel number to use for encryption
+ * @param message The message to encrypt
+ * @param length The length of the message
+ * @param encryptedMessage Empty chain receiving the nonce and the ciphertext (TX queue owner)
+ * @return true if the message was encrypted, false if the channel is invalid or no buffer is left
+ */
+bool RadioManager::encryptMessage(uint8_t channel, const uint8_t* message, size_t length, RadioBufferPool::Chain& encryptedMessage) {
+    PROFILE_SCOPE_(RadioProfiler::ENCRYPT);
+    if (channel >= MAX_CHANNELS) {
+        return false;
+    }
+    SimpleCha2& cha = pairedDevices[channel].chaObject;
+    uint8_t nonce[SimpleCha2::NONCE_SIZE];
+    cha.beginEncrypt(nonce);
+    if (!bufferPool.append(encryptedMessage, TX_POOL_OWNER, nonce, sizeof(nonce)) ||
+        !bufferPool.append(encryptedMessage, TX_POOL_OWNER, message, length)) {
+        return false;
+    }
+    bufferPool.forEachSegment(encryptedMessage, sizeof(nonce), [&cha](uint8_t* data, size_t length) {
+        cha.process(data, data, length);
+    });
+    return true;
+}
+
+/**
+ * @brief Decrypt a message in place using the chaObject of the specified channel
+ * 
+ * @param channel The channel number to use for decryption
+ * @param message The received message (nonce + ciphertext), replaced by the cleartext if decrypted
+ * @return true if the message was decrypted, false if it is left untouched (unencrypted, wrong key or replayed)
+ */
+bool RadioManager::decryptMessage(uint8_t channel, RadioBufferPool::Chain& message) {
+    PROFILE_SCOPE_(RadioProfiler::DECRYPT);
+    if (channel >= MAX_CHANNELS || message.length <= SimpleCha2::NONCE_SIZE) {
+        return false;
+    }
+    SimpleCha2& cha = pairedDevices[channel].chaObject;
+    uint8_t nonce[SimpleCha2::NONCE_SIZE];
+    bufferPool.read(message, 0, nonce, sizeof(nonce));
+    if (!cha.beginDecrypt(nonce)) {
+        return false;
+    }
+    bufferPool.forEachSegment(message, sizeof(nonce), [&cha](uint8_t* data, size_t length) {
+        cha.process(data, data, length);
+    });
+    bufferPool.consume(message, sizeof(nonce));
+    return true;
+}
+
+/**
+ * @brief Add padding to message (fill with 0s)
+ * 
+ * @param payload Payload buffer of at least paddingSize bytes
+ * @param length Length of the payload
+ * @param paddingSize Padding size in bytes
+ */
+void RadioManager::pad(uint8_t* payload, size_t length, size_t paddingSize) {
+    if (length < paddingSize) {
+        memset(payload + length, 0, paddingSize - length);
+    }
+}
+
+/**
+ * @brief Remove padding from message (end 0s)
+ * 
+ * @param payload Payload buffer
+ * @param length Length of the padded payload
+ * @return The length of the payload without padding
+ */
+size_t RadioManager::unpad(const uint8_t* payload, size_t length) {
+    while (length > 0 && payload[length - 1] == 0) {
+        length--;
+    }
+    return length;
+}
+
+/**
+ * @brief Clear all messages in inbox
+ * 
+ * @param channel Channel number
+ */
+void RadioManager::clearMessages(uint8_t channel) {
+    if (channel < MAX_CHANNELS) {
+        while (pairedDevices[channel].mailboxCount > 0) {
+            popMailbox(channel);
+        }
+    }
+}
+
+/**
+ * @brief Enable/disable radio operation
+ * 
+ * @param bool Target state (false=off, true=on)
+ */
+void RadioManager::enable(bool en) {
+    isEnabled = en;
+    if (!en) {
+        // Clear all mailboxes
+        for (int i = 0; i < MAX_CHANNELS; i++) {
+            clearMessages(i);
         }
+        // Stop listening to radio
+        radio.stopListening();
+    } else {
+        // Resume radio listening
+        radio.begin();
+    }
+}
+
+/**
+ * @brief Export the current configuration as a JSON string
+ * 
+ * @return The configuration as a JSON string
+ */
+String RadioManager::exportCfg() {
+    JsonDocument doc;
+    writeCfgJson(doc);
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+/**
+ * @brief Export the current configuration as JSON directly into a stream
+ * 
+ * Serializes without building the output string, e.g. straight into a File.
+ * 
+ * @param output The stream to write to
+ * @return The number of bytes written
+ */
+size_t RadioManager::exportCfg(Print& output) {
+    JsonDocument doc;
+    writeCfgJson(doc);
+    return serializeJson(doc, output);
+}
+
+/**
+ * @brief Import the configuration from a JSON string
+ * 
+ * @param jsonConfig The JSON string to import
+ * @return true if the import was successful, false otherwise
+ */
+bool RadioManager::importCfg(const String& jsonConfig) {
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, jsonConfig);
+
+    if (error) {
+        return false;
+    }
+    return readCfgJson(doc);
+}
+
+/**
+ * @brief Import the configuration as JSON directly from a stream
+ * 
+ * Parses without reading the input into a string first, e.g. straight from a File.
+ * 
+ * @param input The stream to read from
+ * @return true if the import was successful, false otherwise
+ */
+bool RadioManager::importCfg(Stream& input) {
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, input);
+
+    if (error) {
+        LOG_LN("Invalid configuration: " + String(error.c_str()));
+        return false;
     }
-    serializeJson(doc, addrList);
-    return addrList;
+    return readCfgJson(doc);
 }
 
 /**
- * @brief Sets the list of paired Addrs from a string
+ * @brief Fills a JSON document with the current configuration
  * 
- * @param addrJson A JSON string containing the list of Addrs & pubKeys to set, separated by commas.
- *                "0" represents an unpaired channel.
- * @return true if the operation was successful, false otherwise
+ * @param doc The document to fill
  */
-bool RadioManager::setPairedDevicesJson(const String& addrJson) {
-    JsonDocument doc;
-    deserializeJson(doc, addrJson);
+void RadioManager::writeCfgJson(JsonDocument& doc) {
+    // Export pairedAddr
+    writePairedDevicesJson(doc["pairedDevices"].to<JsonObject>(), true);
 
-    if (!doc["addr"].is<JsonArray>()) {
-        return false;
+    // Export personalKeys
+    char keyStr[Base64::encodedLength(KEY_SIZE) + 1];
+    Base64::encode(publicKey, KEY_SIZE, keyStr, sizeof(keyStr));
+    doc["personalKeys"]["publicKey"] = keyStr;
+    Base64::encode(privateKey, KEY_SIZE, keyStr, sizeof(keyStr));
+    doc["personalKeys"]["privateKey"] = keyStr;
+
+    // Export the agreed data channel, only once changed
+    if (agreedChannel != DATA_CHANNEL) {
+        doc["dataChannel"] = agreedChannel;
     }
+}
 
-    for (int i = 0; i < MAX_CHANNELS; i++) {
-        if (doc["addr"][i].isNull()) continue;
-        if (doc["addr"][i] == "0") {
-            clearPairedAddr(i);
-        } else {
-            String addr = doc["addr"][i].as<String>();
-            String pubKey = doc["pubKey"][i].as<String>();
-            Bytes pubKeyBytes = Base64::decode(pubKey);
-            setPairedAddr(addr, i, pubKeyBytes);
+/**
+ * @brief Applies the configuration held by a JSON document
+ * 
+ * @param doc The document to read
+ * @return true if the import was successful, false otherwise
+ */
+bool RadioManager::readCfgJson(JsonDocument& doc) {
+    // Import personalKeys
+    if (doc["personalKeys"].is<JsonObject>()) {
+        const char* pubKeyStr = doc["personalKeys"]["publicKey"] | "";
+        const char* privKeyStr = doc["personalKeys"]["privateKey"] | "";
+        Bytes pubKey(KEY_SIZE), privKey(KEY_SIZE);
+        Base64::Error pubError, privError;
+        size_t pubLen = Base64::decode(pubKeyStr, strlen(pubKeyStr), pubKey.data(), pubKey.size(), &pubError);
+        size_t privLen = Base64::decode(privKeyStr, strlen(privKeyStr), privKey.data(), privKey.size(), &privError);
+        if (pubLen != KEY_SIZE || privLen != KEY_SIZE) {
+            LOG_LN("Invalid personal keys: " + String(Base64::errorToStr(pubError)) + " / " + Base64::errorToStr(privError));
+            return false;
+        }
+        setPersonalKeys(pubKey, privKey);
+    }
+
+    // Import the agreed data channel
+    int rfChannel = doc["dataChannel"] | (int)DATA_CHANNEL;
+    if (rfChannel >= 0 && rfChannel < RadioChannelScan::CHANNEL_COUNT && rfChannel != agreedChannel) {
+        previousChannel = agreedChannel;
+        agreedChannel = rfChannel;
+        dataChannel = rfChannel;
+        if (isEnabled && currentState == IDLE) {
+            setRadioChannel(rfChannel);
         }
     }
 
-    // Reinitialize the radio to apply the new pairing configuration
-    initRadio();
+    // Import pairedAddr & keys (older exports embed them as a JSON string)
+    if (doc["pairedDevices"].is<JsonObjectConst>()) {
+        return readPairedDevicesJson(doc["pairedDevices"].as<JsonObjectConst>());
+    } else if (doc["pairedDevices"].is<const char*>()) {
+        return setPairedDevicesJson(doc["pairedDevices"].as<String>());
+    }
 
     return true;
 }
 
 /**
- * @brief Set personal public & private key (used for shared secret gen)
- * 
- * @param publicKey Reference to Bytes containing pub key
- * @param privateKey Reference to Bytes containing private key
+ * @brief Gets the configuration generation
  * 
- * @return True if keys set, false if invalid key(s)
+ * The generation is incremented each time the configuration changes (paired addresses,
+ * peer or personal keys, pairing completion, configuration import), so that the application
+ * only needs to save its configuration when this value differs from the last saved one.
  * 
+ * @return The current configuration generation
  */
-bool RadioManager::setPersonalKeys(const Bytes& publicKey, const Bytes& privateKey) {
-    if (publicKey.size() == KEY_SIZE && privateKey.size() == KEY_SIZE) {
-        memcpy(this->publicKey, publicKey.data(), KEY_SIZE);
-        memcpy(this->privateKey, privateKey.data(), KEY_SIZE);
-        return true;
-    }
-    return false;
+uint32_t RadioManager::getConfigGeneration() {
+    return configGeneration;
 }
 
 /**
- * @brief Get personal public & private keys (used for shared secret generation)
+ * @brief Sets a function called after each configuration change
  * 
- * @param publicKey Reference to Bytes to store the public key
- * @param privateKey Reference to Bytes to store the private key
+ * The callback runs from within the library (e.g. from loop() when pairing completes),
+ * so it should only record the change and let the application save it later.
  * 
- * This function copies the current personal public and private keys into the provided Bytes vectors.
- * The vectors will be resized to KEY_SIZE if necessary.
+ * @param callback Function receiving the new generation, or nullptr to remove it
  */
-void RadioManager::getPersonalKeys(Bytes& publicKey, Bytes& privateKey) {
-    publicKey.resize(KEY_SIZE);
-    privateKey.resize(KEY_SIZE);
-    memcpy(publicKey.data(), this->publicKey, KEY_SIZE);
-    memcpy(privateKey.data(), this->privateKey, KEY_SIZE);
+void RadioManager::onConfigChange(ConfigChangeCallback callback) {
+    configChangeCallback = callback;
 }
 
 /**
- * @brief Set paired channel public & shared keys (used for pairing & E2EE)
- * 
- * @param channel Pairing channel
- * @param publicKey Reference to Bytes containing pub key
+ * @brief Increments the configuration generation and notifies the change
+ */
+void RadioManager::bumpConfigGeneration() {
+    configGeneration++;
+    if (configChangeCallback) {
+        configChangeCallback(configGeneration);
+    }
+}
+
+/**
+ * @brief Export the current configuration as a binary snapshot
  * 
- * @return True if keys set, false if invalid key(s)
+ * The snapshot has a fixed size (CFG_BIN_SIZE) and holds personal keys, paired addresses,
+ * public & shared keys and encryption counters of every channel, protected by a CRC32.
  * 
+ * @param buffer Destination buffer (at least CFG_BIN_SIZE bytes)
+ * @param bufferSize Size of the destination buffer
+ * @return Number of bytes written, or 0 if the buffer is too small
  */
-bool RadioManager::setPairedDeviceKeys(uint8_t channel, const Bytes& publicKey) {
-    if (channel < MAX_CHANNELS) {
-        if (publicKey.size() == KEY_SIZE) {
-            uint8_t sharedKey[KEY_SIZE];
-            bool keyGen = generateX25519SharedKey(publicKey.data(), privateKey, sharedKey);
-            if (!keyGen) return false;
-            memcpy(this->pairedDevices[channel].publicKey, publicKey.data(), KEY_SIZE);
-            memcpy(this->pairedDevices[channel].sharedKey, sharedKey, KEY_SIZE);
-            this->pairedDevices[channel].chaObject.setKey(this->pairedDevices[channel].publicKey);
-            return true;
-        }
+size_t RadioManager::exportCfgBin(uint8_t* buffer, size_t bufferSize) {
+    if (buffer == nullptr || bufferSize < CFG_BIN_SIZE) {
+        return 0;
     }
-    return false;
+
+    CfgBinHeader header;
+    memcpy(header.magic, "RMCS", sizeof(header.magic));
+    header.version = CFG_BIN_VERSION;
+    header.channelCount = MAX_CHANNELS;
+    header.recordSize = sizeof(CfgBinPeer);
+    memcpy(header.publicKey, publicKey, KEY_SIZE);
+    memcpy(header.privateKey, privateKey, KEY_SIZE);
+    memcpy(buffer, &header, sizeof(header));
+
+    uint8_t* p = buffer + sizeof(header);
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        CfgBinPeer peer;
+        writeCfgBinPeer(i, peer);
+        memcpy(p, &peer, sizeof(peer));
+        p += sizeof(peer);
+    }
+
+    uint32_t crc = Crc32::compute(buffer, p - buffer);
+    memcpy(p, &crc, sizeof(crc));
+    return CFG_BIN_SIZE;
 }
 
 /**
- * @brief Generate X25519 shared key
+ * @brief Import the configuration from a binary snapshot
  * 
- * @param peerPublicKey Pointer to peer public key (KEY_SIZE)
- * @param privateKey Pointer to own private key (KEY_SIZE)
- * @param sharedKey Pointer to generated shared key (KEY_SIZE)
- * @return true if the key was generated, false otherwise
+ * The whole snapshot is validated (magic, version, record size, CRC32) before anything is
+ * applied. Keys are restored as-is, so no key exchange computation is needed.
+ * 
+ * @param buffer Snapshot produced by exportCfgBin()
+ * @param length Length of the snapshot
+ * @return true if the import was successful, false otherwise
  */
-bool RadioManager::generateX25519SharedKey(const uint8_t* peerPublicKey, const uint8_t* privateKey, uint8_t* sharedKey) {
-    mbedtls_ecdh_context ctx;
-    mbedtls_ecdh_init(&ctx);
-
-    int ret = mbedtls_ecp_group_load(&ctx.grp, MBEDTLS_ECP_DP_CURVE25519);
-    if (ret != 0) {
-        mbedtls_ecdh_free(&ctx);
+bool RadioManager::importCfgBin(const uint8_t* buffer, size_t length) {
+    CfgBinHeader header;
+    if (buffer == nullptr || length < sizeof(header) + sizeof(uint32_t)) {
         return false;
     }
-
-    ret = mbedtls_mpi_read_binary(&ctx.d, privateKey, KEY_SIZE);
-    if (ret != 0) {
-        mbedtls_ecdh_free(&ctx);
+    memcpy(&header, buffer, sizeof(header));
+    // Older versions have shorter peer records
+    if (memcmp(header.magic, "RMCS", sizeof(header.magic)) != 0 || header.version == 0 ||
+        header.version > CFG_BIN_VERSION || header.recordSize < CFG_BIN_PEER_V1_SIZE ||
+        header.recordSize > sizeof(CfgBinPeer)) {
+        LOG_LN("Invalid binary configuration header");
         return false;
     }
 
-    ret = mbedtls_ecp_point_read_binary(&ctx.grp, &ctx.Qp, peerPublicKey, KEY_SIZE);
-    if (ret != 0) {
-        mbedtls_ecdh_free(&ctx);
+    size_t dataSize = sizeof(header) + header.channelCount * header.recordSize;
+    uint32_t crc;
+    if (length < dataSize + sizeof(crc)) {
         return false;
     }
-
-    ret = mbedtls_ecdh_compute_shared(&ctx.grp, &ctx.z, &ctx.Qp, &ctx.d,
-                                      mbedtls_ctr_drbg_random, &ctr_drbg);
-    if (ret != 0) {
-        mbedtls_ecdh_free(&ctx);
+    memcpy(&crc, buffer + dataSize, sizeof(crc));
+    if (crc != Crc32::compute(buffer, dataSize)) {
+        LOG_LN("Binary configuration CRC mismatch");
         return false;
     }
 
-    ret = mbedtls_mpi_write_binary(&ctx.z, sharedKey, KEY_SIZE);
-    if (ret != 0) {
-        mbedtls_ecdh_free(&ctx);
-        return false;
+    // Import personalKeys
+    memcpy(publicKey, header.publicKey, KEY_SIZE);
+    memcpy(privateKey, header.privateKey, KEY_SIZE);
+
+    // Import pairedAddr & keys (channels beyond the snapshot are cleared)
+    const uint8_t* p = buffer + sizeof(header);
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        CfgBinPeer peer;
+        if (i >= header.channelCount) {
+            clearPairedAddr(i);
+            continue;
+        }
+        peer.sourceId = NO_SOURCE_ID;
+        memcpy(&peer, p, header.recordSize);
+        p += header.recordSize;
+        readCfgBinPeer(i, peer);
     }
+    bumpConfigGeneration();
+
+    // Reinitialize the radio to apply the new pairing configuration
+    initRadio();
 
-    mbedtls_ecdh_free(&ctx);
     return true;
 }
 
 /**
- * @brief Gets the radio module ID
+ * @brief Save the current configuration into a persistent store
  * 
- * @return The radio module ID as a String
+ * Personal keys and each paired device are separate records, and the store only appends
+ * the records that changed since the last save (e.g. the newly paired device).
+ * 
+ * @param store An opened RadioStore
+ * @return true if all records were saved, false otherwise
  */
-String RadioManager::getRadioID() {
-    return radioID;
+bool RadioManager::exportCfg(RadioStore& store) {
+    uint8_t keys[2 * KEY_SIZE];
+    memcpy(keys, publicKey, KEY_SIZE);
+    memcpy(keys + KEY_SIZE, privateKey, KEY_SIZE);
+    bool success = store.put(CFG_STORE_PERSONAL_KEYS, 0, keys, sizeof(keys));
+
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        CfgBinPeer peer;
+        writeCfgBinPeer(i, peer);
+        if (peer.flags & CFG_PEER_PAIRED) {
+            success &= store.put(CFG_STORE_PEER, i, &peer, sizeof(peer));
+        } else {
+            success &= store.remove(CFG_STORE_PEER, i);
+        }
+    }
+    return success;
 }
 
 /**
- * @brief Check validity of a given address
+ * @brief Load the configuration from a persistent store
  * 
- * @param addr The address to be checked
- * @return true if the address is valid, false otherwise
+ * @param store An opened RadioStore
+ * @return true if the import was successful, false if the store holds no configuration
  */
-bool RadioManager::checkValidAddr(String& addr) {
-    // Check if address is encoded on 5 characters
-    if (addr.length() != 5) {
+bool RadioManager::importCfg(RadioStore& store) {
+    uint8_t keys[2 * KEY_SIZE];
+    if (store.get(CFG_STORE_PERSONAL_KEYS, 0, keys, sizeof(keys)) != sizeof(keys)) {
         return false;
     }
 
-    // Check if 1st char is a number [0,5]
-    char firstChar = addr.charAt(0);
-    if (firstChar < '0' || firstChar > '5') {
-        return false;
-    }
+    // Import personalKeys
+    memcpy(publicKey, keys, KEY_SIZE);
+    memcpy(privateKey, keys + KEY_SIZE, KEY_SIZE);
 
-    // Check if last 4 char are alphanumeric
-    for (int i = 1; i < 5; i++) {
-        if (!isAlphaNumeric(addr.charAt(i))) {
-            return false;
+    // Import pairedAddr & keys
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        CfgBinPeer peer;
+        peer.sourceId = NO_SOURCE_ID;
+        if (store.get(CFG_STORE_PEER, i, &peer, sizeof(peer)) >= (int)CFG_BIN_PEER_V1_SIZE) {
+            readCfgBinPeer(i, peer);
+        } else {
+            clearPairedAddr(i);
         }
     }
+    bumpConfigGeneration();
+
+    // Reinitialize the radio to apply the new pairing configuration
+    initRadio();
 
-    // Valid if fell through all checks
     return true;
 }
 
 /**
- * @brief Check if UID exists in paired devices and unpair corresponding address
+ * @brief Fills the binary configuration record of a channel
  * 
- * @param uid The 4-character UID to be unpaired
- * @return true if an address was unpaired, false otherwise
+ * @param channel The channel number
+ * @param peer Receives the record
  */
-bool RadioManager::clearPairedUID(String& uid) {
-    bool ret = false;
-    for (int i=0 ; i<MAX_CHANNELS ; i++) {
-        String testUID = getPairedUID(i);
-        if (testUID == uid) {
-            clearPairedAddr(i);
-            ret = true;
-            break;
+void RadioManager::writeCfgBinPeer(uint8_t channel, CfgBinPeer& peer) {
+    static const uint8_t ZERO_KEY[KEY_SIZE] = {0};
+    memset(&peer, 0, sizeof(peer));
+    peer.sourceId = NO_SOURCE_ID;
+    const PairedDevice& device = pairedDevices[channel];
+    if (!device.addr.isEmpty()) {
+        memcpy(peer.addr, device.addr.bytes(), sizeof(peer.addr));
+        peer.flags = CFG_PEER_PAIRED;
+        peer.sourceId = device.sourceId;
+        if (memcmp(device.publicKey, ZERO_KEY, KEY_SIZE) != 0) {
+            peer.flags |= CFG_PEER_HAS_KEY;
+            memcpy(peer.publicKey, device.publicKey, KEY_SIZE);
+            memcpy(peer.sharedKey, device.sharedKey, KEY_SIZE);
+            peer.encryptCounter = device.chaObject.getEncryptCounter();
+            peer.decryptCounter = device.chaObject.getDecryptCounter();
         }
     }
-    return ret;
 }
 
 /**
- * @brief Set the public key for a paired device
+ * @brief Applies the binary configuration record of a channel
  * 
- * @param channel The channel number of the paired device
- * @param newPublicKey Pointer to the new public key
+ * @param channel The channel number
+ * @param peer The record to apply
  */
-void RadioManager::setDevicePublicKey(uint8_t channel, const uint8_t* newPublicKey) {
-    if (channel < MAX_CHANNELS) {
-        memcpy(pairedDevices[channel].publicKey, newPublicKey, KEY_SIZE);
+void RadioManager::readCfgBinPeer(uint8_t channel, const CfgBinPeer& peer) {
+    if (!(peer.flags & CFG_PEER_PAIRED)) {
+        clearPairedAddr(channel);
+        return;
+    }
+    String addr(peer.addr, sizeof(peer.addr));
+    setPairedAddr(addr, channel);
+    pairedDevices[channel].sourceId = peer.sourceId;
+    if (peer.flags & CFG_PEER_HAS_KEY) {
+        setDevicePublicKey(channel, peer.publicKey);
+        setDeviceSharedKey(channel, peer.sharedKey);
+        pairedDevices[channel].chaObject.setCounters(peer.encryptCounter, peer.decryptCounter);
     }
 }
 
 /**
- * @brief Set the shared key for a paired device and update the chaObject
+ * @brief Count a lost message or fragment in the global & peer statistics
  * 
- * @param channel The channel number of the paired device
- * @param newSharedKey Pointer to the new shared key
+ * @param channel Channel of the paired device (ignored for peer statistics if invalid)
+ * @param reason Reason of the drop
  */
-void RadioManager::setDeviceSharedKey(uint8_t channel, const uint8_t* newSharedKey) {
+void RadioManager::countDrop(uint8_t channel, RadioStats::DropReason reason) {
+    globalStats.drops[reason]++;
     if (channel < MAX_CHANNELS) {
-        memcpy(pairedDevices[channel].sharedKey, newSharedKey, KEY_SIZE);
-        pairedDevices[channel].chaObject.setKey(newSharedKey);
+        pairedDevices[channel].stats.drops[reason]++;
     }
 }
 
 /**
- * @brief Encrypt a message using the chaObject of the specified channel
+ * @brief Gets the statistics of a paired device
  * 
- * @param channel The channel number to use for encryption
- * @param message The message to encrypt
- * @return The encrypted message as a vector of bytes, or an empty vector if encryption fails
+ * @param channel The channel number
+ * @return Reference to the statistics of the channel (all zeros if the channel is invalid)
  */
-Bytes RadioManager::encryptMessage(uint8_t channel, const Bytes& message) {
+const RadioStats& RadioManager::getStats(uint8_t channel) {
+    static RadioStats emptyStats = RadioStats();
     if (channel < MAX_CHANNELS) {
-        return pairedDevices[channel].chaObject.encrypt(message);
+        pairedDevices[channel].stats.paLevel = getPALevel(channel);
+        return pairedDevices[channel].stats;
     }
-    return Bytes();
+    return emptyStats;
 }
 
 /**
- * @brief Decrypt a message using the chaObject of the specified channel
+ * @brief Gets the statistics of all traffic, including unpaired addresses
  * 
- * @param channel The channel number to use for decryption
- * @param encryptedMessage The encrypted message to decrypt
- * @return The decrypted message as a vector of bytes, or an empty vector if decryption fails
+ * @return Reference to the global statistics
  */
-Bytes RadioManager::decryptMessage(uint8_t channel, const Bytes& encryptedMessage) {
-    if (channel < MAX_CHANNELS) {
-        return pairedDevices[channel].chaObject.decrypt(encryptedMessage);
-    }
-    return Bytes();
+const RadioStats& RadioManager::getGlobalStats() {
+    return globalStats;
 }
 
 /**
- * @brief Add padding to message (fill with 0s)
- * 
- * @param payload Reference to payload Bytes
- * @param paddingSize Padding size in bytes
+ * @brief Resets the global statistics and those of all paired devices
  */
-void RadioManager::pad(Bytes& payload, size_t paddingSize) {
-    if (payload.size() < paddingSize) {
-        size_t paddingToAdd = paddingSize - payload.size();
-        payload.insert(payload.end(), paddingToAdd, 0);
-    } else if (payload.size() > paddingSize) {
-        payload.resize(paddingSize);
+void RadioManager::resetStats() {
+    globalStats.reset();
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        pairedDevices[i].stats.reset();
     }
 }
 
 /**
- * @brief Remove padding from message (end 0s)
+ * @brief Resets the statistics of a paired device
  * 
- * @param payload Reference to payload vector
+ * @param channel The channel number
  */
-void RadioManager::unpad(Bytes& payload) {
-    while (!payload.empty() && payload.back() == 0) {
-        payload.pop_back();
+void RadioManager::resetStats(uint8_t channel) {
+    if (channel < MAX_CHANNELS) {
+        pairedDevices[channel].stats.reset();
     }
 }
 
 /**
- * @brief Clear all messages in inbox
+ * @brief Gets the data rate used to send to a paired device
  * 
- * @param channel Channel number
+ * @param channel The channel number
+ * @return The data rate (RF24_250KBPS if the channel is invalid)
  */
-void RadioManager::clearMessages(uint8_t channel) {
-    if (channel < MAX_CHANNELS) {
-        pairedDevices[channel].mailbox.clear();
-    }
+rf24_datarate_e RadioManager::getDataRate(uint8_t channel) {
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+    return rateForLevel(channel < MAX_CHANNELS ? pairedDevices[channel].txRate : 0);
+#else
+    (void)channel;
+    return rateForLevel(0);
+#endif
 }
 
 /**
- * @brief Enable/disable radio operation
+ * @brief Gets the data rate the radio listens at, the slowest one asked by the paired devices
  * 
- * @param bool Target state (false=off, true=on)
+ * @return The data rate
  */
-void RadioManager::enable(bool en) {
-    isEnabled = en;
-    if (!en) {
-        // Clear all mailboxes
-        for (int i = 0; i < MAX_CHANNELS; i++) {
-            clearMessages(i);
-        }
-        // Stop listening to radio
-        radio.stopListening();
-    } else {
-        // Resume radio listening
-        radio.begin();
-    }
+rf24_datarate_e RadioManager::getListenRate() {
+    return rateForLevel(listenRate);
 }
 
 /**
- * @brief Export the current configuration as a JSON string
+ * @brief Gets the PA level used to send to a paired device
  * 
- * @return The configuration as a JSON string
+ * @param channel The channel number
+ * @return The PA level (RF24_PA_MAX if the channel is invalid)
  */
-String RadioManager::exportCfg() {
-    JsonDocument doc;
-    // Export pairedAddr
-    doc["pairedDevices"] = getPairedDevicesJson();
-
-    // Export personalKeys
-    Bytes pubKey, privKey;
-    getPersonalKeys(pubKey, privKey);
-    doc["personalKeys"]["publicKey"] = Base64::encode(pubKey.data(), pubKey.size());
-    doc["personalKeys"]["privateKey"] = Base64::encode(privKey.data(), privKey.size());
-
-    String output;
-    serializeJson(doc, output);
-    return output;
+rf24_pa_dbm_e RadioManager::getPALevel(uint8_t channel) {
+#ifdef RADIO_MANAGER_ADAPTIVE_POWER
+    return (rf24_pa_dbm_e)(channel < MAX_CHANNELS ? pairedDevices[channel].paLevel : (uint8_t)RF24_PA_MAX);
+#else
+    (void)channel;
+    return RF24_PA_MAX;
+#endif
 }
 
 /**
- * @brief Import the configuration from a JSON string
+ * @brief Gets the message buffer pool, e.g. to read its usage and high-water marks
  * 
- * @param jsonConfig The JSON string to import
- * @return true if the import was successful, false otherwise
+ * @return Reference to the pool (owners are the channels, and MAX_CHANNELS for the outgoing message)
  */
-bool RadioManager::importCfg(const String& jsonConfig) {
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, jsonConfig);
+const RadioBufferPool& RadioManager::getBufferPool() {
+    return bufferPool;
+}
 
-    if (error) {
+/**
+ * @brief Sets the maximum amount of pool memory used by a paired device (mailbox + message being received)
+ * 
+ * @param channel The channel number
+ * @param bytes Quota in bytes, rounded up to whole blocks (capped to the pool size)
+ * @return true if the quota was set, false if the channel is invalid or begin() didn't allocate the pool yet
+ */
+bool RadioManager::setPeerQuota(uint8_t channel, size_t bytes) {
+    if (channel >= MAX_CHANNELS || poolData == nullptr) {
         return false;
     }
+    size_t blocks = RadioBufferPool::blocksFor(bytes);
+    bufferPool.setQuota(channel, blocks < Config::POOL_BLOCKS ? blocks : Config::POOL_BLOCKS);
+    return true;
+}
 
-    // Import personalKeys
-    if (doc["personalKeys"].is<JsonObject>()) {
-        String pubKeyStr = doc["personalKeys"]["publicKey"];
-        String privKeyStr = doc["personalKeys"]["privateKey"];
-        Bytes pubKey, privKey;
-        Base64::decode(pubKeyStr, pubKey);
-        Base64::decode(privKeyStr, privKey);
-        setPersonalKeys(pubKey, privKey);
-    }
+/**
+ * @brief Sets a sink receiving a copy of every radio frame sent or received
+ * 
+ * @param sink Pointer to the capture ring buffer, or nullptr to stop capturing
+ */
+void RadioManager::setCaptureSink(RadioCapture* sink) {
+    captureSink = sink;
+}
 
-    // Import pairedAddr & keys
-    if (doc["pairedDevices"].is<JsonObject>()) {
-        String pairedAddrJson = doc["pairedDevices"].as<String>();
-        setPairedDevicesJson(pairedAddrJson);
-    }
+#ifdef RADIO_MANAGER_TRACE
+/**
+ * @brief Gets the binary event trace, to be drained by the application
+ * 
+ * @return Reference to the trace ring buffer
+ */
+RadioTrace& RadioManager::getTrace() {
+    return trace;
+}
+#endif
 
-    return true;
-}
\ No newline at end of file
+#ifdef RADIO_MANAGER_PROFILE
+/**
+ * @brief Gets the execution-time profiler, e.g. to dump it on demand
+ * 
+ * @return Reference to the profiler
+ */
+RadioProfiler& RadioManager::getProfiler() {
+    return profiler;
+}
+#endif
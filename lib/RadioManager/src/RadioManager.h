@@ -10,6 +10,24 @@
 #include <Base64.h>
 #include <SimpleCha2.h>
 #include <ArduinoJson.h>
+#include <RadioStats.h>
+#include <RadioCapture.h>
+#include <Crc32.h>
+#include <RadioStore.h>
+#include <RadioConfig.h>
+#include <RadioAddress.h>
+#include <RadioPeerIndex.h>
+#include <RadioBufferPool.h>
+#include <RadioAllocator.h>
+#include <RadioChannelScan.h>
+#include <RadioHopper.h>
+
+#ifdef RADIO_MANAGER_TRACE
+    #include <RadioTrace.h>
+#endif
+#ifdef RADIO_MANAGER_PROFILE
+    #include <RadioProfiler.h>
+#endif
 
 // Ajoutez cette ligne
 using Bytes = std::vector<uint8_t>;
@@ -23,21 +41,122 @@ public:
         TRANSMITTING,
         RECEIVING,
         PAIRING_LISTEN,
-        PAIRING_TRANSMIT
+        PAIRING_TRANSMIT,
+        SCANNING
     };
 
+    // Source id of a peer that identifies us by pipe (no source id in our fragment headers)
+    static const uint8_t NO_SOURCE_ID = 255;
+    // Credits of a peer that never advertised them: no flow control
+    static const uint8_t CREDIT_UNKNOWN = 255;
+
     struct PairedDevice {
-        String addr;
-        std::vector<Bytes> mailbox;
+        RadioAddress addr;
+        uint8_t sourceId; // Our slot at the peer (sent in fragment headers), NO_SOURCE_ID if the peer uses pipes
+        RadioBufferPool::Chain mailbox[RadioManagerConfig::MAILBOX_DEPTH]; // FIFO ring, messages stored in the shared pool
+        uint8_t mailboxHead;
+        uint8_t mailboxCount;
         uint8_t sharedKey[KEY_SIZE];
         uint8_t publicKey[KEY_SIZE];
         SimpleCha2 chaObject;
+        RadioStats stats;
+
+        // Reassembly of the message being received from this device
+        RadioBufferPool::Chain rxBuffer;
+        bool rxDropped; // Out of buffers, the rest of the message is ignored
+        uint16_t expectedFragments;
+        uint16_t receivedFragments;
+        unsigned long lastReceiveTime;
+        unsigned long rxStartTime;
+
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+        // Data rate of the link (rate levels)
+        uint8_t txRate;          // Rate the device listens at, as far as we know
+        uint8_t rxRate;          // Rate the device asked us to listen at
+        uint16_t retryAverage;   // Moving average of the retransmissions per fragment, x16
+        uint16_t cleanFragments; // Consecutive fragments sent with at most 1 retransmission
+        uint16_t rateHoldoff;    // Fragments to send before trying a faster rate again
+        uint8_t rxRateFallback;  // Rate to listen at again if the device doesn't confirm rxRate, RATE_LEVELS once confirmed
+        unsigned long rxRateTime; // millis() of the request for a faster rxRate
+#endif
+
+#ifdef RADIO_MANAGER_ADAPTIVE_POWER
+        // Transmit power of the link
+        uint8_t paLevel;          // PA level used to send to the device (rf24_pa_dbm_e)
+        uint8_t paFloor;          // Lowest PA level allowed, raised after retransmissions (margin)
+        uint8_t rpd;              // Power of the last fragment received from the device (RPD_*)
+        uint16_t quietFragments;  // Consecutive fragments sent without retransmission
+        uint16_t floorHoldoff;    // Fragments without retransmission before lowering paFloor
+#endif
+
+#ifdef RADIO_MANAGER_HOPPING
+        // Frequency hopping, when we coordinate it
+        bool hopSynced;            // The device acknowledged the hop key and slot counter
+        unsigned long hopSyncTime; // millis() of the last synchronisation attempt
+#endif
+
+#ifdef RADIO_MANAGER_TIME_SYNC
+        // Clock of the device, device micros() = ours + offset + drift
+        bool clockValid;
+        int32_t clockOffset;      // us, at clockTime
+        int32_t clockDrift;       // Parts per billion, device clock rate minus ours
+        uint32_t clockTime;       // Our micros() at the last estimate
+        uint32_t clockRoundTrip;  // us, of the last exchange
+        uint32_t clockRequest;    // Our micros() when the pending request was sent
+#endif
 
-        PairedDevice() : chaObject(sharedKey) {}
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+        // Room left at the device for our messages, CREDIT_UNKNOWN until advertised
+        uint8_t creditSlots;
+        uint16_t creditBytes;
+#endif
+
+        PairedDevice() : sourceId(NO_SOURCE_ID), mailboxHead(0), mailboxCount(0), chaObject(sharedKey),
+                         rxDropped(false), expectedFragments(0), receivedFragments(0),
+                         lastReceiveTime(0), rxStartTime(0) {
+            stats.reset();
+            resetFeatures();
+        }
+
+        // Resets the state of the optional features (link adaptation, hopping, clock, credits)
+        void resetFeatures() {
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+            txRate = 0;
+            rxRate = 0;
+            retryAverage = 0;
+            cleanFragments = 0;
+            rateHoldoff = 0;
+            rxRateFallback = RATE_LEVELS;
+            rxRateTime = 0;
+#endif
+#ifdef RADIO_MANAGER_ADAPTIVE_POWER
+            paLevel = RF24_PA_MAX;
+            paFloor = RF24_PA_MIN;
+            rpd = RPD_UNKNOWN;
+            quietFragments = 0;
+            floorHoldoff = 0;
+#endif
+#ifdef RADIO_MANAGER_HOPPING
+            hopSynced = false;
+            hopSyncTime = 0;
+#endif
+#ifdef RADIO_MANAGER_TIME_SYNC
+            clockValid = false;
+            clockOffset = 0;
+            clockDrift = 0;
+            clockTime = 0;
+            clockRoundTrip = 0;
+            clockRequest = 0;
+#endif
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+            creditSlots = CREDIT_UNKNOWN;
+            creditBytes = 0;
+#endif
+        }
     };
 
     // Utility functions
-    RadioManager(uint8_t ce_pin, uint8_t csn_pin, const char* radio_id);
+    RadioManager(uint8_t ce_pin, uint8_t csn_pin, const char* radio_id, RadioAllocator* allocator = nullptr);
     bool begin();
     void loop();
     State getCurrentState();
@@ -50,14 +169,20 @@ public:
     // Message functions
     uint8_t isMsgAvailable(uint8_t channel);
     Bytes readMsg(uint8_t channel);
+    size_t readMsg(uint8_t channel, uint8_t* buffer, size_t size);
+    size_t getMsgSize(uint8_t channel);
     void clearMessages(uint8_t channel);
+    bool sendMsg(const uint8_t* msg, size_t length, uint8_t channel, uint8_t* status = nullptr, bool encryption = false);
     bool sendMsg(const Bytes& msg, uint8_t channel, uint8_t* status = nullptr, bool encryption = false);
     bool sendMsg(const String& msg, uint8_t channel, uint8_t* status = nullptr, bool encryption = false);
+    bool sendMsgToAddr(const uint8_t* msg, size_t length, const String& targetAddr, uint8_t* status = nullptr, bool encryption = false);
     bool sendMsgToAddr(const Bytes& msg, const String& targetAddr, uint8_t* status = nullptr, bool encryption = false);
     bool sendMsgToAddr(const String& msg, const String& targetAddr, uint8_t* status = nullptr, bool encryption = false);
 
     // Pairing functions
-    static const uint8_t MAX_CHANNELS = 5;
+    typedef RadioManagerConfig Config;
+    static const uint8_t MAX_CHANNELS = Config::MAX_PEERS; // Peers share the reading pipes in gateway mode
+    static const uint8_t PIPE_COUNT = Config::PIPE_COUNT;
     uint8_t getAvailableChannel();
     String getPairedAddr(uint8_t channel);
     String getPairedUID(uint8_t channel);
@@ -72,6 +197,11 @@ public:
     String getPairedDevicesJson(bool keys = true);
     bool setPairedDevicesJson(const String& addrJson);
 
+    // Configuration change tracking
+    typedef void (*ConfigChangeCallback)(uint32_t generation);
+    uint32_t getConfigGeneration();
+    void onConfigChange(ConfigChangeCallback callback);
+
     // Encryption functions
     bool setPairedDeviceKeys(uint8_t channel, const Bytes& publicKey);
     bool setPersonalKeys(const Bytes& publicKey, const Bytes& privateKey);
@@ -83,26 +213,247 @@ public:
 
     // Configuration functions
     String exportCfg();
+    size_t exportCfg(Print& output);
     bool importCfg(const String& jsonConfig);
+    bool importCfg(Stream& input);
+
+    // Binary configuration snapshot (little-endian): header, one record per channel, CRC32 of all previous bytes
+    struct CfgBinHeader {
+        char magic[4];              // "RMCS"
+        uint8_t version;            // CFG_BIN_VERSION
+        uint8_t channelCount;       // Number of peer records
+        uint16_t recordSize;        // sizeof(CfgBinPeer)
+        uint8_t publicKey[KEY_SIZE];
+        uint8_t privateKey[KEY_SIZE];
+    } __attribute__((packed));
+
+    // Fields are only appended, records of older versions are a prefix of the current one
+    struct CfgBinPeer {
+        char addr[5];               // Paired address, zeros if unpaired
+        uint8_t flags;              // CFG_PEER_PAIRED | CFG_PEER_HAS_KEY
+        uint8_t publicKey[KEY_SIZE];
+        uint8_t sharedKey[KEY_SIZE];
+        uint32_t encryptCounter;
+        uint32_t decryptCounter;
+        uint8_t sourceId;           // Version 2: our slot at the peer, NO_SOURCE_ID if none
+    } __attribute__((packed));
+
+    static const uint8_t CFG_BIN_VERSION = 2;
+    static const size_t CFG_BIN_PEER_V1_SIZE = sizeof(CfgBinPeer) - 1;
+    static const uint8_t CFG_PEER_PAIRED = 0x01;
+    static const uint8_t CFG_PEER_HAS_KEY = 0x02;
+    static const size_t CFG_BIN_SIZE = sizeof(CfgBinHeader) + MAX_CHANNELS * sizeof(CfgBinPeer) + sizeof(uint32_t);
+
+    size_t exportCfgBin(uint8_t* buffer, size_t bufferSize);
+    bool importCfgBin(const uint8_t* buffer, size_t length);
+
+    // Persistent store records: personal keys (key 0) and one CfgBinPeer per channel (key = channel).
+    // Shorter CfgBinPeer records written by older versions are accepted.
+    static const uint8_t CFG_STORE_PERSONAL_KEYS = 1;
+    static const uint8_t CFG_STORE_PEER = 2;
+    static_assert(MAX_CHANNELS + 1 <= RadioStore::MAX_ENTRIES, "RadioStore too small for the configuration");
+    static_assert(sizeof(CfgBinPeer) <= RadioStore::MAX_VALUE_SIZE, "CfgBinPeer too large for a RadioStore record");
+
+    bool exportCfg(RadioStore& store);
+    bool importCfg(RadioStore& store);
+
+    // Statistics functions
+    const RadioStats& getStats(uint8_t channel);
+    const RadioStats& getGlobalStats();
+    void resetStats();
+    void resetStats(uint8_t channel);
+
+    // Data rate functions
+    rf24_datarate_e getDataRate(uint8_t channel);
+    rf24_datarate_e getListenRate();
+
+    // Transmit power functions
+    rf24_pa_dbm_e getPALevel(uint8_t channel);
+
+    // RF channel functions
+    bool startScan(uint8_t sweeps = 20, bool select = true);
+    const RadioChannelScan& getChannelScan();
+    bool setDataChannel(uint8_t rfChannel);
+    uint8_t getDataChannel();
+
+    // Frequency hopping functions
+    bool startHopping();
+    bool stopHopping();
+    bool isHopping();
+
+    // TDMA functions
+    bool startTdma();
+    bool followTdma(uint8_t channel);
+    void stopTdma();
+    uint8_t getTdmaSlot();
+
+    // Clock synchronisation functions
+    bool syncClock(uint8_t channel);
+    bool isClockSynced(uint8_t channel);
+    int32_t getClockOffset(uint8_t channel);
+    int32_t getClockDrift(uint8_t channel);
+    uint32_t getClockRoundTrip(uint8_t channel);
+    uint32_t toPeerMicros(uint8_t channel, uint32_t localMicros);
+    uint32_t fromPeerMicros(uint8_t channel, uint32_t peerMicros);
+
+    // Ack payload functions
+    static const uint8_t ACK_PAYLOAD_SIZE = Config::ACK_PAYLOAD_SIZE;
+    bool setAckPayload(uint8_t channel, const uint8_t* data, uint8_t length);
+    bool isAckPayloadPending(uint8_t channel);
+    uint8_t readAckPayload(uint8_t channel, uint8_t* buffer, uint8_t size);
+
+    // Stream functions
+    static const uint8_t STREAM_PAYLOAD_SIZE = Config::STREAM_PAYLOAD_SIZE;
+    typedef void (*StreamCallback)(uint8_t channel, const uint8_t* data, uint8_t length);
+    bool sendStream(uint8_t channel, const uint8_t* data, uint8_t length);
+    bool flushStream(uint8_t channel);
+    void onStream(StreamCallback callback);
+
+    // Flow control functions
+    uint8_t getCreditSlots(uint8_t channel);
+    uint16_t getCreditBytes(uint8_t channel);
+
+    // Buffer pool functions
+    const RadioBufferPool& getBufferPool();
+    bool setPeerQuota(uint8_t channel, size_t bytes);
+
+    // Capture functions
+    void setCaptureSink(RadioCapture* sink);
+
+#ifdef RADIO_MANAGER_TRACE
+    // Trace functions
+    RadioTrace& getTrace();
+#endif
+
+#ifdef RADIO_MANAGER_PROFILE
+    // Profiler functions
+    RadioProfiler& getProfiler();
+#endif
 
 private:
 
     // Utility functions
-    bool checkValidAddr(String& addr);
-    void pad(Bytes& payload, size_t paddingSize);
-    void unpad(Bytes& payload);
+    bool checkValidAddr(const char* addr);
+    bool splitPairingAddr(const char* pairingAddr, RadioAddress& addr, uint8_t& sourceId);
+    String formatPairedAddr(uint8_t channel);
+    size_t formatPairingID(uint8_t channel, bool unpair, char* pairingID);
+    void pipeAddress(uint8_t pipe, uint8_t* address);
+    static uint8_t channelPipe(uint8_t channel);
+    void pad(uint8_t* payload, size_t length, size_t paddingSize);
+    size_t unpad(const uint8_t* payload, size_t length);
 
     // Radio functions
     void initRadio();
+    bool allocateBuffers();
+    void resumeListening();
+    void setRadioRate(uint8_t level);
+    void updateListenRate();
+    static rf24_datarate_e rateForLevel(uint8_t level);
+    void setRadioPower(uint8_t level);
+    void setLinkRadio(uint8_t channel);
+    uint8_t buildControlFrame(uint8_t channel, uint8_t code, uint8_t sourceCode, uint16_t value);
+    void handleControlFrame(uint8_t channel, uint8_t code, uint16_t value, const uint8_t* payload, uint8_t length);
+#ifdef RADIO_MANAGER_CHANNEL_SCAN
+    void scanStep();
+#endif
+    void setRadioChannel(uint8_t rfChannel);
+    void switchChannel(uint8_t rfChannel, uint8_t reason);
+    void agreeChannel(uint8_t rfChannel, uint8_t reason);
+    bool fallbackChannel(uint8_t length);
+    void checkRendezvous();
+    void noteContact(uint8_t channel);
+#ifdef RADIO_MANAGER_LBT
+    bool clearToSend();
+#endif
+#ifdef RADIO_MANAGER_TIME_SYNC
+    bool writeTimestamps(uint8_t channel, uint16_t kind, const uint32_t* stamps, uint8_t count);
+    void handleTimestamps(uint8_t channel, uint16_t kind, const uint8_t* payload, uint8_t length);
+#endif
+#ifdef RADIO_MANAGER_TDMA
+    uint8_t tdmaWindow();
+    void checkBeacon();
+    void sendBeacon();
+    void handleBeacon(const uint8_t* payload, uint8_t length, uint16_t frameCount);
+    void waitForSlot();
+#endif
+    uint8_t listenChannel();
+#ifdef RADIO_MANAGER_HOPPING
+    void checkHopping();
+    bool syncHopPeer(uint8_t channel);
+    bool writeHopKey(uint8_t channel);
+    bool writeHopSync(uint8_t channel, bool stop);
+    void handleHopKey(uint8_t channel, const uint8_t* payload, uint8_t length);
+    void handleHopSync(uint8_t channel, uint16_t elapsed, const uint8_t* payload, uint8_t length);
+#endif
+#ifdef RADIO_MANAGER_ADAPTIVE_POWER
+    void trackPower(uint8_t channel, uint8_t retries);
+    bool boostPower(uint8_t channel, uint8_t length);
+    void setPeerPower(uint8_t channel, uint8_t level, uint8_t reason);
+#endif
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+    void handleRateFrame(uint8_t channel, uint8_t level);
+    void trackRetries(uint8_t channel, uint8_t retries);
+    void adaptRate(uint8_t channel, bool failed);
+    void confirmRate(uint8_t channel);
+    void checkRate();
+    bool probeRate(uint8_t channel, uint8_t length);
+#endif
     void handlePairing();
+    bool readPairingAddr(char* address);
+    size_t encryptPairingID(bool unpair);
     void receiveData(uint8_t pipe_num);
+    void expireReassembly();
     void sendData();
+    bool startSending(const uint8_t* msg, size_t length, const RadioAddress& target, uint8_t channel, uint8_t* status, bool encryption);
+    uint8_t findChannel(const RadioAddress& addr);
+    void countDrop(uint8_t channel, RadioStats::DropReason reason);
+    void openWritingPipe(const uint8_t* address);
+    bool writeFrame(const void* buf, uint8_t len, uint8_t pipe, bool multicast = false);
+    void readFrame(void* buf, uint8_t len, uint8_t pipe, uint8_t flags = 0);
+    uint8_t payloadSize();
+#ifdef RADIO_MANAGER_ACK_PAYLOAD
+    bool pipeShared(uint8_t channel);
+    void loadAckPayloads(bool reload);
+    uint8_t buildAckPayload(uint8_t channel, uint8_t* payload);
+    void ackPayloadSent(uint8_t pipe);
+    void readAckPayloads(uint8_t pipe);
+    void handleAckPayload(uint8_t channel, const uint8_t* payload, uint8_t length);
+#endif
+#ifdef RADIO_MANAGER_STREAM
+    void openStream(uint8_t channel);
+    void writeStreamParity(uint8_t channel);
+    void handleStream(uint8_t channel, uint16_t index, const uint8_t* payload, uint8_t length);
+    void closeStreamBlock(uint8_t channel, uint16_t nextBlock);
+#endif
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+    bool waitForCredit();
+    void writeCredits(uint8_t channel, uint8_t* credits);
+    void readCredits(uint8_t channel, const uint8_t* credits);
+#endif
+    bool appendFragment(uint8_t channel, const uint8_t* data, size_t length);
+    void pushMailbox(uint8_t channel, RadioBufferPool::Chain& msg);
+    void popMailbox(uint8_t channel);
 
     // Encryption functions
-    Bytes encryptMessage(uint8_t channel, const Bytes& message);
-    Bytes decryptMessage(uint8_t channel, const Bytes& encryptedMessage);
+    bool encryptMessage(uint8_t channel, const uint8_t* message, size_t length, RadioBufferPool::Chain& encryptedMessage);
+    bool decryptMessage(uint8_t channel, RadioBufferPool::Chain& message);
     void setDevicePublicKey(uint8_t channel, const uint8_t* newPublicKey);
     void setDeviceSharedKey(uint8_t channel, const uint8_t* newSharedKey);
+#ifdef RADIO_MANAGER_SMALL_NODE
+    static int hardwareEntropy(void* context, unsigned char* output, size_t length);
+#endif
+
+    // Configuration functions
+    void writePairedDevicesJson(JsonObject devices, bool keys);
+    bool readPairedDevicesJson(JsonObjectConst devices);
+    void writeCfgJson(JsonDocument& doc);
+    bool readCfgJson(JsonDocument& doc);
+    void writeCfgBinPeer(uint8_t channel, CfgBinPeer& peer);
+    void readCfgBinPeer(uint8_t channel, const CfgBinPeer& peer);
+    void resetChannel(uint8_t channel);
+    bool pairAddress(const char* address, uint8_t channel, const uint8_t* publicKey);
+    bool unpairUID(uint32_t uid);
+    void bumpConfigGeneration();
 
     // Radio comm variables
     bool isEnabled;
@@ -110,9 +461,10 @@ private:
     State currentState;
     String radioID;
     PairedDevice pairedDevices[MAX_CHANNELS];
-    Bytes rxBuffer;
+    RadioPeerIndex<radioPeerIndexCapacity(MAX_CHANNELS)> peerIndex; // UID -> channel
     static const uint8_t NRF_BUF_SIZE = 32;
     uint8_t txBuffer[NRF_BUF_SIZE];
+    RadioAddress writeAddress; // Address of the opened writing pipe
 
     // Radio pairing variables
     unsigned long lastPairingAttempt;
@@ -125,30 +477,173 @@ private:
     bool sentAck;
     uint8_t tempPublicKey[32]; 
     uint8_t tempSharedKey[32];
-    Bytes tempPayload;
+    uint8_t pairingPayload[NRF_BUF_SIZE]; // Encrypted pairing address, padded
+    SimpleCha2 pairingCha;
     uint8_t pairingChannel;
     String pairingAddress;
 
     // Radio settings
-    static const uint8_t CONFIG_CHANNEL = 109;
-    static const uint8_t DATA_CHANNEL = 108;
-    const unsigned long RECEIVE_TIMEOUT = 1000;
-    static const unsigned long PAIRING_TIMEOUT = 10000;
-    static const unsigned long PAIRING_INTERVAL = 250;
-    static const unsigned long PAIRING_LISTEN_TIME = 5000;
+    static const uint8_t CONFIG_CHANNEL = Config::CONFIG_CHANNEL; // Rendezvous channel
+    static const uint8_t DATA_CHANNEL = Config::DATA_CHANNEL;     // Pairing and default data channel
+    static const unsigned long RECEIVE_TIMEOUT = Config::RECEIVE_TIMEOUT;
+    static const unsigned long PAIRING_TIMEOUT = Config::PAIRING_TIMEOUT;
+    static const unsigned long PAIRING_INTERVAL = Config::PAIRING_INTERVAL;
+    static const unsigned long PAIRING_LISTEN_TIME = Config::PAIRING_LISTEN_TIME;
     static const uint8_t PAIRING_ATTEMPTS = 3;
     static const uint16_t MAX_PACKET_SIZE = 32;
+    static const uint8_t PAIRING_ID_SIZE = 9; // "<pipe><UID>:<source id>" + terminator
 
     // Message handling variables
-    Bytes outgoingMsg;
+    RadioBufferPool::Chain outgoingMsg;
     size_t outgoingMsgIndex;
-    String outgoingTargetAddr;
+    RadioAddress outgoingTargetAddr;
+    uint8_t outgoingChannel;
+    unsigned long outgoingStartTime;
     uint8_t* currentMsgStatus;
+#ifdef RADIO_MANAGER_LBT
+    unsigned long lbtNextTime; // micros() before which the channel isn't sensed again (backoff)
+    uint8_t lbtAttempts;       // Busy checks of the outgoing message
+    static const uint8_t ARD_MIN = 5; // Shortest auto-retransmit delay drawn (1500 us: acks with payloads at 250 kbps)
+#endif
+#if defined(RADIO_MANAGER_TDMA) || defined(RADIO_MANAGER_FLOW_CONTROL)
+    bool txListening;          // Listening while the outgoing message waits (TDMA slot, credits)
+#endif
+#ifdef RADIO_MANAGER_FLOW_CONTROL
+    bool creditWaiting;        // The outgoing message waits for credits
+    bool creditProbing;        // Writing a credit query, its ack describes the receiver without the outgoing message
+    bool creditUpdated;        // Credits received while the outgoing message was sent
+    unsigned long creditWaitStart; // millis()
+    unsigned long creditProbeTime; // millis() of the last credit query
+#endif
+
+    // Statistics
+    RadioStats globalStats;
+    uint8_t lastTxRetries;
+#ifdef RADIO_MANAGER_TIME_SYNC
+    uint32_t rxTime; // micros() when the frame being handled was found in the RX FIFO
+#endif
+
+    // Data rates, as levels from the slowest (pairing, unknown peers) to the fastest
+    static const uint8_t RATE_LEVELS = 3; // 250 kbps, 1 Mbps, 2 Mbps
+    static const unsigned long RATE_CONFIRM_TIME = 20; // ms to hear a device at the faster rate it asked for
+    uint8_t listenRate; // Slowest rate asked by the paired devices
+    uint8_t radioRate;  // Rate the radio is set to
+    uint8_t radioPower; // PA level the radio is set to, RF24_PA_MAX while listening (auto-acks)
+
+    // Power of the last fragment received from a device (RPD: above -64 dBm)
+    static const uint8_t RPD_UNKNOWN = 0;
+    static const uint8_t RPD_WEAK = 1;
+    static const uint8_t RPD_STRONG = 2;
+
+    // RF channels
+    uint8_t radioChannel;          // Channel the radio is tuned to
+    uint8_t dataChannel;           // Channel we listen on
+    uint8_t agreedChannel;         // Last channel selected or requested by a peer, DATA_CHANNEL if never changed
+    uint8_t previousChannel;       // Agreed channel before the last change, where peers that missed it still are
+    uint8_t txChannel;             // Channel the outgoing message is sent on
+    unsigned long lastContactTime; // millis() of the last frame received or acknowledged
+    static const uint8_t SCAN_CHANNELS_PER_LOOP = 8; // Keeps loop() short while scanning
+    static const uint8_t SCAN_DWELL_US = 170;        // Listening time per channel (RX settling + RPD)
+#ifdef RADIO_MANAGER_CHANNEL_SCAN
+    RadioChannelScan channelScan;
+    uint8_t scanChannel;
+    uint8_t scanSweeps;
+    bool scanSelect;
+#endif
 
-    // Message handling settings
-    static const uint16_t MAX_MSG_SIZE = 2048; // cleartext 2048 bytes -> ciphertext 2060 bytes -> 72 fragments max (12-byte nonce, 3-byte headers)
-    static const uint16_t MAX_PACKETS_RCV = 100; // ciphertext 2900 bytes (w/o headers) -> cleartext 2888 bytes max (12-byte nonce, 3-byte headers)
-    static const uint8_t MAX_MAILBOX_MSG = 3; // 3 msg * 5 addresses * (2048+12) bytes + 3*12 bytes = ~31 KB max mailbox size
+    // Frequency hopping
+    static const uint8_t TX_HOP = 255;     // txChannel following the hop sequence
+    static const uint8_t HOP_NONE = 255;   // hopCoordinator: not hopping
+    static const uint8_t HOP_SELF = 254;   // hopCoordinator: we coordinate the hopping
+    static const uint16_t HOP_STOP = 0xFFFF; // Index of the sync frame that stops the hopping
+#ifdef RADIO_MANAGER_HOPPING
+    RadioHopper hopper;
+    uint8_t hopCoordinator;      // Channel of the device we follow, HOP_SELF or HOP_NONE
+    unsigned long hopHeardTime;  // millis() of the last frame exchanged with the coordinator
+    uint8_t hopSyncNext;         // Next device checked for synchronisation (round robin)
+#endif
+
+    // TDMA: frame of a beacon slot (coordinator) and one slot per listed node
+    static const uint8_t TDMA_NONE = 0;
+    static const uint8_t TDMA_COORDINATOR = 1;
+    static const uint8_t TDMA_FOLLOWER = 2;
+    static const uint8_t TDMA_CONTENTION = 0; // tdmaWindow(): send at will (not scheduled, beacons lost)
+    static const uint8_t TDMA_WAIT = 1;       // tdmaWindow(): wait for our slot
+    static const uint8_t TDMA_OWN = 2;        // tdmaWindow(): in our slot
+#ifdef RADIO_MANAGER_TDMA
+    uint8_t tdmaRole;
+    uint8_t tdmaCoordinator;      // Channel of the coordinator we follow
+    uint8_t tdmaSlot;             // Our slot in the frame (coordinator: 0), 0 if not listed
+    uint32_t tdmaSlotTime;        // us
+    uint32_t tdmaFrameTime;       // us, 0 before the first beacon
+    unsigned long tdmaFrameStart; // micros() at the last beacon
+    unsigned long tdmaBeaconTime; // millis() at the last beacon
+    uint16_t tdmaFrameCount;
+#endif
+
+#ifdef RADIO_MANAGER_ACK_PAYLOAD
+    // Ack payloads: one per device each way, the radio holds up to 3 outgoing ones for their pipes
+    static const uint8_t ACK_FIFO_SIZE = 3;
+    struct AckPayload {
+        uint8_t length; // Application bytes
+        bool pending;   // Outgoing: application bytes queued
+        bool loaded;    // Outgoing: in the TX FIFO of the radio, sent with the next ack on its pipe
+        uint8_t data[ACK_PAYLOAD_SIZE];
+    };
+    AckPayload ackOut[MAX_CHANNELS];
+    AckPayload ackIn[MAX_CHANNELS];
+    uint8_t ackLoadNext; // First device considered when loading the TX FIFO (round robin)
+#endif
+
+    // Telemetry stream: blocks of STREAM_BLOCK records followed by their parity
+    static const uint8_t STREAM_RECORD_SIZE = STREAM_PAYLOAD_SIZE + 1; // Length byte, record
+    static const uint8_t STREAM_PARITY = 0x0F;        // Position of the parity frame in the frame index
+    static const uint16_t STREAM_BLOCK_MASK = 0x0FFF; // Block counter, above the position
+    static const uint16_t STREAM_MAX_GAP = 64;        // Larger block jumps are a restart of the sender, not losses
+#ifdef RADIO_MANAGER_STREAM
+    StreamCallback streamCallback;
+    struct StreamTx {
+        uint16_t block;
+        uint8_t position; // Records sent in the block
+        uint8_t parity[STREAM_RECORD_SIZE];
+    };
+    struct StreamRx {
+        bool active;      // A block was received
+        uint16_t block;
+        uint8_t received; // Bit mask of the records received or rebuilt
+        uint8_t count;    // Records of the block, from its parity frame (0 until received)
+        uint8_t records[Config::STREAM_BLOCK][STREAM_RECORD_SIZE]; // Zero-padded, for rebuilding
+    };
+    StreamTx streamTx[MAX_CHANNELS];
+    StreamRx streamRx[MAX_CHANNELS];
+#endif
+
+    // Frame capture
+    RadioCapture* captureSink;
+
+    // Configuration change tracking
+    uint32_t configGeneration;
+    ConfigChangeCallback configChangeCallback;
+#ifndef RADIO_MANAGER_SMALL_NODE
+    struct CachedJson {
+        bool valid;
+        uint32_t generation;
+        String json;
+    };
+    CachedJson pairedDevicesJsonCache[2]; // Without / with keys
+#endif
+
+    // Message handling settings (see RadioConfig.h)
+    static const uint16_t MAX_MSG_SIZE = Config::MAX_MSG_SIZE;
+    static const uint16_t MAX_PACKETS_RCV = Config::MAX_PACKETS_RCV;
+    static const uint8_t MAX_MAILBOX_MSG = Config::MAILBOX_DEPTH;
+
+    // Message buffers, shared by the mailboxes, the reassembly buffers and the outgoing message
+    static const uint8_t TX_POOL_OWNER = MAX_CHANNELS; // Pool owner of the outgoing message, peers use their channel
+    RadioBufferPool bufferPool;
+    RadioAllocator* allocator;
+    uint8_t* poolData;   // Config::POOL_BYTES, RadioAllocator::LARGE tier
+    uint16_t* poolLinks; // Config::POOL_BLOCKS, RadioAllocator::FAST tier
 
     // Message header structure & settings
     struct PacketHeader {
@@ -158,15 +653,66 @@ private:
     static const uint8_t HEADER_SIZE = sizeof(PacketHeader);
     static const uint8_t START_CODE = 'M';
     static const uint8_t CONTINUE_CODE = 'C';
+    // Same codes for peers sharing a pipe, the header is followed by the 1-byte source id of the sender
+    static const uint8_t SOURCE_START_CODE = 'm';
+    static const uint8_t SOURCE_CONTINUE_CODE = 'c';
+    static const uint8_t SOURCE_HEADER_SIZE = HEADER_SIZE + 1;
+    // Data rate request, the index holds the rate level the sender asks us to listen at
+    static const uint8_t RATE_CODE = 'R';
+    static const uint8_t SOURCE_RATE_CODE = 'r';
+    // Data channel change, the index holds the RF channel the sender moves to
+    static const uint8_t CHANNEL_CODE = 'K';
+    static const uint8_t SOURCE_CHANNEL_CODE = 'k';
+    // Hop key, followed by a nonce and the 16-byte key encrypted with the shared key of the link
+    static const uint8_t HOP_KEY_CODE = 'H';
+    static const uint8_t SOURCE_HOP_KEY_CODE = 'h';
+    // Hop sync, the index holds the ms elapsed in the slot (HOP_STOP to stop), followed by the 32-bit slot counter
+    static const uint8_t HOP_SYNC_CODE = 'S';
+    static const uint8_t SOURCE_HOP_SYNC_CODE = 's';
+    // TDMA beacon, sent without acknowledgement to the coordinator's pipe 0 address. The index holds
+    // the frame counter, followed by the slot time (ms), the number of nodes and their channels at the coordinator
+    static const uint8_t BEACON_CODE = 'B';
+    // Timestamps (micros()), the index tells the kind: request (t1) or answer (t1, t2 received, t3 sent)
+    static const uint8_t TIME_CODE = 'T';
+    static const uint8_t SOURCE_TIME_CODE = 't';
+    static const uint16_t TIME_REQUEST = 0;
+    static const uint16_t TIME_ANSWER = 1;
+    // First byte of an ack payload, followed by the credits (RADIO_MANAGER_FLOW_CONTROL) and the application bytes
+    static const uint8_t ACK_DATA_CODE = 'A';
+    static const uint8_t ACK_CREDIT_CODE = 'F'; // Credits only
+    static const uint8_t ACK_CREDIT_SIZE = Config::ACK_CREDIT_SIZE;
+    // Credit query, sent by a sender waiting for room: its ack carries the credits
+    static const uint8_t CREDIT_CODE = 'Q';
+    static const uint8_t SOURCE_CREDIT_CODE = 'q';
+    // Stream record, sent without acknowledgement. The index holds the block counter and the position
+    // in the block, followed by the length and the record, or for the parity the record count and the XOR
+    static const uint8_t STREAM_CODE = 'D';
+    static const uint8_t SOURCE_STREAM_CODE = 'd';
+    static_assert(HEADER_SIZE == Config::HEADER_SIZE && SOURCE_HEADER_SIZE == Config::SOURCE_HEADER_SIZE &&
+                  MAX_PACKET_SIZE == Config::PACKET_SIZE, "RadioManagerConfig frame layout out of date");
 
     // Encryption
-    mbedtls_entropy_context entropy;
+#ifndef RADIO_MANAGER_SMALL_NODE
+    mbedtls_entropy_context entropy; // Small nodes seed the DRBG from the hardware RNG directly
+#endif
     mbedtls_ctr_drbg_context ctr_drbg;
     uint8_t publicKey[KEY_SIZE];
     uint8_t privateKey[KEY_SIZE];
-    SimpleCha2* tempCha;
 
+#ifdef RADIO_MANAGER_TRACE
+    // Binary event trace
+    RadioTrace trace;
+#endif
+
+#ifdef RADIO_MANAGER_PROFILE
+    // Execution-time profiler
+    RadioProfiler profiler;
+#endif
 
 };
 
+#ifdef RADIO_MANAGER_OBJECT_BUDGET
+static_assert(sizeof(RadioManager) <= RADIO_MANAGER_OBJECT_BUDGET, "RadioManager exceeds RADIO_MANAGER_OBJECT_BUDGET");
+#endif
+
 #endif // RADIO_MANAGER_H
@@ -0,0 +1,100 @@
+#ifndef RADIO_PEER_INDEX_H
+#define RADIO_PEER_INDEX_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Smallest power of 2 holding count entries at a load factor of at most 1/2
+ */
+constexpr uint16_t radioPeerIndexCapacity(uint16_t count, uint16_t capacity = 4) {
+    return capacity >= 2 * count ? capacity : radioPeerIndexCapacity(count, capacity * 2);
+}
+
+/**
+ * @brief Open-addressing hash index from a 32-bit key (peer UID) to a peer slot
+ *
+ * Linear probing over a fixed power-of-2 table, with backward-shift deletion so that
+ * lookups never have to skip tombstones. Lookups and updates don't allocate. A key may
+ * be inserted for several slots, find() then returns one of them.
+ */
+template <uint16_t CAPACITY>
+class RadioPeerIndex {
+public:
+    static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "RadioPeerIndex capacity must be a power of 2");
+    static const uint8_t NOT_FOUND = 255;
+
+    RadioPeerIndex() {
+        clear();
+    }
+
+    void clear() {
+        memset(slots, NOT_FOUND, sizeof(slots));
+        count = 0;
+    }
+
+    /**
+     * @return The slot of the key, or NOT_FOUND
+     */
+    uint8_t find(uint32_t key) const {
+        for (uint16_t i = home(key); slots[i] != NOT_FOUND; i = next(i)) {
+            if (keys[i] == key) return slots[i];
+        }
+        return NOT_FOUND;
+    }
+
+    /**
+     * @return false if the slot is invalid or the table is full
+     */
+    bool insert(uint32_t key, uint8_t slot) {
+        if (slot == NOT_FOUND || count >= CAPACITY - 1) return false;
+        uint16_t i = home(key);
+        while (slots[i] != NOT_FOUND) i = next(i);
+        keys[i] = key;
+        slots[i] = slot;
+        count++;
+        return true;
+    }
+
+    /**
+     * @return false if the (key, slot) pair is not in the index
+     */
+    bool remove(uint32_t key, uint8_t slot) {
+        uint16_t hole = home(key);
+        while (slots[hole] != NOT_FOUND && (keys[hole] != key || slots[hole] != slot)) hole = next(hole);
+        if (slots[hole] == NOT_FOUND) return false;
+
+        // Move back the following entries of the cluster whose home position is not after the hole
+        for (uint16_t i = next(hole); slots[i] != NOT_FOUND; i = next(i)) {
+            if (((i - home(keys[i])) & MASK) >= ((i - hole) & MASK)) {
+                keys[hole] = keys[i];
+                slots[hole] = slots[i];
+                hole = i;
+            }
+        }
+        slots[hole] = NOT_FOUND;
+        count--;
+        return true;
+    }
+
+    uint16_t size() const {
+        return count;
+    }
+
+private:
+    static const uint16_t MASK = CAPACITY - 1;
+
+    // Fibonacci hashing, spreads UIDs made of similar characters
+    static uint16_t home(uint32_t key) {
+        return ((uint32_t)(key * 2654435761u) >> 16) & MASK;
+    }
+
+    static uint16_t next(uint16_t i) {
+        return (i + 1) & MASK;
+    }
+
+    uint32_t keys[CAPACITY];
+    uint8_t slots[CAPACITY];
+    uint16_t count;
+};
+
+#endif // RADIO_PEER_INDEX_H
@@ -0,0 +1,123 @@
+#ifndef RADIO_PROFILER_H
+#define RADIO_PROFILER_H
+
+#include <Arduino.h>
+#include <RadioStats.h>
+
+#ifndef ARDUINO_ARCH_ESP32
+    #include <chrono>
+#endif
+
+/**
+ * @brief Execution-time profiler for the radio loop and its expensive stages
+ *
+ * Durations are measured in CPU cycles on the ESP32 and in nanoseconds on host
+ * builds, stored raw in log2 histograms and only converted to microseconds by dump().
+ */
+class RadioProfiler {
+public:
+    // LOOP_* stages follow the order of RadioManager::State
+    enum Stage : uint8_t {
+        LOOP_IDLE = 0,
+        LOOP_TRANSMITTING,
+        LOOP_RECEIVING,
+        LOOP_PAIRING_LISTEN,
+        LOOP_PAIRING_TRANSMIT,
+        LOOP_SCANNING,
+        SEND_DATA,
+        RECEIVE_DATA,
+        ENCRYPT,
+        DECRYPT,
+        STAGE_COUNT
+    };
+
+    /**
+     * @brief Measures the lifetime of a scope and adds it to a stage
+     */
+    class Scope {
+    public:
+        Scope(RadioProfiler& profiler, Stage stage) : profiler(profiler), stage(stage), start(now()) {}
+        ~Scope() { profiler.add(stage, now() - start); }
+    private:
+        RadioProfiler& profiler;
+        Stage stage;
+        uint32_t start;
+    };
+
+    RadioProfiler() {
+        reset();
+    }
+
+    static uint32_t now() {
+#ifdef ARDUINO_ARCH_ESP32
+        return ESP.getCycleCount();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    static uint32_t ticksPerUs() {
+#ifdef ARDUINO_ARCH_ESP32
+        return ESP.getCpuFreqMHz();
+#else
+        return 1000;
+#endif
+    }
+
+    void add(Stage stage, uint32_t ticks) {
+        if (stage < STAGE_COUNT) histograms[stage].add(ticks);
+    }
+
+    const RadioHistogram& get(Stage stage) const {
+        return histograms[stage < STAGE_COUNT ? stage : 0];
+    }
+
+    void reset() {
+        for (uint8_t i = 0; i < STAGE_COUNT; i++) histograms[i].reset();
+    }
+
+    static const char* stageToStr(Stage stage) {
+        switch (stage) {
+            case LOOP_IDLE: return "loop/IDLE";
+            case LOOP_TRANSMITTING: return "loop/TRANSMITTING";
+            case LOOP_RECEIVING: return "loop/RECEIVING";
+            case LOOP_PAIRING_LISTEN: return "loop/PAIRING_LISTEN";
+            case LOOP_PAIRING_TRANSMIT: return "loop/PAIRING_TRANSMIT";
+            case LOOP_SCANNING: return "loop/SCANNING";
+            case SEND_DATA: return "sendData";
+            case RECEIVE_DATA: return "receiveData";
+            case ENCRYPT: return "encryptMessage";
+            case DECRYPT: return "decryptMessage";
+            default: return "?";
+        }
+    }
+
+    /**
+     * @brief Prints one line per stage: count, min, p50, p90, p99 and max in microseconds
+     *
+     * Percentiles are bucket upper bounds, i.e. accurate within a factor of 2.
+     */
+    void dump(Print& out) const {
+        uint32_t div = ticksPerUs();
+        char line[96];
+        snprintf(line, sizeof(line), "%-22s %8s %9s %8s %8s %8s %8s",
+                 "stage", "count", "min(us)", "p50(us)", "p90(us)", "p99(us)", "max(us)");
+        out.println(line);
+        for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+            const RadioHistogram& h = histograms[i];
+            if (h.count == 0) continue;
+            snprintf(line, sizeof(line), "%-22s %8lu %9lu %8lu %8lu %8lu %8lu",
+                     stageToStr(Stage(i)), (unsigned long)h.count,
+                     (unsigned long)(h.min / div), (unsigned long)(h.percentile(50) / div),
+                     (unsigned long)(h.percentile(90) / div), (unsigned long)(h.percentile(99) / div),
+                     (unsigned long)(h.max / div));
+            out.println(line);
+        }
+    }
+
+private:
+    RadioHistogram histograms[STAGE_COUNT];
+};
+
+#endif // RADIO_PROFILER_H
@@ -0,0 +1,114 @@
+#ifndef RADIO_STATS_H
+#define RADIO_STATS_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Log2 histogram of durations or sizes
+ *
+ * Bucket 0 counts zeros, bucket i counts values in [2^(i-1), 2^i), the last bucket
+ * also collects everything above. Adding a value costs a few instructions, which
+ * keeps it usable from the radio loop.
+ */
+struct RadioHistogram {
+    static const uint8_t BUCKETS = 24; // Up to ~8 s when counting microseconds
+
+    uint32_t buckets[BUCKETS];
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+
+    void reset() {
+        memset(this, 0, sizeof(*this));
+    }
+
+    void add(uint32_t value) {
+        uint8_t bucket = value ? 32 - __builtin_clz(value) : 0;
+        if (bucket >= BUCKETS) bucket = BUCKETS - 1;
+        buckets[bucket]++;
+        if (count == 0 || value < min) min = value;
+        if (value > max) max = value;
+        sum += value;
+        count++;
+    }
+
+    uint32_t mean() const {
+        return count ? sum / count : 0;
+    }
+
+    /**
+     * @brief Estimates a percentile from the buckets
+     *
+     * @param percent Percentile in [0, 100]
+     * @return Upper bound of the bucket holding the percentile (capped to max)
+     */
+    uint32_t percentile(uint8_t percent) const {
+        if (count == 0) return 0;
+        uint64_t rank = ((uint64_t)count * percent + 99) / 100;
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (uint8_t i = 0; i < BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                uint32_t upper = (1UL << i) - 1;
+                return upper < max ? upper : max;
+            }
+        }
+        return max;
+    }
+};
+
+/**
+ * @brief Traffic counters for one paired device or for the whole radio
+ */
+struct RadioStats {
+    // Reasons for which a message or fragment was lost
+    enum DropReason : uint8_t {
+        DROP_TX_FAILURE = 0,      // Fragment not acknowledged after hardware retries, message aborted
+        DROP_RX_FIFO_FULL,        // RX FIFO found full, following packets may have been lost by the radio
+        DROP_REASSEMBLY_TIMEOUT,  // Partial message expired before its last fragment
+        DROP_FRAGMENT_MISMATCH,   // Last fragment received with missing fragments
+        DROP_MAILBOX_OVERFLOW,    // Mailbox full, oldest message discarded
+        DROP_UNPAIRED,            // Message received on a pipe without paired device
+        DROP_NO_BUFFER,           // Buffer pool or peer quota exhausted, message not received or not sent
+        DROP_NO_CREDIT,           // Receiver advertised no room until RADIO_MANAGER_CREDIT_TIMEOUT, message not sent
+        DROP_REASON_COUNT
+    };
+
+    uint32_t bytesSent;          // Payload bytes sent (after encryption, without headers)
+    uint32_t bytesReceived;      // Payload bytes received (before decryption, without headers)
+    uint32_t fragmentsSent;
+    uint32_t fragmentsReceived;
+    uint32_t messagesSent;
+    uint32_t messagesReceived;   // Messages stored in a mailbox
+    uint32_t retries;            // Hardware auto-retransmissions (ARC)
+    uint32_t decryptRejected;    // Messages not decrypted (unencrypted, wrong key or replayed), stored as-is
+    uint32_t rateChanges;        // Data rate changes of the link (RADIO_MANAGER_ADAPTIVE_RATE)
+    uint32_t powerChanges;       // PA level changes of the link (RADIO_MANAGER_ADAPTIVE_POWER)
+    uint8_t paLevel;             // PA level used to send to the peer (rf24_pa_dbm_e), filled by getStats()
+    uint32_t channelBusy;        // Busy channel checks before sending a message, each followed by a backoff (RADIO_MANAGER_LBT)
+    uint32_t ackPayloadsSent;    // Ack payloads attached to an auto-ack (RADIO_MANAGER_ACK_PAYLOAD)
+    uint32_t ackPayloadsReceived;
+    uint32_t creditWaits;        // Messages held until the receiver had room (RADIO_MANAGER_FLOW_CONTROL)
+    uint32_t streamSent;         // Stream records (RADIO_MANAGER_STREAM)
+    uint32_t streamReceived;     // Stream records received as sent
+    uint32_t streamRecovered;    // Stream records rebuilt from the parity of their block
+    uint32_t streamLost;         // Stream records neither received nor rebuilt
+    uint32_t drops[DROP_REASON_COUNT];
+
+    RadioHistogram sendLatency;       // sendMsg() to last fragment acknowledged (us)
+    RadioHistogram reassemblyLatency; // First to last fragment of a received message (us)
+
+    void reset() {
+        memset(this, 0, sizeof(*this));
+    }
+
+    uint32_t totalDrops() const {
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < DROP_REASON_COUNT; i++) total += drops[i];
+        return total;
+    }
+};
+
+#endif // RADIO_STATS_H
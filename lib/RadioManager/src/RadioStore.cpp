@@ -0,0 +1,337 @@
+#include "RadioStore.h"
+
+/**
+ * @brief Construct a new RadioStore object
+ *
+ * @param storage Backend holding the superblocks and logs
+ * @param compactThreshold Log size (bytes) above which the log is compacted
+ */
+RadioStore::RadioStore(RadioStorage& storage, uint32_t compactThreshold)
+    : storage(storage), compactThreshold(compactThreshold), sequence(0), activeLog(RadioStorage::LOG_0), logSize(0) {
+    memset(entries, 0, sizeof(entries));
+}
+
+/**
+ * @brief Opens the store and recovers its state
+ *
+ * Selects the valid superblock with the highest sequence, replays its log and drops a
+ * record torn by an interrupted append (by compacting the valid records into the other log).
+ * An empty or unreadable store is formatted.
+ *
+ * @return true if the store is ready, false on storage error
+ */
+bool RadioStore::begin() {
+    memset(entries, 0, sizeof(entries));
+    logSize = 0;
+
+    Superblock superblocks[2];
+    bool valid0 = readSuperblock(RadioStorage::SUPERBLOCK_0, superblocks[0]);
+    bool valid1 = readSuperblock(RadioStorage::SUPERBLOCK_1, superblocks[1]);
+    if (!valid0 && !valid1) {
+        // New store
+        storage.erase(RadioStorage::LOG_0);
+        storage.erase(RadioStorage::LOG_1);
+        return writeSuperblock(sequence + 1, RadioStorage::LOG_0);
+    }
+
+    const Superblock& active = (valid0 && (!valid1 || superblocks[0].sequence > superblocks[1].sequence))
+                               ? superblocks[0] : superblocks[1];
+    sequence = active.sequence;
+    activeLog = active.log;
+
+    logSize = replayLog();
+    if (logSize != storage.size(activeLog)) {
+        // Trailing bytes of an interrupted append, later appends would be unreachable
+        return compact();
+    }
+    return true;
+}
+
+/**
+ * @brief Stores a value, unless it is identical to the current one
+ *
+ * @param type Record type
+ * @param key Record key
+ * @param value Pointer to the value
+ * @param length Length of the value (at most MAX_VALUE_SIZE), 0 removes the record
+ * @return true if the value is stored, false on storage error or when the store is full
+ */
+bool RadioStore::put(uint8_t type, uint8_t key, const void* value, uint8_t length) {
+    if (value == nullptr && length > 0) {
+        return false;
+    }
+
+    uint8_t record[MAX_RECORD_SIZE];
+    uint32_t crc;
+    size_t recordSize = buildRecord(record, type, key, value, length, &crc);
+
+    Entry* entry = findEntry(type, key, false);
+    bool created = false;
+    if (entry != nullptr && entry->length == length && entry->crc == crc) {
+        return true; // Unchanged
+    }
+    if (entry == nullptr) {
+        if (length == 0) {
+            return true; // Nothing to remove
+        }
+        entry = findEntry(type, key, true);
+        if (entry == nullptr) {
+            return false;
+        }
+        created = true;
+    }
+
+    size_t written = storage.append(activeLog, record, recordSize);
+    if (written != recordSize) {
+        // Move the valid records away from the torn one
+        if (created) {
+            entry->used = false;
+        }
+        logSize += written;
+        compact();
+        return false;
+    }
+
+    entry->length = length;
+    entry->offset = logSize + sizeof(RecordHeader);
+    entry->crc = crc;
+    logSize += recordSize;
+
+    if (logSize > compactThreshold) {
+        return compact();
+    }
+    return true;
+}
+
+/**
+ * @brief Removes a record
+ *
+ * @param type Record type
+ * @param key Record key
+ * @return true if the record is removed, false on storage error
+ */
+bool RadioStore::remove(uint8_t type, uint8_t key) {
+    return put(type, key, nullptr, 0);
+}
+
+/**
+ * @brief Reads the current value of a record
+ *
+ * @param type Record type
+ * @param key Record key
+ * @param value Buffer receiving the value
+ * @param size Size of the buffer
+ * @return The length of the value, or -1 if the record doesn't exist or doesn't fit
+ */
+int RadioStore::get(uint8_t type, uint8_t key, void* value, size_t size) {
+    Entry* entry = findEntry(type, key, false);
+    if (entry == nullptr || entry->length == 0 || entry->length > size) {
+        return -1;
+    }
+    if (storage.read(activeLog, entry->offset, static_cast<uint8_t*>(value), entry->length) != entry->length) {
+        return -1;
+    }
+    return entry->length;
+}
+
+/**
+ * @brief Copies the current records into the other log and switches to it
+ *
+ * The new log is complete before the new superblock is written, and the superblock
+ * overwrites the older slot only, so the previous state stays valid until the switch.
+ *
+ * @return true if the log was compacted, false on storage error (previous log still active)
+ */
+bool RadioStore::compact() {
+    uint8_t target = (activeLog == RadioStorage::LOG_0) ? RadioStorage::LOG_1 : RadioStorage::LOG_0;
+    if (!storage.erase(target)) {
+        return false;
+    }
+
+    uint8_t record[MAX_RECORD_SIZE];
+    uint32_t offsets[MAX_ENTRIES];
+    uint32_t size = 0;
+    for (uint8_t i = 0; i < MAX_ENTRIES; i++) {
+        const Entry& entry = entries[i];
+        if (!entry.used || entry.length == 0) continue;
+        size_t recordSize = sizeof(RecordHeader) + entry.length + sizeof(uint32_t);
+        if (storage.read(activeLog, entry.offset - sizeof(RecordHeader), record, recordSize) != recordSize ||
+            Crc32::compute(record, recordSize - sizeof(uint32_t)) != entry.crc) {
+            return false;
+        }
+        if (storage.append(target, record, recordSize) != recordSize) {
+            return false;
+        }
+        offsets[i] = size + sizeof(RecordHeader);
+        size += recordSize;
+    }
+
+    if (!writeSuperblock(sequence + 1, target)) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < MAX_ENTRIES; i++) {
+        Entry& entry = entries[i];
+        if (!entry.used) continue;
+        if (entry.length == 0) {
+            entry.used = false;
+        } else {
+            entry.offset = offsets[i];
+        }
+    }
+    logSize = size;
+    return true;
+}
+
+/**
+ * @brief Checks whether the store holds any record
+ *
+ * @return true if no record is stored
+ */
+bool RadioStore::isEmpty() {
+    for (uint8_t i = 0; i < MAX_ENTRIES; i++) {
+        if (entries[i].used && entries[i].length > 0) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Gets the sequence of the active superblock (number of compactions + 1)
+ *
+ * @return The active sequence
+ */
+uint32_t RadioStore::getSequence() {
+    return sequence;
+}
+
+/**
+ * @brief Gets the size of the active log
+ *
+ * @return The log size in bytes
+ */
+uint32_t RadioStore::getLogSize() {
+    return logSize;
+}
+
+/**
+ * @brief Reads and validates a superblock
+ *
+ * @param file Superblock file
+ * @param superblock Receives the superblock
+ * @return true if the superblock is valid
+ */
+bool RadioStore::readSuperblock(uint8_t file, Superblock& superblock) {
+    if (storage.read(file, 0, reinterpret_cast<uint8_t*>(&superblock), sizeof(superblock)) != sizeof(superblock)) {
+        return false;
+    }
+    return memcmp(superblock.magic, "RMSB", sizeof(superblock.magic)) == 0 &&
+           superblock.crc == Crc32::compute(&superblock, sizeof(superblock) - sizeof(superblock.crc)) &&
+           (superblock.log == RadioStorage::LOG_0 || superblock.log == RadioStorage::LOG_1);
+}
+
+/**
+ * @brief Writes a new superblock and makes its log active
+ *
+ * Even sequences go to slot 0 and odd ones to slot 1, so the active superblock is never overwritten.
+ *
+ * @param sequence New sequence
+ * @param log Log file made active
+ * @return true if the superblock was written
+ */
+bool RadioStore::writeSuperblock(uint32_t sequence, uint8_t log) {
+    Superblock superblock;
+    memcpy(superblock.magic, "RMSB", sizeof(superblock.magic));
+    superblock.sequence = sequence;
+    superblock.log = log;
+    memset(superblock.reserved, 0, sizeof(superblock.reserved));
+    superblock.crc = Crc32::compute(&superblock, sizeof(superblock) - sizeof(superblock.crc));
+
+    uint8_t file = (sequence & 1) ? RadioStorage::SUPERBLOCK_1 : RadioStorage::SUPERBLOCK_0;
+    if (!storage.write(file, reinterpret_cast<const uint8_t*>(&superblock), sizeof(superblock))) {
+        return false;
+    }
+    this->sequence = sequence;
+    activeLog = log;
+    return true;
+}
+
+/**
+ * @brief Rebuilds the index from the active log
+ *
+ * @return The size of the valid part of the log (up to the first invalid record)
+ */
+uint32_t RadioStore::replayLog() {
+    uint8_t record[MAX_RECORD_SIZE];
+    uint32_t offset = 0;
+    while (true) {
+        size_t length = storage.read(activeLog, offset, record, sizeof(record));
+        if (length < sizeof(RecordHeader) + sizeof(uint32_t)) break;
+
+        RecordHeader header;
+        memcpy(&header, record, sizeof(header));
+        size_t recordSize = sizeof(header) + header.length + sizeof(uint32_t);
+        if (header.magic != RECORD_MAGIC || length < recordSize) break;
+
+        uint32_t crc;
+        memcpy(&crc, record + recordSize - sizeof(crc), sizeof(crc));
+        if (crc != Crc32::compute(record, recordSize - sizeof(crc))) break;
+
+        Entry* entry = findEntry(header.type, header.key, true);
+        if (entry != nullptr) {
+            entry->length = header.length;
+            entry->offset = offset + sizeof(header);
+            entry->crc = crc;
+        }
+        offset += recordSize;
+    }
+    return offset;
+}
+
+/**
+ * @brief Finds the index entry of a record
+ *
+ * @param type Record type
+ * @param key Record key
+ * @param create Whether to allocate a new entry if none exists
+ * @return The entry, or nullptr if not found (or no entry left)
+ */
+RadioStore::Entry* RadioStore::findEntry(uint8_t type, uint8_t key, bool create) {
+    Entry* freeEntry = nullptr;
+    for (uint8_t i = 0; i < MAX_ENTRIES; i++) {
+        if (entries[i].used) {
+            if (entries[i].type == type && entries[i].key == key) return &entries[i];
+        } else if (freeEntry == nullptr) {
+            freeEntry = &entries[i];
+        }
+    }
+    if (!create || freeEntry == nullptr) {
+        return nullptr;
+    }
+    memset(freeEntry, 0, sizeof(*freeEntry));
+    freeEntry->used = true;
+    freeEntry->type = type;
+    freeEntry->key = key;
+    return freeEntry;
+}
+
+/**
+ * @brief Serializes a record (header, value, CRC32)
+ *
+ * @param record Buffer of MAX_RECORD_SIZE bytes
+ * @param type Record type
+ * @param key Record key
+ * @param value Pointer to the value
+ * @param length Length of the value
+ * @param crc Receives the CRC32 of the record
+ * @return The record size
+ */
+size_t RadioStore::buildRecord(uint8_t* record, uint8_t type, uint8_t key, const void* value, uint8_t length, uint32_t* crc) {
+    RecordHeader header = { RECORD_MAGIC, type, key, length };
+    memcpy(record, &header, sizeof(header));
+    if (length > 0) {
+        memcpy(record + sizeof(header), value, length);
+    }
+    *crc = Crc32::compute(record, sizeof(header) + length);
+    memcpy(record + sizeof(header) + length, crc, sizeof(*crc));
+    return sizeof(header) + length + sizeof(*crc);
+}
@@ -0,0 +1,125 @@
+#ifndef RADIO_STORE_H
+#define RADIO_STORE_H
+
+#include <Arduino.h>
+#include <Crc32.h>
+#include <RadioConfig.h>
+
+#ifndef RADIO_STORE_MAX_ENTRIES
+    #define RADIO_STORE_MAX_ENTRIES (RADIO_MANAGER_MAX_PEERS + 1) // One record per peer + personal keys
+#endif
+
+#ifndef RADIO_STORE_COMPACT_THRESHOLD
+    #define RADIO_STORE_COMPACT_THRESHOLD 4096 // Log size (bytes) above which it is compacted
+#endif
+
+/**
+ * @brief Storage backend used by RadioStore
+ *
+ * A backend exposes a few small files identified by FileId. Only appends, whole-file
+ * writes and reads are needed, which any file system (or raw flash with a bit of glue)
+ * can provide. See RadioFsStorage (SPIFFS/LittleFS) and RadioFileStorage (POSIX).
+ */
+class RadioStorage {
+public:
+    enum FileId : uint8_t {
+        SUPERBLOCK_0 = 0,
+        SUPERBLOCK_1,
+        LOG_0,
+        LOG_1,
+        FILE_COUNT
+    };
+
+    virtual ~RadioStorage() {}
+
+    // Read up to length bytes at offset, returns the number of bytes read (0 if missing)
+    virtual size_t read(uint8_t file, uint32_t offset, uint8_t* data, size_t length) = 0;
+    // Append to the end of the file (created if missing), returns the number of bytes written
+    virtual size_t append(uint8_t file, const uint8_t* data, size_t length) = 0;
+    // Replace the whole content of the file
+    virtual bool write(uint8_t file, const uint8_t* data, size_t length) = 0;
+    // Size of the file, 0 if missing
+    virtual uint32_t size(uint8_t file) = 0;
+    // Remove the file
+    virtual bool erase(uint8_t file) = 0;
+
+    static const char* fileSuffix(uint8_t file) {
+        switch (file) {
+            case SUPERBLOCK_0: return ".sb0";
+            case SUPERBLOCK_1: return ".sb1";
+            case LOG_0: return ".log0";
+            case LOG_1: return ".log1";
+            default: return ".tmp";
+        }
+    }
+};
+
+/**
+ * @brief Log-structured key/value store for small records (pairing state)
+ *
+ * Records are appended to the active log with a CRC32, the latest record of a (type, key)
+ * pair wins and identical values are not rewritten. When the log grows above the
+ * compaction threshold, the latest records are copied to the other log and a new
+ * superblock is written to the older of the two superblock slots, so that a power cut
+ * at any point leaves either the previous or the new state, never a mix of both.
+ */
+class RadioStore {
+public:
+    static const uint8_t MAX_ENTRIES = RADIO_STORE_MAX_ENTRIES;
+    static const uint8_t MAX_VALUE_SIZE = 255;
+
+    RadioStore(RadioStorage& storage, uint32_t compactThreshold = RADIO_STORE_COMPACT_THRESHOLD);
+
+    bool begin();
+    bool put(uint8_t type, uint8_t key, const void* value, uint8_t length);
+    bool remove(uint8_t type, uint8_t key);
+    int get(uint8_t type, uint8_t key, void* value, size_t size);
+    bool compact();
+
+    bool isEmpty();
+    uint32_t getSequence();
+    uint32_t getLogSize();
+
+private:
+    struct Superblock {
+        char magic[4];      // "RMSB"
+        uint32_t sequence;  // Incremented at each compaction, the highest valid one is active
+        uint8_t log;        // Active log file (RadioStorage::LOG_0 or LOG_1)
+        uint8_t reserved[3];
+        uint32_t crc;       // CRC32 of the previous fields
+    } __attribute__((packed));
+
+    struct RecordHeader {
+        uint8_t magic;      // RECORD_MAGIC
+        uint8_t type;
+        uint8_t key;
+        uint8_t length;     // Value length, 0 for a removed record
+    } __attribute__((packed)); // Followed by the value and a CRC32 of header + value
+
+    struct Entry {
+        bool used;
+        uint8_t type;
+        uint8_t key;
+        uint8_t length;
+        uint32_t offset;    // Offset of the value in the active log
+        uint32_t crc;       // CRC32 of the record
+    };
+
+    static const uint8_t RECORD_MAGIC = 0xA5;
+    static const size_t MAX_RECORD_SIZE = sizeof(RecordHeader) + MAX_VALUE_SIZE + sizeof(uint32_t);
+
+    RadioStorage& storage;
+    uint32_t compactThreshold;
+    uint32_t sequence;
+    uint8_t activeLog;
+    uint32_t logSize;
+    Entry entries[MAX_ENTRIES];
+
+    bool readSuperblock(uint8_t file, Superblock& superblock);
+    bool writeSuperblock(uint32_t sequence, uint8_t log);
+    uint32_t replayLog();
+    Entry* findEntry(uint8_t type, uint8_t key, bool create);
+    size_t buildRecord(uint8_t* record, uint8_t type, uint8_t key, const void* value, uint8_t length, uint32_t* crc);
+};
+
+#endif // RADIO_STORE_H
@@ -0,0 +1,72 @@
+#ifndef RADIO_TIERED_ALLOCATOR_H
+#define RADIO_TIERED_ALLOCATOR_H
+
+#include <RadioAllocator.h>
+#include <stdlib.h>
+#include <cstddef>
+
+/**
+ * @brief Allocator simulating internal RAM and PSRAM with a capacity each, for host tests and tools
+ *
+ * Follows the policy of RadioHeapAllocator: LARGE buffers fall back to the FAST tier when
+ * the LARGE tier is full. Bytes in use and peak usage are counted per tier the buffers
+ * actually landed in, failed allocations per requested tier.
+ */
+class RadioTieredAllocator : public RadioAllocator {
+public:
+    RadioTieredAllocator(size_t fastCapacity, size_t largeCapacity) {
+        capacity[FAST] = fastCapacity;
+        capacity[LARGE] = largeCapacity;
+        for (uint8_t i = 0; i < TIER_COUNT; i++) {
+            used[i] = 0;
+            peak[i] = 0;
+            failures[i] = 0;
+        }
+    }
+
+    void* allocate(size_t size, uint8_t tier) override {
+        if (tier >= TIER_COUNT) return nullptr;
+        uint8_t actual = tier;
+        if (tier == LARGE && used[LARGE] + size > capacity[LARGE]) {
+            actual = FAST; // PSRAM full, fall back to internal RAM
+        }
+        if (used[actual] + size > capacity[actual]) {
+            failures[tier]++;
+            return nullptr;
+        }
+        // Record the tier and size in front of the buffer to count them on release
+        Block* block = static_cast<Block*>(malloc(sizeof(Block) + size));
+        if (block == nullptr) return nullptr;
+        block->size = size;
+        block->tier = actual;
+        used[actual] += size;
+        if (used[actual] > peak[actual]) peak[actual] = used[actual];
+        return block + 1;
+    }
+
+    void release(void* buffer, uint8_t tier) override {
+        (void)tier;
+        if (buffer == nullptr) return;
+        Block* block = static_cast<Block*>(buffer) - 1;
+        used[block->tier] -= block->size;
+        free(block);
+    }
+
+    size_t getUsed(uint8_t tier) const { return tier < TIER_COUNT ? used[tier] : 0; }
+    size_t getPeak(uint8_t tier) const { return tier < TIER_COUNT ? peak[tier] : 0; }
+    size_t getCapacity(uint8_t tier) const { return tier < TIER_COUNT ? capacity[tier] : 0; }
+    uint32_t getFailures(uint8_t tier) const { return tier < TIER_COUNT ? failures[tier] : 0; }
+
+private:
+    struct alignas(std::max_align_t) Block {
+        size_t size;
+        uint8_t tier;
+    };
+
+    size_t capacity[TIER_COUNT];
+    size_t used[TIER_COUNT];
+    size_t peak[TIER_COUNT];
+    uint32_t failures[TIER_COUNT];
+};
+
+#endif // RADIO_TIERED_ALLOCATOR_H
@@ -0,0 +1,139 @@
+#ifndef RADIO_TRACE_H
+#define RADIO_TRACE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+#ifndef RADIO_TRACE_CAPACITY
+    #define RADIO_TRACE_CAPACITY 256 // Number of records, must be a power of 2
+#endif
+
+/**
+ * @brief Fixed-size binary trace record (12 bytes, little-endian)
+ */
+struct RadioTraceRecord {
+    uint32_t timestamp; // micros() at the time of the event
+    uint8_t event;      // RadioTrace::Event
+    uint8_t pipe;       // Radio pipe (or channel for pairing events)
+    uint16_t fragment;  // Fragment index from the packet header
+    uint32_t value;     // Event-specific counter or argument
+} __attribute__((packed));
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring buffer of trace records
+ *
+ * The radio loop is the only producer and the application (drain to Serial/SD) the
+ * only consumer. When the buffer is full, new records are dropped and counted so that
+ * tracing never blocks the radio loop.
+ */
+class RadioTrace {
+public:
+    // Event ids are part of the binary format, only append new values at the end
+    enum Event : uint8_t {
+        TX_START = 1,       // value = message size
+        TX_FRAGMENT,        // value = fragment payload size
+        TX_FAIL,            // value = bytes sent before failure
+        TX_DONE,            // value = message size
+        RX_FRAGMENT,        // value = fragment payload size
+        RX_COMPLETE,        // value = message size
+        RX_INCOMPLETE,      // value = (expected fragments << 16) | received fragments
+        RX_TIMEOUT,         // value = bytes buffered
+        DECRYPT_OK,         // value = cleartext size
+        DECRYPT_FAIL,       // value = ciphertext size
+        MAILBOX_DROP,       // value = mailbox size
+        PAIRING_START,      // value = pairing channel
+        PAIRING_STEP,       // fragment = step (see handlePairing), value = 1 if OK
+        PAIRING_DONE,       // value = 1 if paired, 0 if unpaired
+        PAIRING_ABORT,      // value = 0 timeout, 1 invalid unpair, 2 no channel left
+        RX_NO_BUFFER,       // value = bytes buffered before the fragment was refused
+        RATE_CHANGE,        // fragment = 0 step down, 1 step up, 2 probe, 3 requested by the peer, 4 faster rate not confirmed, value = rate level (kept for 4)
+        POWER_CHANGE,       // fragment = 0 step down, 1 step up, 2 boost after a failure, value = PA level
+        SCAN_DONE,          // fragment = sweeps, value = quietest channel
+        CHANNEL_CHANGE,     // fragment = 0 selected, 1 requested by a peer, 2 send fallback, 3 rendezvous timeout, value = channel
+        HOP_SYNC,           // fragment = 0 synchronised, 1 lost, 2 started, 3 stopped, value = slot counter
+        LBT_BACKOFF,        // fragment = busy checks of the message, value = backoff (us)
+        TDMA_BEACON,        // fragment = nodes listed (coordinator) or our new slot (node), value = frame counter
+        CLOCK_SYNC,         // fragment = 0 request answered, 1 estimate updated, value = round trip (us)
+        ACK_PAYLOAD,        // fragment = 0 sent with an ack, 1 received with an ack, value = length
+        CREDIT_WAIT,        // fragment = 0 waiting, 1 credits received, 2 timed out, value = slots << 16 | bytes
+        STREAM_FEC          // fragment = 0 record rebuilt from parity (value = block), 1 records lost (value = count)
+    };
+
+    static const uint32_t CAPACITY = RADIO_TRACE_CAPACITY;
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "RADIO_TRACE_CAPACITY must be a power of 2");
+
+    // Version of the binary dump format written by drain()
+    static const uint8_t FORMAT_VERSION = 1;
+
+    RadioTrace() : head(0), tail(0), dropped(0) {}
+
+    /**
+     * @brief Append a record (producer side, never blocks)
+     */
+    void record(Event event, uint8_t pipe, uint16_t fragment, uint32_t value) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= CAPACITY) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        RadioTraceRecord& rec = buffer[h & (CAPACITY - 1)];
+        rec.timestamp = micros();
+        rec.event = event;
+        rec.pipe = pipe;
+        rec.fragment = fragment;
+        rec.value = value;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Pop the oldest record (consumer side)
+     *
+     * @return true if a record was copied into rec, false if the buffer is empty
+     */
+    bool pop(RadioTraceRecord& rec) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        rec = buffer[t & (CAPACITY - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Write all pending records to a stream in binary form
+     *
+     * The dump starts with a 10-byte header ("RMTR", version, record size, dropped count)
+     * and is decoded off-device by extras/trace_decode.py.
+     *
+     * @return Number of records written
+     */
+    size_t drain(Print& out) {
+        uint32_t lost = dropped.exchange(0, std::memory_order_relaxed);
+        uint8_t header[10] = { 'R', 'M', 'T', 'R', FORMAT_VERSION, sizeof(RadioTraceRecord) };
+        memcpy(header + 6, &lost, sizeof(lost));
+        out.write(header, sizeof(header));
+
+        size_t count = 0;
+        RadioTraceRecord rec;
+        while (pop(rec)) {
+            out.write(reinterpret_cast<const uint8_t*>(&rec), sizeof(rec));
+            count++;
+        }
+        return count;
+    }
+
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    uint32_t getDropped() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    RadioTraceRecord buffer[CAPACITY];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> dropped;
+};
+
+#endif // RADIO_TRACE_H
@@ -30,21 +30,9 @@ void SimpleCha2::setKey(const uint8_t* newKey) {
  * @return vector Encrypted data (nonce + ciphertext)
  */
 Bytes SimpleCha2::encrypt(const uint8_t* plaintext, size_t plaintextLen) {
-    uint8_t iv[IV_SIZE];
-    generateIV(iv);
-    uint8_t nonce[NONCE_SIZE];
-    createNonce(nonce, iv, ++encryptCounter);
-
-    Bytes ciphertext(plaintextLen);
-
-    chacha.setKey(key, KEY_SIZE);
-    chacha.setIV(nonce, NONCE_SIZE);
-    chacha.encrypt(ciphertext.data(), plaintext, plaintextLen);
-
-    Bytes combined(NONCE_SIZE + ciphertext.size());
-    memcpy(combined.data(), nonce, NONCE_SIZE);
-    memcpy(combined.data() + NONCE_SIZE, ciphertext.data(), ciphertext.size());
-
+    Bytes combined(NONCE_SIZE + plaintextLen);
+    beginEncrypt(combined.data());
+    process(combined.data() + NONCE_SIZE, plaintext, plaintextLen);
     return combined;
 }
 
@@ -79,26 +67,12 @@ Bytes SimpleCha2::encrypt(const String& plaintext) {
  * @return vector Decrypted data
  */
 Bytes SimpleCha2::decrypt(const uint8_t* ciphertext, size_t ciphertextLen) {
-    if (ciphertextLen < NONCE_SIZE) {
-        return Bytes();
-    }
-
-    uint8_t nonce[NONCE_SIZE];
-    memcpy(nonce, ciphertext, NONCE_SIZE);
-
-    uint32_t receivedCounter = extractCounter(nonce);
-    if (receivedCounter <= decryptCounter) {
+    if (ciphertextLen < NONCE_SIZE || !beginDecrypt(ciphertext)) {
         return Bytes();
     }
-    decryptCounter = receivedCounter;
-
-    size_t dataSize = ciphertextLen - NONCE_SIZE;
-    Bytes decrypted(dataSize);
-
-    chacha.setKey(key, KEY_SIZE);
-    chacha.setIV(nonce, NONCE_SIZE);
-    chacha.decrypt(decrypted.data(), ciphertext + NONCE_SIZE, dataSize);
 
+    Bytes decrypted(ciphertextLen - NONCE_SIZE);
+    process(decrypted.data(), ciphertext + NONCE_SIZE, decrypted.size());
     return decrypted;
 }
 
@@ -136,6 +110,53 @@ String SimpleCha2::decryptToStr(const Bytes& ciphertext) {
     return decryptToStr(ciphertext.data(), ciphertext.size());
 }
 
+/**
+ * @brief Start encrypting a message with a new nonce
+ * 
+ * The message is then encrypted by one or more calls to process().
+ * 
+ * @param nonce Receives the nonce (NONCE_SIZE bytes), to be sent before the ciphertext
+ */
+void SimpleCha2::beginEncrypt(uint8_t* nonce) {
+    uint8_t iv[IV_SIZE];
+    generateIV(iv);
+    createNonce(nonce, iv, ++encryptCounter);
+
+    chacha.setKey(key, KEY_SIZE);
+    chacha.setIV(nonce, NONCE_SIZE);
+}
+
+/**
+ * @brief Start decrypting a message, unless its nonce was already used (replay)
+ * 
+ * The message is then decrypted by one or more calls to process().
+ * 
+ * @param nonce Nonce received before the ciphertext (NONCE_SIZE bytes)
+ * @return true if the message can be decrypted, false if its counter is not newer than the last one
+ */
+bool SimpleCha2::beginDecrypt(const uint8_t* nonce) {
+    uint32_t receivedCounter = extractCounter(nonce);
+    if (receivedCounter <= decryptCounter) {
+        return false;
+    }
+    decryptCounter = receivedCounter;
+
+    chacha.setKey(key, KEY_SIZE);
+    chacha.setIV(nonce, NONCE_SIZE);
+    return true;
+}
+
+/**
+ * @brief Encrypt or decrypt the next part of the current message
+ * 
+ * @param output Output buffer (may be the input buffer)
+ * @param input Input bytes
+ * @param length Number of bytes
+ */
+void SimpleCha2::process(uint8_t* output, const uint8_t* input, size_t length) {
+    chacha.encrypt(output, input, length);
+}
+
 /**
  * @brief Reset the encryption counter
  */
@@ -168,6 +189,17 @@ uint32_t SimpleCha2::getDecryptCounter() const {
     return decryptCounter;
 }
 
+/**
+ * @brief Restore both counters (e.g. from a saved configuration)
+ * 
+ * @param encrypt Last encryption counter used
+ * @param decrypt Last decryption counter accepted
+ */
+void SimpleCha2::setCounters(uint32_t encrypt, uint32_t decrypt) {
+    encryptCounter = encrypt;
+    decryptCounter = decrypt;
+}
+
 
 void SimpleCha2::generateIV(uint8_t* iv) {
     esp_fill_random(iv, IV_SIZE);
@@ -9,6 +9,7 @@ using Bytes = std::vector<uint8_t>;
 
 class SimpleCha2 {
 public:
+    static const size_t NONCE_SIZE = 12; // Prepended to the ciphertext
 
     SimpleCha2(const uint8_t* initialKey);
 
@@ -17,6 +18,7 @@ public:
     void resetDecryptCounter();
     uint32_t getEncryptCounter() const;
     uint32_t getDecryptCounter() const;
+    void setCounters(uint32_t encrypt, uint32_t decrypt);
 
     Bytes encrypt(const uint8_t* plaintext, size_t plaintextLen);
     Bytes encrypt(const Bytes& plaintext);
@@ -27,10 +29,13 @@ public:
     String decryptToStr(const uint8_t* ciphertext, size_t ciphertextLen);
     String decryptToStr(const Bytes& ciphertext);
 
+    // Piecewise encryption/decryption of a message, e.g. stored in several buffers
+    void beginEncrypt(uint8_t* nonce);
+    bool beginDecrypt(const uint8_t* nonce);
+    void process(uint8_t* output, const uint8_t* input, size_t length);
 
 private:
     static const size_t KEY_SIZE = 32;
-    static const size_t NONCE_SIZE = 12;
     static const size_t COUNTER_SIZE = 4;
     static const size_t IV_SIZE = NONCE_SIZE - COUNTER_SIZE;
 
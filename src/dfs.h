@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <SPIFFS.h>
 #include "RadioManager.h"
+#include "RadioFsStorage.h"
 
 #define BUTTON_PIN D1
 
@@ -15,7 +16,7 @@ unsigned long buttonPressStartTime = 0;
 const unsigned long PAIRING_BUTTON_DURATION = 1000; // 1 second
 
 // Radio variables
-String lastSavedPairedAddrList = "";
+uint32_t lastSavedCfgGeneration = 0;
 
 // Message sending variables
 uint8_t currentChannel = 0;
@@ -31,8 +32,14 @@ bool isLedOn = false;
 int ledWait = 0;
 unsigned long lastBlinkSeries = 0;
 
-// Configuration file name in SPIFFS
+// Configuration store in SPIFFS (files prefixed with CONFIG_STORE), the JSON and binary
+// files are only read to migrate older configurations
+#define CONFIG_STORE "/radio"
 #define CONFIG_FILE "/radio_config.json"
+#define CONFIG_FILE_BIN "/radio_config.bin"
+
+RadioFsStorage configStorage(SPIFFS, CONFIG_STORE);
+RadioStore configStore(configStorage);
 
 // Function to get a 4-digit UID based on MAC address
 const char* getESP32UID() {
@@ -84,17 +91,9 @@ void updateLed() {
 
 // Function to save the configuration
 bool saveCfg() {
-    String cfg = radioManager.exportCfg();
-    File file = SPIFFS.open(CONFIG_FILE, FILE_WRITE);
-    if (!file) {
-        Serial.println("Failed to open file for writing");
-        return false;
-    }
-    size_t bytesWritten = file.print(cfg);
-    file.close();
-    if (bytesWritten == cfg.length()) {
+    if (radioManager.exportCfg(configStore)) {
         Serial.println("Configuration saved successfully");
-        lastSavedPairedAddrList = radioManager.getPairedDevicesJson();
+        lastSavedCfgGeneration = radioManager.getConfigGeneration();
         return true;
     } else {
         Serial.println("Failed to save configuration");
@@ -104,23 +103,55 @@ bool saveCfg() {
 
 // Function to restore the configuration
 bool retrieveCfg() {
-    if (SPIFFS.exists(CONFIG_FILE)) {
+    if (!configStore.begin()) {
+        Serial.println("Failed to open configuration store");
+        return false;
+    }
+    if (!configStore.isEmpty()) {
+        if (radioManager.importCfg(configStore)) {
+            Serial.println("Configuration restored successfully");
+            lastSavedCfgGeneration = radioManager.getConfigGeneration();
+            return true;
+        } else {
+            Serial.println("Error while restoring configuration");
+            return false;
+        }
+    } else if (SPIFFS.exists(CONFIG_FILE_BIN)) {
+        File file = SPIFFS.open(CONFIG_FILE_BIN, FILE_READ);
+        if (!file) {
+            Serial.println("Failed to open file for reading");
+            return false;
+        }
+        Bytes cfg(RadioManager::CFG_BIN_SIZE);
+        size_t cfgSize = file.read(cfg.data(), cfg.size());
+        file.close();
+        if (radioManager.importCfgBin(cfg.data(), cfgSize)) {
+            Serial.println("Configuration restored successfully, migrating to configuration store");
+            if (saveCfg()) {
+                SPIFFS.remove(CONFIG_FILE_BIN);
+            }
+            return true;
+        } else {
+            Serial.println("Error while restoring configuration");
+            return false;
+        }
+    } else if (SPIFFS.exists(CONFIG_FILE)) {
         File file = SPIFFS.open(CONFIG_FILE, FILE_READ);
         if (!file) {
             Serial.println("Failed to open file for reading");
             return false;
         }
-        String cfg = file.readString();
+        bool imported = radioManager.importCfg(file);
         file.close();
-        if (cfg.length() > 0) {
-            if (radioManager.importCfg(cfg)) {
-                Serial.println("Configuration restored successfully");
-                lastSavedPairedAddrList = radioManager.getPairedDevicesJson();
-                return true;
-            } else {
-                Serial.println("Error while restoring configuration");
-                return false;
+        if (imported) {
+            Serial.println("Configuration restored successfully, migrating to configuration store");
+            if (saveCfg()) {
+                SPIFFS.remove(CONFIG_FILE);
             }
+            return true;
+        } else {
+            Serial.println("Error while restoring configuration");
+            return false;
         }
     } else {
         Serial.println("No saved configuration found");
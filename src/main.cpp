@@ -66,11 +66,11 @@ void loop() {
         sendSerialMessage();
 
         // Check if pairing has been done and save the configuration
-        String currentPairedAddrJson = radioManager.getPairedDevicesJson();
-        if (currentPairedAddrJson != lastSavedPairedAddrList) {
+        uint32_t currentCfgGeneration = radioManager.getConfigGeneration();
+        if (currentCfgGeneration != lastSavedCfgGeneration) {
             if (!saveCfg()) {
                 Serial.println("Failed to save configuration");
-                lastSavedPairedAddrList = currentPairedAddrJson;
+                lastSavedCfgGeneration = currentCfgGeneration;
             }
         }
     }
@@ -0,0 +1,310 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+/**
+ * @brief Minimal Arduino core for the host tests (pio test -e native)
+ *
+ * Provides what the library uses: String, Print, Stream, Serial and the time functions.
+ * Time comes from a host::Clock, the real time by default; the radio simulator replaces
+ * it with the virtual clock of the node being run (see RadioSim.h).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+
+#define HIGH 1
+#define LOW 0
+#define HEX 16
+#define DEC 10
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+namespace host {
+
+// Source of millis()/micros()/delay()
+class Clock {
+public:
+    virtual ~Clock() {}
+    virtual uint64_t now() = 0;               // Microseconds
+    virtual void sleep(uint64_t duration) = 0; // Microseconds
+};
+
+// Real time
+class SteadyClock : public Clock {
+public:
+    uint64_t now() override {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start()).count();
+    }
+    void sleep(uint64_t duration) override {
+        std::this_thread::sleep_for(std::chrono::microseconds(duration));
+    }
+
+private:
+    static std::chrono::steady_clock::time_point start() {
+        static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+        return origin;
+    }
+};
+
+inline SteadyClock& steadyClock() {
+    static SteadyClock steady;
+    return steady;
+}
+
+inline Clock*& clockSlot() {
+    static Clock* current = &steadyClock();
+    return current;
+}
+
+// Installs a clock, nullptr restores the real time
+inline void setClock(Clock* clock) {
+    clockSlot() = clock ? clock : &steadyClock();
+}
+
+inline Clock& clock() {
+    return *clockSlot();
+}
+
+// Deterministic random generator behind random() and esp_random()
+inline std::mt19937& rng() {
+    static std::mt19937 generator(12345);
+    return generator;
+}
+
+} // namespace host
+
+// Like the ESP32, millis() and micros() are 32-bit counters
+inline unsigned long millis() { return static_cast<uint32_t>(host::clock().now() / 1000); }
+inline unsigned long micros() { return static_cast<uint32_t>(host::clock().now()); }
+inline void delay(unsigned long ms) { host::clock().sleep(static_cast<uint64_t>(ms) * 1000); }
+inline void delayMicroseconds(unsigned int us) { host::clock().sleep(us); }
+inline void yield() {}
+
+inline long random(long max) { return max > 0 ? static_cast<long>(host::rng()() % static_cast<unsigned long>(max)) : 0; }
+inline long random(long min, long max) { return max > min ? min + random(max - min) : min; }
+inline void randomSeed(unsigned long seed) { host::rng().seed(seed); }
+
+inline bool isAlphaNumeric(char c) { return isalnum(static_cast<unsigned char>(c)) != 0; }
+inline bool isHexadecimalDigit(char c) { return isxdigit(static_cast<unsigned char>(c)) != 0; }
+inline bool isDigit(char c) { return isdigit(static_cast<unsigned char>(c)) != 0; }
+
+class String {
+public:
+    String() {}
+    String(const char* str) : value(str ? str : "") {}
+    String(const char* str, size_t length) : value(str ? std::string(str, length) : std::string()) {}
+    String(const std::string& str) : value(str) {}
+    explicit String(char c) : value(1, c) {}
+    String(int number, unsigned char base = DEC) : value(format(static_cast<long long>(number), base)) {}
+    String(unsigned int number, unsigned char base = DEC) : value(format(static_cast<unsigned long long>(number), base)) {}
+    String(long number, unsigned char base = DEC) : value(format(static_cast<long long>(number), base)) {}
+    String(unsigned long number, unsigned char base = DEC) : value(format(static_cast<unsigned long long>(number), base)) {}
+    String(long long number, unsigned char base = DEC) : value(format(number, base)) {}
+    String(unsigned long long number, unsigned char base = DEC) : value(format(number, base)) {}
+    String(unsigned char number, unsigned char base = DEC) : value(format(static_cast<unsigned long long>(number), base)) {}
+    String(double number, unsigned int decimals = 2) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, number);
+        value = buffer;
+    }
+
+    String& operator=(const char* str) { value = str ? str : ""; return *this; }
+
+    unsigned int length() const { return value.size(); }
+    bool isEmpty() const { return value.empty(); }
+    const char* c_str() const { return value.c_str(); }
+    bool reserve(unsigned int size) { value.reserve(size); return true; }
+
+    bool concat(const String& str) { value += str.value; return true; }
+    bool concat(const char* str) { if (str) value += str; return str != nullptr; }
+    bool concat(const char* str, unsigned int length) { if (str) value.append(str, length); return str != nullptr; }
+    bool concat(char c) { value += c; return true; }
+    String& operator+=(const String& str) { concat(str); return *this; }
+    String& operator+=(const char* str) { concat(str); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+    template <typename T> String& operator+=(T number) { concat(String(number)); return *this; }
+
+    char charAt(unsigned int index) const { return index < value.size() ? value[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return value[index]; }
+    int indexOf(char c, unsigned int from = 0) const { return position(value.find(c, from)); }
+    int indexOf(const String& str, unsigned int from = 0) const { return position(value.find(str.value, from)); }
+    String substring(unsigned int from) const { return from < value.size() ? String(value.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        return from < value.size() ? String(value.substr(from, to - from)) : String();
+    }
+    bool startsWith(const String& prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+    bool endsWith(const String& suffix) const {
+        return value.size() >= suffix.value.size() &&
+               value.compare(value.size() - suffix.value.size(), suffix.value.size(), suffix.value) == 0;
+    }
+    void replace(const String& find, const String& replacement) {
+        if (find.value.empty()) return;
+        for (size_t at = value.find(find.value); at != std::string::npos; at = value.find(find.value, at + replacement.value.size())) {
+            value.replace(at, find.value.size(), replacement.value);
+        }
+    }
+    void remove(unsigned int index) { if (index < value.size()) value.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < value.size()) value.erase(index, count); }
+    void trim() {
+        size_t first = value.find_first_not_of(" \t\r\n");
+        size_t last = value.find_last_not_of(" \t\r\n");
+        value = (first == std::string::npos) ? std::string() : value.substr(first, last - first + 1);
+    }
+    void toUpperCase() { for (char& c : value) c = toupper(static_cast<unsigned char>(c)); }
+    void toLowerCase() { for (char& c : value) c = tolower(static_cast<unsigned char>(c)); }
+    long toInt() const { return strtol(value.c_str(), nullptr, 10); }
+    void getBytes(unsigned char* buffer, unsigned int size, unsigned int from = 0) const { copy(reinterpret_cast<char*>(buffer), size, from); }
+    void toCharArray(char* buffer, unsigned int size, unsigned int from = 0) const { copy(buffer, size, from); }
+
+    bool equals(const String& str) const { return value == str.value; }
+    bool operator==(const String& str) const { return value == str.value; }
+    bool operator==(const char* str) const { return value == (str ? str : ""); }
+    bool operator!=(const String& str) const { return !(*this == str); }
+    bool operator!=(const char* str) const { return !(*this == str); }
+    bool operator<(const String& str) const { return value < str.value; }
+
+    const char* begin() const { return value.data(); }
+    const char* end() const { return value.data() + value.size(); }
+
+private:
+    std::string value;
+
+    static int position(size_t index) { return index == std::string::npos ? -1 : static_cast<int>(index); }
+
+    void copy(char* buffer, unsigned int size, unsigned int from) const {
+        if (size == 0) return;
+        size_t count = from < value.size() ? std::min<size_t>(size - 1, value.size() - from) : 0;
+        memcpy(buffer, value.data() + from, count);
+        buffer[count] = '\0';
+    }
+
+    static std::string format(unsigned long long number, unsigned char base) {
+        if (base < 2 || base > 36) base = DEC;
+        char buffer[65];
+        char* p = buffer + sizeof(buffer) - 1;
+        *p = '\0';
+        do {
+            unsigned digit = number % base;
+            *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+            number /= base;
+        } while (number);
+        return p;
+    }
+
+    static std::string format(long long number, unsigned char base) {
+        if (number < 0 && base == DEC) {
+            return "-" + format(static_cast<unsigned long long>(-(number + 1)) + 1, base);
+        }
+        return format(static_cast<unsigned long long>(number), base);
+    }
+};
+
+inline String operator+(const String& a, const String& b) { String s(a); s += b; return s; }
+inline String operator+(const String& a, const char* b) { String s(a); s += b; return s; }
+inline String operator+(const char* a, const String& b) { String s(a); s += b; return s; }
+inline String operator+(const String& a, char b) { String s(a); s += b; return s; }
+template <typename T> String operator+(const String& a, T number) { String s(a); s += number; return s; }
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t count = 0;
+        while (size-- && write(*buffer++)) count++;
+        return count;
+    }
+    size_t write(const char* str) { return str ? write(reinterpret_cast<const uint8_t*>(str), strlen(str)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write(reinterpret_cast<const uint8_t*>(buffer), size); }
+    virtual void flush() {}
+
+    size_t print(const String& str) { return write(str.c_str(), str.length()); }
+    size_t print(const char* str) { return write(str); }
+    size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+    size_t print(unsigned char number, int base = DEC) { return print(String(number, base)); }
+    size_t print(int number, int base = DEC) { return print(String(number, base)); }
+    size_t print(unsigned int number, int base = DEC) { return print(String(number, base)); }
+    size_t print(long number, int base = DEC) { return print(String(number, base)); }
+    size_t print(unsigned long number, int base = DEC) { return print(String(number, base)); }
+    size_t print(long long number, int base = DEC) { return print(String(number, base)); }
+    size_t print(unsigned long long number, int base = DEC) { return print(String(number, base)); }
+    size_t print(double number, int decimals = 2) { return print(String(number, decimals)); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        return length > 0 ? write(buffer, std::min<size_t>(length, sizeof(buffer) - 1)) : 0;
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    // No timeout on the host: the data is either there or not
+    void setTimeout(unsigned long) {}
+
+    size_t readBytes(char* buffer, size_t length) {
+        size_t count = 0;
+        int c;
+        while (count < length && (c = read()) >= 0) {
+            buffer[count++] = static_cast<char>(c);
+        }
+        return count;
+    }
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes(reinterpret_cast<char*>(buffer), length); }
+
+    String readString() {
+        String str;
+        int c;
+        while ((c = read()) >= 0) str += static_cast<char>(c);
+        return str;
+    }
+    String readStringUntil(char terminator) {
+        String str;
+        int c;
+        while ((c = read()) >= 0 && c != terminator) str += static_cast<char>(c);
+        return str;
+    }
+};
+
+// Serial output goes to stdout, there is no input
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override { return fwrite(&c, 1, 1, stdout); }
+    size_t write(const uint8_t* buffer, size_t size) override { return fwrite(buffer, 1, size, stdout); }
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override { fflush(stdout); }
+    explicit operator bool() const { return true; }
+};
+
+static HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,7 @@
+#ifndef HOST_RF24_H
+#define HOST_RF24_H
+
+// The host tests drive simulated radios instead of the RF24 library
+#include <RadioSim.h>
+
+#endif // HOST_RF24_H
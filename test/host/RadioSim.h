@@ -0,0 +1,705 @@
+#ifndef HOST_RADIO_SIM_H
+#define HOST_RADIO_SIM_H
+
+/**
+ * @brief nRF24L01+ radios sharing a simulated 2.4 GHz medium, for the host tests
+ *
+ * RF24 (the subset of the RF24 library used by RadioManager) is backed by a RadioSim:
+ * every radio constructed while a RadioSim exists joins its medium. The simulation
+ * follows the Enhanced ShockBurst timing of the chip: 130 us TX/RX settling, frame airtime
+ * at 250 kbps, 1 or 2 Mbps, auto-acks with payloads, ARD/ARC retransmissions, duplicate
+ * suppression by PID, 3-entry RX and TX FIFOs, and RPD above -64 dBm.
+ *
+ * Each node (a radio and the code driving it) has its own virtual clock, which millis()
+ * and micros() return while the node runs. The scheduler always runs the node that is
+ * the furthest behind; a node waiting (delay(), or write() for its frame and ack) lets the
+ * others run up to the end of the wait, so frames sent meanwhile collide with its own.
+ *
+ * Links follow a log-distance path loss from the node positions; a frame is lost with the
+ * bit error rate of its margin above the sensitivity of its data rate, when another frame
+ * overlaps it at the receiver less than CAPTURE_DB below it, with the extra loss rate, or when
+ * the drop filter takes it.
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include <functional>
+#include <random>
+#include <vector>
+
+typedef enum { RF24_PA_MIN = 0, RF24_PA_LOW, RF24_PA_HIGH, RF24_PA_MAX, RF24_PA_ERROR } rf24_pa_dbm_e;
+typedef enum { RF24_1MBPS = 0, RF24_2MBPS, RF24_250KBPS } rf24_datarate_e;
+
+class RF24;
+
+namespace host {
+
+// Fixed-capacity FIFO, the simulation doesn't allocate once the radios are constructed
+template <typename T, size_t N>
+class Fifo {
+public:
+    Fifo() : head(0), count(0) {}
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == N; }
+    void clear() { count = 0; }
+    T& operator[](size_t i) { return items[(head + i) % N]; }
+    const T& operator[](size_t i) const { return items[(head + i) % N]; }
+    T& front() { return (*this)[0]; }
+    T& back() { return (*this)[count - 1]; }
+    // Drops the oldest item when full
+    T& push_back(const T& item) {
+        if (count == N) pop_front();
+        T& slot = items[(head + count++) % N];
+        slot = item;
+        return slot;
+    }
+    void pop_front() {
+        if (count == 0) return;
+        head = (head + 1) % N;
+        count--;
+    }
+    void erase(size_t i) {
+        for (; i + 1 < count; i++) (*this)[i] = (*this)[i + 1];
+        count--;
+    }
+
+private:
+    T items[N];
+    size_t head;
+    size_t count;
+};
+
+} // namespace host
+
+class RadioSim : public host::Clock {
+public:
+    static constexpr double CAPTURE_DB = 9.0;       // Co-channel rejection of the nRF24L01+ (1 Mbps)
+    static constexpr double RPD_THRESHOLD_DBM = -64.0;
+    static const uint32_t SETTLING_US = 130;         // TX/RX settling
+    static const uint32_t RPD_DELAY_US = 40;         // AGC delay before RPD is valid
+
+    struct Stats {
+        uint32_t frames;      // Transmissions, retransmissions included
+        uint32_t delivered;   // Frames stored in an RX FIFO
+        uint32_t collisions;  // Frames lost to an overlapping frame
+        uint32_t weak;        // Frames lost to bit errors (distance)
+        uint32_t dropped;     // Frames lost to the extra loss rate or the drop filter
+        uint32_t fifoFull;    // Frames discarded by a full RX FIFO
+        uint32_t acks;        // Acks received
+        uint64_t airtime;     // us of transmission, acks included
+    };
+
+    static const size_t AIR_SIZE = 256;              // Frames kept to find overlaps
+
+    RadioSim(uint32_t seed = 1) : now_(0), active(nullptr), loss(0), pathLossExponent(3.0), loopTime(20), random(seed) {
+        memset(&stats, 0, sizeof(stats));
+        slot() = this;
+        host::setClock(this);
+    }
+
+    ~RadioSim() {
+        host::setClock(nullptr);
+        slot() = nullptr;
+    }
+
+    static RadioSim* current() {
+        return slot();
+    }
+
+    // Node setup, radios are numbered in construction order
+    size_t nodeCount() const { return nodes.size(); }
+    void setLoop(size_t node, std::function<void()> loop) { nodes.at(node).loop = loop; }
+    void setPosition(size_t node, double x, double y = 0) { nodes.at(node).x = x; nodes.at(node).y = y; }
+    void setLoss(double rate) { loss = rate; }
+    // Frames for which the filter returns true are lost too, e.g. to drop a given frame
+    typedef std::function<bool(size_t sender, const uint8_t* payload, uint8_t length)> DropFilter;
+    void setDropFilter(DropFilter filter) { dropFilter = filter; }
+    void setPathLossExponent(double exponent) { pathLossExponent = exponent; }
+    void setLoopTime(uint32_t us) { loopTime = us; } // Duration of a loop() that didn't wait
+    RF24& radio(size_t node) { return *nodes.at(node).radio; }
+
+    // Runs the loops of all nodes for a duration (us)
+    void run(uint64_t duration) {
+        uint64_t until = now_ + duration;
+        for (Node& node : nodes) {
+            node.clock = std::max(node.clock, now_);
+        }
+        advance(until);
+        now_ = until;
+    }
+
+    // Runs until the condition holds (checked between loops) or the timeout (us) elapses
+    bool runUntil(std::function<bool()> condition, uint64_t timeout, uint64_t step = 1000) {
+        for (uint64_t elapsed = 0; elapsed < timeout; elapsed += step) {
+            if (condition()) return true;
+            run(step);
+        }
+        return condition();
+    }
+
+    // Clock of the node running, the simulation time outside of the loops
+    uint64_t now() override {
+        return active ? active->clock : now_;
+    }
+
+    void sleep(uint64_t duration) override {
+        if (active == nullptr) {
+            now_ += duration;
+            return;
+        }
+        active->clock += duration;
+        advance(active->clock);
+    }
+
+    Stats stats;
+
+private:
+    friend class RF24;
+
+    struct Node {
+        RF24* radio;
+        std::function<void()> loop;
+        uint64_t clock;
+        bool busy;
+        double x, y;
+    };
+
+    struct Transmission {
+        size_t sender;
+        uint8_t channel;
+        uint8_t rate;
+        double power;      // dBm
+        uint64_t start;
+        uint64_t end;
+    };
+
+    uint64_t now_;
+    Node* active;
+    std::vector<Node> nodes;
+    host::Fifo<Transmission, AIR_SIZE> air; // Latest frames
+    double loss;
+    DropFilter dropFilter;
+    double pathLossExponent;
+    uint32_t loopTime;
+    std::mt19937 random;
+
+    static RadioSim*& slot() {
+        static RadioSim* sim = nullptr;
+        return sim;
+    }
+
+    size_t attach(RF24* radio) {
+        Node node = { radio, nullptr, now_, false, 0, 0 };
+        nodes.push_back(node);
+        return nodes.size() - 1;
+    }
+
+    // Runs the loops of the nodes that are not waiting, until their clocks reach until
+    void advance(uint64_t until) {
+        while (true) {
+            Node* next = nullptr;
+            for (Node& node : nodes) {
+                if (!node.busy && node.loop && node.clock < until && (next == nullptr || node.clock < next->clock)) {
+                    next = &node;
+                }
+            }
+            if (next == nullptr) {
+                return;
+            }
+            Node* previous = active;
+            active = next;
+            next->busy = true;
+            uint64_t start = next->clock;
+            next->loop();
+            if (next->clock == start) {
+                next->clock += loopTime;
+            }
+            next->busy = false;
+            active = previous;
+        }
+    }
+
+    uint64_t nodeTime(size_t node) {
+        return (active == &nodes[node]) ? active->clock : (active ? active->clock : now_);
+    }
+
+    // Waits until a time on the clock of a node (the one running, or the caller outside the loops)
+    void waitUntil(size_t node, uint64_t time) {
+        if (active == &nodes[node]) {
+            if (time > active->clock) sleep(time - active->clock);
+        } else if (active == nullptr && time > now_) {
+            now_ = time;
+        }
+    }
+
+    double distance(size_t a, size_t b) const {
+        double dx = nodes[a].x - nodes[b].x, dy = nodes[a].y - nodes[b].y;
+        return sqrt(dx * dx + dy * dy);
+    }
+
+    // Received power (dBm) at a node of a transmission by another
+    double receivedPower(double power, size_t sender, size_t receiver) const {
+        double d = std::max(distance(sender, receiver), 0.1);
+        return power - (40.0 + 10.0 * pathLossExponent * log10(d));
+    }
+
+    static double sensitivity(uint8_t rate) {
+        return rate == RF24_250KBPS ? -94.0 : (rate == RF24_2MBPS ? -82.0 : -85.0);
+    }
+
+    static double bitRate(uint8_t rate) {
+        return rate == RF24_250KBPS ? 0.25 : (rate == RF24_2MBPS ? 2.0 : 1.0); // Mbit/s
+    }
+
+    // Enhanced ShockBurst frame: preamble, 5-byte address, 9-bit control field, payload, 2-byte CRC
+    static uint32_t frameBits(uint8_t length) {
+        return 8 * (1 + 5 + length + 2) + 9;
+    }
+
+    static uint32_t airtime(uint8_t rate, uint8_t length) {
+        return static_cast<uint32_t>(ceil(frameBits(length) / bitRate(rate)));
+    }
+
+    bool chance(double probability) {
+        return std::uniform_real_distribution<double>(0.0, 1.0)(random) < probability;
+    }
+
+    const Transmission& transmit(const Transmission& transmission) {
+        stats.frames++;
+        stats.airtime += transmission.end - transmission.start;
+        return air.push_back(transmission);
+    }
+
+    // Whether a frame reaches a node: interference, bit errors and extra loss
+    bool receives(const Transmission& frame, size_t receiver) {
+        double power = receivedPower(frame.power, frame.sender, receiver);
+        for (size_t i = 0; i < air.size(); i++) {
+            const Transmission& other = air[i];
+            if (&other == &frame || other.sender == receiver || other.channel != frame.channel) continue;
+            if (other.start >= frame.end || other.end <= frame.start) continue;
+            if (other.sender == frame.sender) continue;
+            if (receivedPower(other.power, other.sender, receiver) > power - CAPTURE_DB) {
+                stats.collisions++;
+                return false;
+            }
+        }
+        // Bit error rate of 1e-3 at the sensitivity, divided by about 2.5 per dB of margin
+        double margin = power - sensitivity(frame.rate);
+        double ber = std::min(0.5, 1e-3 * pow(10.0, -margin / 2.5));
+        uint32_t bits = static_cast<uint32_t>((frame.end - frame.start) * bitRate(frame.rate));
+        if (chance(1.0 - pow(1.0 - ber, bits))) {
+            stats.weak++;
+            return false;
+        }
+        if (chance(loss)) {
+            stats.dropped++;
+            return false;
+        }
+        return true;
+    }
+
+    // Whether the drop filter takes a frame, after the random losses so that it doesn't change them
+    bool filtered(size_t sender, const uint8_t* payload, uint8_t length) {
+        if (dropFilter && dropFilter(sender, payload, length)) {
+            stats.dropped++;
+            return true;
+        }
+        return false;
+    }
+
+    // Strongest signal (dBm) on a channel at a node over [start, end]
+    double carrier(size_t node, uint8_t channel, uint64_t start, uint64_t end) const {
+        double strongest = -200.0;
+        for (size_t i = 0; i < air.size(); i++) {
+            const Transmission& other = air[i];
+            if (other.sender == node || other.channel != channel) continue;
+            if (other.start >= end || other.end <= start) continue;
+            strongest = std::max(strongest, receivedPower(other.power, other.sender, node));
+        }
+        return strongest;
+    }
+
+    bool send(size_t sender, const uint8_t* address, const uint8_t* payload, uint8_t length, bool noAck, uint8_t& retransmits);
+};
+
+class RF24 {
+public:
+    RF24(uint16_t cePin, uint16_t csnPin) : sim(RadioSim::current()), node(0) {
+        (void)cePin;
+        (void)csnPin;
+        if (sim) {
+            node = sim->attach(this);
+        }
+        reset();
+    }
+
+    bool begin() {
+        reset();
+        return true;
+    }
+    bool isChipConnected() { return true; }
+
+    void setPALevel(uint8_t level, bool lnaEnable = true) {
+        (void)lnaEnable;
+        paLevel = std::min<uint8_t>(level, RF24_PA_MAX);
+    }
+    uint8_t getPALevel() { return paLevel; }
+    bool setDataRate(rf24_datarate_e rate) {
+        dataRate = rate;
+        reopenWindow();
+        return true;
+    }
+    rf24_datarate_e getDataRate() { return static_cast<rf24_datarate_e>(dataRate); }
+    void setChannel(uint8_t rfChannel) {
+        channel = std::min<uint8_t>(rfChannel, 125);
+        reopenWindow();
+    }
+    uint8_t getChannel() { return channel; }
+    void setPayloadSize(uint8_t size) { payloadSize = std::max<uint8_t>(1, std::min<uint8_t>(size, 32)); }
+    uint8_t getPayloadSize() { return payloadSize; }
+    void setRetries(uint8_t delay, uint8_t count) {
+        retryDelay = std::min<uint8_t>(delay, 15);
+        retryCount = std::min<uint8_t>(count, 15);
+    }
+    void setAutoAck(bool enable) { autoAck = enable ? 0x3F : 0; }
+    void setAutoAck(uint8_t pipe, bool enable) {
+        if (pipe < 6) autoAck = enable ? (autoAck | (1 << pipe)) : (autoAck & ~(1 << pipe));
+    }
+    void enableDynamicPayloads() { dynamicPayloads = true; }
+    void disableDynamicPayloads() { dynamicPayloads = false; ackPayloads = false; }
+    void enableAckPayload() { dynamicPayloads = true; ackPayloads = true; }
+    void disableAckPayload() { ackPayloads = false; }
+    void enableDynamicAck() { dynamicAck = true; }
+
+    void openReadingPipe(uint8_t pipe, const uint8_t* address) {
+        if (pipe == 0) {
+            memcpy(pipe0Address, address, 5);
+            pipe0Reading = true;
+        } else if (pipe == 1) {
+            memcpy(pipe1Address, address, 5);
+        } else if (pipe < 6) {
+            pipeLsb[pipe] = address[0];
+        } else {
+            return;
+        }
+        if (pipe > 0 || listening) enabledPipes |= 1 << pipe;
+        reopenWindow();
+    }
+    void closeReadingPipe(uint8_t pipe) {
+        if (pipe < 6) enabledPipes &= ~(1 << pipe);
+        if (pipe == 0) pipe0Reading = false;
+        reopenWindow();
+    }
+    void openWritingPipe(const uint8_t* address) {
+        memcpy(txAddress, address, 5);
+    }
+
+    void startListening() {
+        if (ackPayloads) txFifo.clear();
+        if (pipe0Reading) {
+            enabledPipes |= 1;
+        } else {
+            enabledPipes &= ~1;
+        }
+        listening = true;
+        openWindow(time() + RadioSim::SETTLING_US);
+    }
+    void stopListening() {
+        if (ackPayloads) txFifo.clear();
+        closeWindow();
+        listening = false;
+        enabledPipes |= 1; // Pipe 0 receives the acks
+    }
+    void powerDown() { closeWindow(); listening = false; }
+    void powerUp() {}
+
+    bool available() {
+        uint8_t pipe;
+        return available(&pipe);
+    }
+    bool available(uint8_t* pipe) {
+        if (rxFifo.empty() || rxFifo.front().arrival > time()) {
+            return false;
+        }
+        if (pipe) *pipe = rxFifo.front().pipe;
+        return true;
+    }
+    bool rxFifoFull() { return rxFifo.full(); }
+    uint8_t getDynamicPayloadSize() { return rxFifo.empty() ? 0 : rxFifo.front().length; }
+    void read(void* buffer, uint8_t length) {
+        if (rxFifo.empty()) return;
+        const Frame& frame = rxFifo.front();
+        memcpy(buffer, frame.data, std::min<uint8_t>(length, 32));
+        rxFifo.pop_front();
+    }
+    void flush_rx() { rxFifo.clear(); }
+    void flush_tx() { txFifo.clear(); }
+
+    bool write(const void* buffer, uint8_t length) { return write(buffer, length, false); }
+    bool write(const void* buffer, uint8_t length, const bool multicast) {
+        uint8_t frame[32] = { 0 };
+        length = std::min<uint8_t>(length, 32);
+        memcpy(frame, buffer, length);
+        if (!dynamicPayloads) {
+            length = payloadSize; // Static payloads are padded
+        }
+        pid = (pid + 1) & 3;
+        if (sim == nullptr) {
+            lastRetransmits = retryCount;
+            return false;
+        }
+        bool sent = sim->send(node, txAddress, frame, length, multicast && dynamicAck, lastRetransmits);
+        if (!sent) {
+            txFifo.clear(); // MAX_RT, the library flushes the payload
+        }
+        return sent;
+    }
+    uint8_t getARC() { return lastRetransmits; }
+
+    bool writeAckPayload(uint8_t pipe, const void* buffer, uint8_t length) {
+        if (!ackPayloads || txFifo.full() || pipe > 5) {
+            return false;
+        }
+        Frame frame;
+        frame.pipe = pipe;
+        frame.length = std::min<uint8_t>(length, 32);
+        frame.arrival = 0;
+        memcpy(frame.data, buffer, frame.length);
+        txFifo.push_back(frame);
+        return true;
+    }
+    bool isAckPayloadAvailable() { return available(); }
+
+    // Received power above -64 dBm: during the last 40 us of listening, or latched by the last frame
+    bool testRPD() {
+        if (!listening || sim == nullptr) return false;
+        uint64_t now = time();
+        if (now < rxSince + RadioSim::RPD_DELAY_US) return rpdLatched;
+        return rpdLatched || sim->carrier(node, channel, now - RadioSim::RPD_DELAY_US, now) > RadioSim::RPD_THRESHOLD_DBM;
+    }
+    bool testCarrier() { return testRPD(); }
+
+private:
+    friend class RadioSim;
+
+    static const uint8_t FIFO_SIZE = 3;
+
+    struct Frame {
+        uint8_t pipe;
+        uint8_t length;
+        uint64_t arrival;
+        uint8_t data[32];
+    };
+
+    // Configuration of the radio while it listened
+    struct Window {
+        uint64_t start;
+        uint64_t end;
+        uint8_t channel;
+        uint8_t rate;
+        uint8_t enabledPipes;
+        uint8_t autoAck;
+        uint8_t addresses[6][5];
+    };
+
+    RadioSim* sim;
+    size_t node;
+
+    uint8_t channel;
+    uint8_t dataRate;
+    uint8_t paLevel;
+    uint8_t payloadSize;
+    uint8_t retryDelay;
+    uint8_t retryCount;
+    uint8_t autoAck;
+    bool dynamicPayloads;
+    bool ackPayloads;
+    bool dynamicAck;
+    bool listening;
+    uint64_t rxSince;
+    bool rpdLatched;
+
+    uint8_t pipe0Address[5];
+    uint8_t pipe1Address[5];
+    uint8_t pipeLsb[6];
+    uint8_t enabledPipes;
+    bool pipe0Reading;
+    uint8_t txAddress[5];
+
+    host::Fifo<Frame, FIFO_SIZE> rxFifo;
+    host::Fifo<Frame, FIFO_SIZE> txFifo; // Ack payloads
+    uint8_t pid;
+    uint8_t lastRetransmits;
+    uint8_t lastPid[6];
+    uint8_t lastData[6][32];
+    uint8_t lastLength[6];
+    host::Fifo<Window, 8> windows; // Latest listening configurations
+
+    // Power-on defaults of the RF24 library
+    void reset() {
+        channel = 76;
+        dataRate = RF24_1MBPS;
+        paLevel = RF24_PA_MAX;
+        payloadSize = 32;
+        retryDelay = 5;
+        retryCount = 15;
+        autoAck = 0x3F;
+        dynamicPayloads = false;
+        ackPayloads = false;
+        dynamicAck = false;
+        listening = false;
+        rxSince = 0;
+        rpdLatched = false;
+        memset(pipe0Address, 0xE7, sizeof(pipe0Address));
+        memset(pipe1Address, 0xC2, sizeof(pipe1Address));
+        const uint8_t lsb[6] = { 0xE7, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6 };
+        memcpy(pipeLsb, lsb, sizeof(pipeLsb));
+        enabledPipes = 0x03;
+        pipe0Reading = false;
+        memset(txAddress, 0xE7, sizeof(txAddress));
+        rxFifo.clear();
+        txFifo.clear();
+        pid = 0;
+        lastRetransmits = 0;
+        memset(lastPid, 0xFF, sizeof(lastPid));
+        memset(lastLength, 0, sizeof(lastLength));
+        windows.clear();
+    }
+
+    uint64_t time() {
+        return sim ? sim->nodeTime(node) : host::clock().now();
+    }
+
+    void openWindow(uint64_t start) {
+        rxSince = start;
+        rpdLatched = false;
+        Window window;
+        window.start = start;
+        window.end = UINT64_MAX;
+        window.channel = channel;
+        window.rate = dataRate;
+        window.enabledPipes = enabledPipes;
+        window.autoAck = autoAck;
+        memcpy(window.addresses[0], pipe0Address, 5);
+        for (uint8_t pipe = 1; pipe < 6; pipe++) {
+            memcpy(window.addresses[pipe], pipe1Address, 5);
+            window.addresses[pipe][0] = (pipe == 1) ? pipe1Address[0] : pipeLsb[pipe];
+        }
+        windows.push_back(window);
+    }
+
+    void closeWindow() {
+        if (listening && !windows.empty() && windows.back().end == UINT64_MAX) {
+            windows.back().end = time();
+        }
+    }
+
+    // Changing the configuration while listening starts a new window (the radio keeps receiving)
+    void reopenWindow() {
+        if (listening) {
+            closeWindow();
+            uint64_t start = time();
+            openWindow(start);
+            rxSince = start;
+        }
+    }
+
+    // Pipe accepting a frame received over [start, end], -1 if none
+    int acceptingPipe(const uint8_t* address, uint8_t rfChannel, uint8_t rate, uint64_t start, uint64_t end, uint8_t* ackMask) const {
+        for (size_t i = 0; i < windows.size(); i++) {
+            const Window& window = windows[i];
+            if (window.start > start || window.end < end || window.channel != rfChannel || window.rate != rate) continue;
+            for (uint8_t pipe = 0; pipe < 6; pipe++) {
+                if ((window.enabledPipes & (1 << pipe)) && memcmp(window.addresses[pipe], address, 5) == 0) {
+                    *ackMask = window.autoAck;
+                    return pipe;
+                }
+            }
+        }
+        return -1;
+    }
+};
+
+/**
+ * @brief Sends a frame with Enhanced ShockBurst retransmissions
+ *
+ * @return true if acknowledged (or sent, without acknowledgement)
+ */
+inline bool RadioSim::send(size_t sender, const uint8_t* address, const uint8_t* payload, uint8_t length, bool noAck, uint8_t& retransmits) {
+    static const double PA_DBM[4] = { -18.0, -12.0, -6.0, 0.0 };
+    RF24& tx = *nodes[sender].radio;
+    uint64_t start = nodeTime(sender) + SETTLING_US;
+
+    for (uint8_t attempt = 0; attempt <= tx.retryCount; attempt++) {
+        Transmission frame = { sender, tx.channel, tx.dataRate, PA_DBM[tx.paLevel], start, start + airtime(tx.dataRate, length) };
+        transmit(frame);
+        waitUntil(sender, frame.end);
+        retransmits = attempt;
+
+        // First node listening to the address receives and acknowledges
+        for (size_t receiver = 0; receiver < nodes.size(); receiver++) {
+            if (receiver == sender) continue;
+            RF24& rx = *nodes[receiver].radio;
+            uint8_t ackMask = 0;
+            int pipe = rx.acceptingPipe(address, frame.channel, frame.rate, frame.start, frame.end, &ackMask);
+            if (pipe < 0 || !receives(frame, receiver) || filtered(sender, payload, length)) continue;
+
+            bool duplicate = rx.lastPid[pipe] == tx.pid && rx.lastLength[pipe] == length &&
+                             memcmp(rx.lastData[pipe], payload, length) == 0 && !noAck;
+            if (!duplicate) {
+                if (rx.rxFifo.full()) {
+                    stats.fifoFull++;
+                    continue; // Discarded without ack
+                }
+                RF24::Frame received;
+                received.pipe = pipe;
+                received.length = length;
+                received.arrival = frame.end;
+                memcpy(received.data, payload, length);
+                rx.rxFifo.push_back(received);
+                rx.rpdLatched = receivedPower(frame.power, sender, receiver) > RPD_THRESHOLD_DBM;
+                rx.lastPid[pipe] = tx.pid;
+                rx.lastLength[pipe] = length;
+                memcpy(rx.lastData[pipe], payload, length);
+                stats.delivered++;
+            }
+            if (noAck) continue; // Every listener gets unacknowledged frames
+            if (!(ackMask & (1 << pipe))) break;
+
+            // Auto-ack, with the first ack payload loaded for the pipe
+            uint8_t ackLength = 0;
+            RF24::Frame ackPayload;
+            for (size_t i = 0; i < rx.txFifo.size(); i++) {
+                if (rx.txFifo[i].pipe == pipe) {
+                    ackPayload = rx.txFifo[i];
+                    ackLength = ackPayload.length;
+                    rx.txFifo.erase(i);
+                    break;
+                }
+            }
+            uint64_t ackStart = frame.end + SETTLING_US;
+            Transmission ack = { receiver, frame.channel, frame.rate, PA_DBM[rx.paLevel], ackStart, ackStart + airtime(frame.rate, ackLength) };
+            transmit(ack);
+            waitUntil(sender, ack.end);
+            if (!receives(ack, sender)) break;
+            stats.acks++;
+            if (ackLength > 0 && !tx.rxFifo.full()) {
+                ackPayload.pipe = 0;
+                ackPayload.arrival = ack.end;
+                tx.rxFifo.push_back(ackPayload);
+            }
+            return true;
+        }
+        if (noAck) {
+            return true;
+        }
+        // No ack: retransmit after the auto retransmit delay
+        start = frame.end + 250 * (tx.retryDelay + 1);
+        waitUntil(sender, start - SETTLING_US);
+    }
+    waitUntil(sender, start - 250 * (tx.retryDelay + 1) + 250);
+    return false;
+}
+
+#endif // HOST_RADIO_SIM_H
@@ -0,0 +1,166 @@
+#ifndef HOST_SENDER_NETWORK_H
+#define HOST_SENDER_NETWORK_H
+
+/**
+ * @brief Senders around a collector in a RadioSim, for the shared-channel benchmarks
+ *
+ * Sender i (node i + 1) sits on a 2 m circle around the collector (node 0), where every node
+ * hears the others above -64 dBm, and is paired with it directly: the collector listens to it
+ * on pipe i + 1 (its channel i), the sender to the collector on pipe 1 (its channel 0).
+ * measure() then has every sender send encrypted messages to the collector, either all on
+ * the same schedule (a report every period) or back to back, and adds the outcome to a
+ * NetworkResult, so that runs with several seeds can be summed before finish(). The sender
+ * statistics are added too, from begin() on: measure() once per network.
+ */
+
+#include <unity.h>
+#include <RadioManager.h>
+#include <math.h>
+#include <memory>
+#include <vector>
+
+struct NetworkResult {
+    double goodput;      // kbit/s of message bytes received by the collector
+    uint32_t sent;       // Messages handed to sendMsg()
+    uint32_t completed;  // Messages done sending, acknowledged or aborted
+    uint32_t received;   // Messages received intact
+    uint32_t failed;     // Messages aborted by their sender
+    uint32_t skipped;    // Reports not sent, the previous one still in progress
+    double latency;      // Average ms from sendMsg() to the end of sending
+    uint32_t fragments;  // Fragments acknowledged
+    uint32_t retries;    // Retransmissions
+    uint32_t busy;       // Busy channel checks
+    uint64_t duration;   // us measured, all runs
+    uint64_t latencySum; // us, all completed messages
+    uint64_t bytes;      // Message bytes received intact
+
+    // Averages of the runs added so far
+    void finish() {
+        goodput = duration ? bytes * 8.0 / (duration / 1000.0) : 0;
+        latency = completed ? latencySum / 1000.0 / completed : 0;
+    }
+
+    void report(const char* load, uint8_t senders) const {
+        char message[200];
+        snprintf(message, sizeof(message),
+                 "%-9s %u senders: %6.1f kbit/s, %5u/%5u received, %4u failed, %4u skipped, %6.2f ms, %5.2f retries/fragment, %5u busy",
+                 load, senders, goodput, static_cast<unsigned>(received), static_cast<unsigned>(sent),
+                 static_cast<unsigned>(failed), static_cast<unsigned>(skipped), latency,
+                 fragments ? static_cast<double>(retries) / fragments : 0.0, static_cast<unsigned>(busy));
+        TEST_MESSAGE(message);
+    }
+};
+
+class SenderNetwork {
+public:
+    static const uint8_t MAX_SENDERS = 5; // One collector pipe each
+    static const size_t MAX_MESSAGE_SIZE = 256;
+
+    struct Sender {
+        std::unique_ptr<RadioManager> node;
+        uint8_t status;
+        uint64_t start;
+    };
+
+    SenderNetwork(uint8_t senders, uint32_t seed) : sim(seed), random(seed), collector(1, 2, "COLL"), nodes(senders) {
+        for (uint8_t i = 0; i < senders; i++) {
+            char id[5];
+            snprintf(id, sizeof(id), "SND%u", i % 10);
+            nodes[i].node.reset(new RadioManager(1, 2, id));
+            nodes[i].status = 1;
+            nodes[i].start = 0;
+            double angle = 2 * M_PI * i / senders;
+            sim.setPosition(i + 1, 2 * cos(angle), 2 * sin(angle));
+        }
+        sim.setLoop(0, [this] { collector.loop(); });
+        for (uint8_t i = 0; i < senders; i++) {
+            RadioManager* node = nodes[i].node.get();
+            sim.setLoop(i + 1, [node] { node->loop(); });
+        }
+        TEST_ASSERT_TRUE(collector.begin());
+        Bytes collectorKey, senderKey, privateKey;
+        collector.getPersonalKeys(collectorKey, privateKey);
+        for (uint8_t i = 0; i < senders; i++) {
+            RadioManager& node = *nodes[i].node;
+            TEST_ASSERT_TRUE(node.begin());
+            node.getPersonalKeys(senderKey, privateKey);
+            String collectorAddr = String(static_cast<char>('1' + i)) + "COLL";
+            String senderAddr = String("1SND") + String(i);
+            TEST_ASSERT_TRUE(node.setPairedAddr(collectorAddr, 0, collectorKey));
+            TEST_ASSERT_TRUE(collector.setPairedAddr(senderAddr, i, senderKey));
+        }
+    }
+
+    /**
+     * @brief Sends messages from every sender to the collector and adds the outcome to result
+     *
+     * @param periodic Whether the senders report every period, otherwise they send back to back
+     * @param period us between reports
+     * @param duration us measured
+     * @param messageSize Bytes of each message, at most MAX_MESSAGE_SIZE
+     */
+    void measure(bool periodic, uint64_t period, uint64_t duration, size_t messageSize, NetworkResult& result) {
+        uint8_t message[MAX_MESSAGE_SIZE], received[MAX_MESSAGE_SIZE];
+        TEST_ASSERT_TRUE(messageSize <= sizeof(message));
+        for (size_t i = 0; i < messageSize; i++) message[i] = static_cast<uint8_t>(i * 29 + 1);
+        uint64_t nextReport = sim.now();
+        uint64_t end = sim.now() + duration;
+        while (sim.now() < end) {
+            bool report = periodic && sim.now() >= nextReport;
+            if (report) {
+                nextReport += period;
+            }
+            for (Sender& sender : nodes) {
+                if (sender.status != 0 && sender.start != 0) {
+                    // Done since the last step
+                    result.latencySum += sim.now() - sender.start;
+                    result.completed++;
+                    if (sender.status != 1) result.failed++;
+                    sender.start = 0;
+                }
+                if (periodic && !report) {
+                    continue;
+                }
+                if (sender.status == 0) {
+                    result.skipped += report ? 1 : 0;
+                    continue;
+                }
+                sender.status = 0;
+                sender.start = sim.now();
+                sender.node->sendMsg(message, messageSize, 0, &sender.status, true);
+                result.sent++;
+            }
+            sim.run(500);
+            for (uint8_t i = 0; i < nodes.size(); i++) {
+                while (collector.isMsgAvailable(i)) {
+                    size_t length = collector.readMsg(i, received, sizeof(received));
+                    if (length == messageSize && memcmp(received, message, length) == 0) {
+                        result.bytes += length;
+                        result.received++;
+                    }
+                }
+            }
+        }
+        for (Sender& sender : nodes) {
+            const RadioStats& stats = sender.node->getStats(0);
+            result.fragments += stats.fragmentsSent;
+            result.retries += stats.retries;
+            result.busy += stats.channelBusy;
+        }
+        result.duration += duration;
+    }
+
+    RadioSim sim;
+
+private:
+    // Seeds the RNG of the nodes before they are constructed
+    struct RandomSeed {
+        explicit RandomSeed(uint32_t seed) { randomSeed(seed); }
+    } random;
+
+public:
+    RadioManager collector;
+    std::vector<Sender> nodes;
+};
+
+#endif // HOST_SENDER_NETWORK_H
@@ -0,0 +1,29 @@
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+// Hardware RNG and MAC address of the ESP32, for the host tests
+
+#include <Arduino.h>
+
+enum esp_mac_type_t {
+    ESP_MAC_WIFI_STA
+};
+
+inline uint32_t esp_random() {
+    return host::rng()();
+}
+
+inline void esp_fill_random(void* buffer, size_t length) {
+    uint8_t* bytes = static_cast<uint8_t*>(buffer);
+    for (size_t i = 0; i < length; i++) {
+        bytes[i] = static_cast<uint8_t>(host::rng()());
+    }
+}
+
+inline int esp_read_mac(uint8_t* mac, esp_mac_type_t) {
+    static const uint8_t address[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+    memcpy(mac, address, sizeof(address));
+    return 0;
+}
+
+#endif // HOST_ESP_SYSTEM_H
@@ -0,0 +1,206 @@
+#include <unity.h>
+#include <Base64.h>
+#include <chrono>
+
+/*
+ * Base64 microbenchmark: the String-based implementation this library shipped before the
+ * block-wise codec (kept below as legacy::Base64) against the current one, on 32-byte keys
+ * and 4 KB blobs. Prints the time per call; the results of both are also checked against
+ * each other. The SSSE3 path of Base64.h is only compiled with -mssse3, e.g.
+ * PLATFORMIO_BUILD_FLAGS=-mssse3 pio test -e native -f test_base64_bench
+ */
+
+namespace legacy {
+
+class Base64 {
+public:
+    static String encode(const uint8_t* data, size_t length) {
+        static const char* encoding_table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        size_t output_length = 4 * ((length + 2) / 3);
+        String encoded;
+        encoded.reserve(output_length);
+
+        for (size_t i = 0; i < length;) {
+            uint32_t octet_a = i < length ? data[i++] : 0;
+            uint32_t octet_b = i < length ? data[i++] : 0;
+            uint32_t octet_c = i < length ? data[i++] : 0;
+
+            uint32_t triple = (octet_a << 0x10) + (octet_b << 0x08) + octet_c;
+
+            encoded += encoding_table[(triple >> 3 * 6) & 0x3F];
+            encoded += encoding_table[(triple >> 2 * 6) & 0x3F];
+            encoded += encoding_table[(triple >> 1 * 6) & 0x3F];
+            encoded += encoding_table[(triple >> 0 * 6) & 0x3F];
+        }
+
+        switch (length % 3) {
+            case 1:
+                encoded[output_length - 1] = '=';
+                encoded[output_length - 2] = '=';
+                break;
+            case 2:
+                encoded[output_length - 1] = '=';
+                break;
+        }
+
+        return encoded;
+    }
+
+    static String encode(const Bytes& data) {
+        return encode(data.data(), data.size());
+    }
+
+    static size_t decode(const String& input, uint8_t* output) {
+        static const uint8_t decoding_table[256] = {
+            64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+            64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+            64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 62, 64, 64, 64, 63,
+            52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 64, 64, 64, 64, 64, 64,
+            64,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+            15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 64, 64, 64, 64, 64,
+            64, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+            41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 64, 64, 64, 64, 64,
+            64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+            64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+            64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+            64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+            64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+            64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+            64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64
+        };
+
+        size_t input_length = input.length();
+        if (input_length % 4 != 0) return 0;
+
+        size_t output_length = input_length / 4 * 3;
+        if (input[input_length - 1] == '=') output_length--;
+        if (input[input_length - 2] == '=') output_length--;
+
+        size_t i, j;
+        for (i = 0, j = 0; i < input_length;) {
+            uint32_t sextet_a = input[i] == '=' ? 0 & i++ : decoding_table[uint8_t(input[i++])];
+            uint32_t sextet_b = input[i] == '=' ? 0 & i++ : decoding_table[uint8_t(input[i++])];
+            uint32_t sextet_c = input[i] == '=' ? 0 & i++ : decoding_table[uint8_t(input[i++])];
+            uint32_t sextet_d = input[i] == '=' ? 0 & i++ : decoding_table[uint8_t(input[i++])];
+
+            uint32_t triple = (sextet_a << 3 * 6)
+                + (sextet_b << 2 * 6)
+                + (sextet_c << 1 * 6)
+                + (sextet_d << 0 * 6);
+
+            if (j < output_length) output[j++] = (triple >> 2 * 8) & 0xFF;
+            if (j < output_length) output[j++] = (triple >> 1 * 8) & 0xFF;
+            if (j < output_length) output[j++] = (triple >> 0 * 8) & 0xFF;
+        }
+
+        return output_length;
+    }
+
+    static Bytes decode(const String& input) {
+        Bytes output;
+        decode(input, output);
+        return output;
+    }
+
+    static bool decode(const String& input, Bytes& output) {
+        size_t output_length = decodedLength(input.c_str(), input.length());
+        output.resize(output_length);
+        size_t decoded_size = decode(input, output.data());
+        return decoded_size == output_length;
+    }
+
+    static size_t encodedLength(size_t length) {
+        return 4 * ((length + 2) / 3);
+    }
+
+    static size_t decodedLength(const char* input, size_t input_length) {
+        size_t padding = 0;
+        if (input_length > 0 && input[input_length - 1] == '=') padding++;
+        if (input_length > 1 && input[input_length - 2] == '=') padding++;
+        return (input_length / 4) * 3 - padding;
+    }
+};
+
+} // namespace legacy
+
+static volatile size_t sink; // Keeps the results alive
+
+// Average time of a call in ns, repeated for at least 50 ms
+template <typename F>
+static double measure(F call) {
+    typedef std::chrono::steady_clock Clock;
+    uint32_t iterations = 0;
+    Clock::time_point start = Clock::now();
+    Clock::duration elapsed;
+    do {
+        for (int i = 0; i < 64; i++) {
+            sink = sink + call();
+        }
+        iterations += 64;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(50));
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+static void report(const char* name, size_t length, double legacyNs, double currentNs) {
+    char message[160];
+    snprintf(message, sizeof(message), "%s %5u B: legacy %9.1f ns (%7.1f MB/s), current %9.1f ns (%7.1f MB/s), x%.1f",
+             name, static_cast<unsigned>(length), legacyNs, length * 1e3 / legacyNs,
+             currentNs, length * 1e3 / currentNs, legacyNs / currentNs);
+    TEST_MESSAGE(message);
+}
+
+static void benchmark(size_t length) {
+    std::vector<uint8_t> data(length);
+    for (size_t i = 0; i < length; i++) {
+        data[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+    const size_t encodedLength = Base64::encodedLength(length);
+    std::vector<char> encoded(encodedLength + 1);
+    std::vector<uint8_t> decoded(length);
+
+    // Same results
+    String reference = legacy::Base64::encode(data.data(), length);
+    TEST_ASSERT_EQUAL_UINT32(encodedLength, Base64::encode(data.data(), length, encoded.data(), encoded.size()));
+    TEST_ASSERT_EQUAL_STRING(reference.c_str(), encoded.data());
+    TEST_ASSERT_EQUAL_UINT32(length, Base64::decode(encoded.data(), encodedLength, decoded.data(), decoded.size()));
+    TEST_ASSERT_EQUAL_MEMORY(data.data(), decoded.data(), length);
+    TEST_ASSERT_EQUAL_UINT32(length, legacy::Base64::decode(reference, decoded.data()));
+    TEST_ASSERT_EQUAL_MEMORY(data.data(), decoded.data(), length);
+
+    report("encode to String", length,
+           measure([&] { return legacy::Base64::encode(data.data(), length).length(); }),
+           measure([&] { return Base64::encode(data.data(), length).length(); }));
+    report("encode to buffer", length,
+           measure([&] { return legacy::Base64::encode(data.data(), length).length(); }),
+           measure([&] { return Base64::encode(data.data(), length, encoded.data(), encoded.size()); }));
+    report("decode to buffer", length,
+           measure([&] { return legacy::Base64::decode(reference, decoded.data()); }),
+           measure([&] { return Base64::decode(encoded.data(), encodedLength, decoded.data(), decoded.size()); }));
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_key() {
+    benchmark(32);
+}
+
+void test_blob() {
+    benchmark(4096);
+}
+
+int main() {
+#ifdef BASE64_SIMD
+    TEST_MESSAGE("Base64.h: SSSE3 path");
+#else
+    TEST_MESSAGE("Base64.h: scalar path");
+#endif
+    UNITY_BEGIN();
+    RUN_TEST(test_key);
+    RUN_TEST(test_blob);
+    return UNITY_END();
+}
@@ -0,0 +1,139 @@
+#include <unity.h>
+#include <RadioManager.h>
+#include <chrono>
+#if defined(__GLIBC__)
+    #include <malloc.h>
+#endif
+
+/*
+ * Configuration save/load benchmark: binary snapshot (exportCfgBin/importCfgBin) against
+ * JSON (exportCfg/importCfg), with every channel paired with a key. Prints the size, the
+ * time per call and the heap peak of each; the JSON import recomputes the shared key of
+ * every peer, the snapshot restores them. Heap usage is only tracked with glibc.
+ */
+
+static bool tracking = false;
+static size_t heapUsed = 0; // Bytes allocated since tracking started
+static size_t heapPeak = 0;
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* buffer, size_t size);
+void __libc_free(void* buffer);
+
+static void track(void* buffer, bool allocated) {
+    if (!tracking || buffer == nullptr) return;
+    size_t size = malloc_usable_size(buffer);
+    if (allocated) {
+        heapUsed += size;
+        heapPeak = std::max(heapPeak, heapUsed);
+    } else {
+        heapUsed = heapUsed > size ? heapUsed - size : 0; // Blocks allocated before tracking
+    }
+}
+
+void* malloc(size_t size) {
+    void* buffer = __libc_malloc(size);
+    track(buffer, true);
+    return buffer;
+}
+
+void* calloc(size_t count, size_t size) {
+    void* buffer = __libc_calloc(count, size);
+    track(buffer, true);
+    return buffer;
+}
+
+void* realloc(void* buffer, size_t size) {
+    track(buffer, false);
+    void* resized = __libc_realloc(buffer, size);
+    track(resized ? resized : buffer, true);
+    return resized;
+}
+
+void free(void* buffer) {
+    track(buffer, false);
+    __libc_free(buffer);
+}
+}
+#endif
+
+struct Measure {
+    double us;      // Average time per call
+    size_t peak;    // Heap peak of one call
+};
+
+template <typename F>
+static Measure measure(F call) {
+    heapUsed = 0;
+    heapPeak = 0;
+    tracking = true;
+    TEST_ASSERT_TRUE(call());
+    tracking = false;
+    Measure result = { 0, heapPeak };
+
+    typedef std::chrono::steady_clock Clock;
+    uint32_t iterations = 0;
+    Clock::time_point start = Clock::now();
+    Clock::duration elapsed;
+    do {
+        call();
+        iterations++;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(100));
+    result.us = std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+    return result;
+}
+
+static void report(const char* name, size_t size, const Measure& save, const Measure& load) {
+    char message[160];
+    snprintf(message, sizeof(message), "%-6s %4u B: save %8.1f us, heap peak %5u B | load %8.1f us, heap peak %5u B",
+             name, static_cast<unsigned>(size), save.us, static_cast<unsigned>(save.peak),
+             load.us, static_cast<unsigned>(load.peak));
+    TEST_MESSAGE(message);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+    tracking = false;
+}
+
+void test_binary_vs_json() {
+    RadioSim sim;
+    RadioManager node(1, 2, "NODE"), restored(3, 4, "NODE");
+    TEST_ASSERT_TRUE(node.begin());
+    TEST_ASSERT_TRUE(restored.begin());
+    for (uint8_t channel = 0; channel < RadioManager::MAX_CHANNELS; channel++) {
+        char id[5];
+        snprintf(id, sizeof(id), "PR%02u", channel);
+        RadioManager peer(5, 6, id);
+        Bytes publicKey, privateKey;
+        peer.getPersonalKeys(publicKey, privateKey);
+        String addr = String(static_cast<char>('1' + channel % RadioManager::PIPE_COUNT)) + id;
+        TEST_ASSERT_TRUE(node.setPairedAddr(addr, channel, publicKey));
+    }
+
+    String json = node.exportCfg();
+    uint8_t snapshot[RadioManager::CFG_BIN_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(RadioManager::CFG_BIN_SIZE, node.exportCfgBin(snapshot, sizeof(snapshot)));
+
+    Measure jsonSave = measure([&] { return node.exportCfg().length() == json.length(); });
+    Measure jsonLoad = measure([&] { return restored.importCfg(json); });
+    TEST_ASSERT_EQUAL_STRING(json.c_str(), restored.exportCfg().c_str());
+    Measure binarySave = measure([&] { return node.exportCfgBin(snapshot, sizeof(snapshot)) == sizeof(snapshot); });
+    Measure binaryLoad = measure([&] { return restored.importCfgBin(snapshot, sizeof(snapshot)); });
+    TEST_ASSERT_EQUAL_STRING(json.c_str(), restored.exportCfg().c_str());
+
+    report("JSON", json.length(), jsonSave, jsonLoad);
+    report("binary", sizeof(snapshot), binarySave, binaryLoad);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_binary_vs_json);
+    return UNITY_END();
+}
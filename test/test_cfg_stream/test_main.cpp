@@ -0,0 +1,156 @@
+#include <unity.h>
+#include <RadioManager.h>
+#include <stdio.h>
+#include <unistd.h>
+
+/*
+ * exportCfg(Print&) / importCfg(Stream&) through a file, as done with a SPIFFS/LittleFS
+ * File on the device: the configuration written by one node is read back by another one,
+ * which must end up with the same keys, pairings and exported JSON.
+ */
+
+static char path[] = "/tmp/radio_cfg_XXXXXX";
+
+// Stream over a stdio file, like fs::File
+class FileStream : public Stream {
+public:
+    FileStream(const char* name, const char* mode) : file(fopen(name, mode)) {}
+    ~FileStream() { close(); }
+
+    void close() {
+        if (file) fclose(file);
+        file = nullptr;
+    }
+    explicit operator bool() const { return file != nullptr; }
+
+    size_t write(uint8_t c) override { return fputc(c, file) == EOF ? 0 : 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { return fwrite(buffer, 1, size, file); }
+    using Print::write;
+
+    int available() override {
+        long position = ftell(file);
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, position, SEEK_SET);
+        return static_cast<int>(size - position);
+    }
+    int read() override { return fgetc(file); }
+    int peek() override {
+        int c = fgetc(file);
+        if (c != EOF) ungetc(c, file);
+        return c;
+    }
+
+private:
+    FILE* file;
+};
+
+static String readFile(const char* name) {
+    FileStream input(name, "rb");
+    return input ? input.readString() : String();
+}
+
+// Node paired with a peer with its key on channel 0, one without key on channel 2
+static void configure(RadioManager& node, RadioManager& peer) {
+    Bytes peerPublicKey, peerPrivateKey;
+    peer.getPersonalKeys(peerPublicKey, peerPrivateKey);
+    String keyedAddr = "1PEER";
+    String plainAddr = "3PLN2";
+    TEST_ASSERT_TRUE(node.setPairedAddr(keyedAddr, 0, peerPublicKey));
+    TEST_ASSERT_TRUE(node.setPairedAddr(plainAddr, 2));
+}
+
+void setUp() {
+}
+
+void tearDown() {
+    remove(path);
+}
+
+void test_round_trip_through_file() {
+    RadioSim sim;
+    RadioManager node(1, 2, "NODE"), peer(3, 4, "PEER"), restored(5, 6, "NODE");
+    TEST_ASSERT_TRUE(node.begin());
+    TEST_ASSERT_TRUE(restored.begin());
+    configure(node, peer);
+
+    FileStream output(path, "wb");
+    TEST_ASSERT_TRUE(output);
+    size_t written = node.exportCfg(output);
+    output.close();
+
+    String expected = node.exportCfg();
+    TEST_ASSERT_EQUAL_UINT32(expected.length(), written);
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), readFile(path).c_str());
+
+    FileStream input(path, "rb");
+    TEST_ASSERT_TRUE(input);
+    TEST_ASSERT_TRUE(restored.importCfg(input));
+
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), restored.exportCfg().c_str());
+    Bytes publicKey, privateKey, restoredPublicKey, restoredPrivateKey;
+    node.getPersonalKeys(publicKey, privateKey);
+    restored.getPersonalKeys(restoredPublicKey, restoredPrivateKey);
+    TEST_ASSERT_TRUE(publicKey == restoredPublicKey);
+    TEST_ASSERT_TRUE(privateKey == restoredPrivateKey);
+    for (uint8_t channel = 0; channel < RadioManager::MAX_CHANNELS; channel++) {
+        TEST_ASSERT_EQUAL_STRING(node.getPairedAddr(channel).c_str(), restored.getPairedAddr(channel).c_str());
+    }
+}
+
+void test_truncated_file_rejected() {
+    RadioSim sim;
+    RadioManager node(1, 2, "NODE"), peer(3, 4, "PEER"), restored(5, 6, "NODE");
+    TEST_ASSERT_TRUE(node.begin());
+    TEST_ASSERT_TRUE(restored.begin());
+    configure(node, peer);
+
+    // Power lost while saving: only the first half of the JSON reached the file
+    String json = node.exportCfg();
+    FileStream output(path, "wb");
+    TEST_ASSERT_TRUE(output);
+    output.write(json.c_str(), json.length() / 2);
+    output.close();
+
+    String before = restored.exportCfg();
+    FileStream input(path, "rb");
+    TEST_ASSERT_TRUE(input);
+    TEST_ASSERT_FALSE(restored.importCfg(input));
+    TEST_ASSERT_EQUAL_STRING(before.c_str(), restored.exportCfg().c_str());
+}
+
+void test_zero_key_of_older_exports() {
+    RadioSim sim;
+    RadioManager node(1, 2, "NODE"), peer(3, 4, "PEER"), restored(5, 6, "NODE");
+    TEST_ASSERT_TRUE(node.begin());
+    TEST_ASSERT_TRUE(restored.begin());
+    configure(node, peer);
+
+    // Earlier versions exported an all-zero key for the channels paired without key
+    String json = node.exportCfg();
+    json.replace("]},\"personalKeys\"", ",null,\"AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA=\"]},\"personalKeys\"");
+    FileStream output(path, "wb");
+    TEST_ASSERT_TRUE(output);
+    output.print(json);
+    output.close();
+
+    FileStream input(path, "rb");
+    TEST_ASSERT_TRUE(input);
+    TEST_ASSERT_TRUE(restored.importCfg(input));
+    TEST_ASSERT_EQUAL_STRING("3PLN2", restored.getPairedAddr(2).c_str());
+    TEST_ASSERT_EQUAL_STRING(node.exportCfg().c_str(), restored.exportCfg().c_str());
+}
+
+int main() {
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return 1;
+    }
+    close(fd);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_through_file);
+    RUN_TEST(test_truncated_file_rejected);
+    RUN_TEST(test_zero_key_of_older_exports);
+    return UNITY_END();
+}
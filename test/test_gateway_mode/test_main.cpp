@@ -0,0 +1,169 @@
+#include <unity.h>
+#include <RadioManager.h>
+#include <Crc32.h>
+#include <vector>
+
+/*
+ * RADIO_MANAGER_GATEWAY (pio test -e native_gateway): two peers on gateway channels 0 and 5,
+ * which share the gateway's reading pipe 1, send it multi-fragment messages at the same time.
+ * Their fragments ('m'/'c' with the source id) interleave on the pipe and each message must
+ * be reassembled on the channel of its sender. A version-1 binary snapshot, without source
+ * ids, must still import.
+ */
+
+#ifndef RADIO_MANAGER_GATEWAY
+    #error "Build with RADIO_MANAGER_GATEWAY (pio test -e native_gateway)"
+#endif
+
+static const uint8_t CHANNEL_A = 0;         // Gateway channels of the peers, both on pipe 1
+static const uint8_t CHANNEL_B = 5;
+static_assert(CHANNEL_A % 5 == 0 && CHANNEL_B % 5 == 0, "Gateway channel n receives on pipe n % 5 + 1");
+static const uint8_t PEER_CHANNEL = 0;      // Gateway channel at the peers
+static const size_t MESSAGE_SIZE = 200;     // 8 fragments with the nonce
+static const uint8_t ROUNDS = 10;
+
+static void fillMessage(uint8_t* message, uint8_t sender, uint8_t round) {
+    for (size_t i = 0; i < MESSAGE_SIZE; i++) {
+        message[i] = static_cast<uint8_t>(sender * 101 + round * 17 + i * 7 + 1);
+    }
+}
+
+struct Network {
+    RadioSim sim;
+    RadioManager gateway, peerA, peerB;
+
+    Network() : sim(3), gateway(1, 2, "GATE"), peerA(3, 4, "PERA"), peerB(5, 6, "PERB") {
+        sim.setPosition(1, 2, 0);
+        sim.setPosition(2, 0, 2);
+        sim.setLoop(0, [this] { gateway.loop(); });
+        sim.setLoop(1, [this] { peerA.loop(); });
+        sim.setLoop(2, [this] { peerB.loop(); });
+        TEST_ASSERT_TRUE(gateway.begin());
+        TEST_ASSERT_TRUE(peerA.begin());
+        TEST_ASSERT_TRUE(peerB.begin());
+        pair(peerA, "PERA", CHANNEL_A);
+        pair(peerB, "PERB", CHANNEL_B);
+    }
+
+    /**
+     * @brief Pairs a peer on a gateway channel, the peer sending its channel as source id
+     */
+    void pair(RadioManager& peer, const char* peerId, uint8_t channel) {
+        Bytes gatewayKey, peerKey, privateKey;
+        gateway.getPersonalKeys(gatewayKey, privateKey);
+        peer.getPersonalKeys(peerKey, privateKey);
+        String gatewayAddr = String("1GATE:") + String(static_cast<unsigned>(channel), HEX);
+        String peerAddr = String("1") + peerId;
+        TEST_ASSERT_TRUE(peer.setPairedAddr(gatewayAddr, PEER_CHANNEL, gatewayKey));
+        TEST_ASSERT_TRUE(gateway.setPairedAddr(peerAddr, channel, peerKey));
+    }
+
+    /**
+     * @brief Both peers send a message to the gateway at the same time, which must get both intact
+     */
+    void exchange(uint8_t round) {
+        uint8_t messageA[MESSAGE_SIZE], messageB[MESSAGE_SIZE], received[MESSAGE_SIZE];
+        fillMessage(messageA, 'A', round);
+        fillMessage(messageB, 'B', round);
+        uint8_t statusA = 0, statusB = 0;
+        TEST_ASSERT_TRUE(peerA.sendMsg(messageA, sizeof(messageA), PEER_CHANNEL, &statusA, true));
+        TEST_ASSERT_TRUE(peerB.sendMsg(messageB, sizeof(messageB), PEER_CHANNEL, &statusB, true));
+        TEST_ASSERT_TRUE(sim.runUntil([&] { return statusA != 0 && statusB != 0; }, 2000000));
+        TEST_ASSERT_EQUAL(1, statusA);
+        TEST_ASSERT_EQUAL(1, statusB);
+        sim.run(10000);
+
+        for (uint8_t channel = 0; channel < RadioManager::MAX_CHANNELS; channel++) {
+            uint8_t expected = (channel == CHANNEL_A || channel == CHANNEL_B) ? 1 : 0;
+            TEST_ASSERT_EQUAL_MESSAGE(expected, gateway.isMsgAvailable(channel), "Message on the wrong channel");
+        }
+        TEST_ASSERT_EQUAL(MESSAGE_SIZE, gateway.readMsg(CHANNEL_A, received, sizeof(received)));
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(messageA, received, MESSAGE_SIZE, "Message of peer A corrupted");
+        TEST_ASSERT_EQUAL(MESSAGE_SIZE, gateway.readMsg(CHANNEL_B, received, sizeof(received)));
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(messageB, received, MESSAGE_SIZE, "Message of peer B corrupted");
+    }
+
+    /**
+     * @brief The gateway answers each peer, on its own address
+     */
+    void reply(uint8_t round) {
+        uint8_t message[MESSAGE_SIZE], received[MESSAGE_SIZE];
+        for (uint8_t k = 0; k < 2; k++) {
+            RadioManager& peer = k == 0 ? peerA : peerB;
+            fillMessage(message, 'G' + k, round);
+            uint8_t status = 0;
+            TEST_ASSERT_TRUE(gateway.sendMsg(message, sizeof(message), k == 0 ? CHANNEL_A : CHANNEL_B, &status, true));
+            TEST_ASSERT_TRUE(sim.runUntil([&] { return status != 0; }, 1000000));
+            TEST_ASSERT_EQUAL(1, status);
+            TEST_ASSERT_TRUE(sim.runUntil([&] { return peer.isMsgAvailable(PEER_CHANNEL) > 0; }, 100000));
+            TEST_ASSERT_EQUAL(MESSAGE_SIZE, peer.readMsg(PEER_CHANNEL, received, sizeof(received)));
+            TEST_ASSERT_EQUAL_MEMORY(message, received, MESSAGE_SIZE);
+        }
+    }
+};
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_interleaved_messages_on_shared_pipe() {
+    Network network;
+    for (uint8_t round = 0; round < ROUNDS; round++) {
+        network.exchange(round);
+    }
+    network.reply(0);
+    TEST_ASSERT_EQUAL(ROUNDS, network.gateway.getStats(CHANNEL_A).messagesReceived);
+    TEST_ASSERT_EQUAL(ROUNDS, network.gateway.getStats(CHANNEL_B).messagesReceived);
+}
+
+void test_version_1_snapshot_import() {
+    Network network;
+    network.exchange(0);
+    String addrA = network.gateway.getPairedAddr(CHANNEL_A);
+    String addrB = network.gateway.getPairedAddr(CHANNEL_B);
+
+    // Version-1 snapshot of the gateway: same header, records without the trailing source id
+    static uint8_t current[RadioManager::CFG_BIN_SIZE];
+    TEST_ASSERT_EQUAL(RadioManager::CFG_BIN_SIZE, network.gateway.exportCfgBin(current, sizeof(current)));
+    RadioManager::CfgBinHeader header;
+    memcpy(&header, current, sizeof(header));
+    TEST_ASSERT_EQUAL(RadioManager::CFG_BIN_VERSION, header.version);
+    header.version = 1;
+    header.recordSize = RadioManager::CFG_BIN_PEER_V1_SIZE;
+    std::vector<uint8_t> snapshot(reinterpret_cast<uint8_t*>(&header), reinterpret_cast<uint8_t*>(&header) + sizeof(header));
+    for (uint8_t i = 0; i < header.channelCount; i++) {
+        const uint8_t* record = current + sizeof(header) + i * sizeof(RadioManager::CfgBinPeer);
+        TEST_ASSERT_EQUAL(RadioManager::NO_SOURCE_ID, record[RadioManager::CFG_BIN_PEER_V1_SIZE]);
+        snapshot.insert(snapshot.end(), record, record + RadioManager::CFG_BIN_PEER_V1_SIZE);
+    }
+    uint32_t crc = Crc32::compute(snapshot.data(), snapshot.size());
+    snapshot.insert(snapshot.end(), reinterpret_cast<uint8_t*>(&crc), reinterpret_cast<uint8_t*>(&crc) + sizeof(crc));
+
+    // A corrupted copy is refused, the snapshot restores the same pairings, keys and counters
+    std::vector<uint8_t> corrupted = snapshot;
+    corrupted[sizeof(header) + 1] ^= 1;
+    TEST_ASSERT_FALSE(network.gateway.importCfgBin(corrupted.data(), corrupted.size()));
+    network.gateway.clearPairedAddr(CHANNEL_A);
+    network.gateway.clearPairedAddr(CHANNEL_B);
+    TEST_ASSERT_TRUE(network.gateway.importCfgBin(snapshot.data(), snapshot.size()));
+    TEST_ASSERT_EQUAL_STRING(addrA.c_str(), network.gateway.getPairedAddr(CHANNEL_A).c_str());
+    TEST_ASSERT_EQUAL_STRING(addrB.c_str(), network.gateway.getPairedAddr(CHANNEL_B).c_str());
+
+    static uint8_t reexported[RadioManager::CFG_BIN_SIZE];
+    TEST_ASSERT_EQUAL(RadioManager::CFG_BIN_SIZE, network.gateway.exportCfgBin(reexported, sizeof(reexported)));
+    TEST_ASSERT_EQUAL_MEMORY(current + sizeof(header), reexported + sizeof(header),
+                             RadioManager::CFG_BIN_SIZE - sizeof(header) - sizeof(uint32_t));
+
+    // The shared pipe still sorts the messages of the peers out, in both directions
+    network.exchange(1);
+    network.reply(1);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_interleaved_messages_on_shared_pipe);
+    RUN_TEST(test_version_1_snapshot_import);
+    return UNITY_END();
+}
@@ -0,0 +1,58 @@
+#include <unity.h>
+#include <SenderNetwork.h>
+
+/*
+ * Goodput of a shared channel, in the radio simulator: 2 to 5 senders around a collector
+ * (SenderNetwork.h) send it encrypted messages, either all on the same schedule (a report every
+ * REPORT_PERIOD, the case listen before talk targets) or back to back. Results add up SEEDS
+ * runs of DURATION. Run in the native env (no sensing) and in native_lbt (RADIO_MANAGER_LBT)
+ * to compare; RADIO_MANAGER_LBT_SLOT and RADIO_MANAGER_LBT_MAX_EXPONENT can be overridden in
+ * build_flags to tune them.
+ */
+
+static const size_t MESSAGE_SIZE = 96;        // 4 fragments
+static const uint64_t DURATION = 10000000;    // us
+static const uint32_t SEEDS = 4;
+static const uint64_t REPORT_PERIOD = 100000; // us
+static const uint8_t SENDER_COUNTS[] = { 2, 3, 5 };
+
+static NetworkResult measureChannel(uint8_t senders, bool periodic) {
+    NetworkResult result = {};
+    for (uint32_t seed = 1; seed <= SEEDS; seed++) {
+        SenderNetwork network(senders, seed);
+        network.measure(periodic, REPORT_PERIOD, DURATION, MESSAGE_SIZE, result);
+    }
+    result.finish();
+    return result;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_goodput_vs_senders() {
+    char message[80];
+#ifdef RADIO_MANAGER_LBT
+    snprintf(message, sizeof(message), "RADIO_MANAGER_LBT, slot %u us, max exponent %u",
+             RadioManagerConfig::LBT_SLOT, RadioManagerConfig::LBT_MAX_EXPONENT);
+#else
+    snprintf(message, sizeof(message), "Without listen before talk");
+#endif
+    TEST_MESSAGE(message);
+    for (uint8_t senders : SENDER_COUNTS) {
+        NetworkResult result = measureChannel(senders, true);
+        result.report("periodic", senders);
+        TEST_ASSERT_TRUE_MESSAGE(result.received > 0, "No report received");
+    }
+    for (uint8_t senders : SENDER_COUNTS) {
+        measureChannel(senders, false).report("saturated", senders);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_goodput_vs_senders);
+    return UNITY_END();
+}
@@ -0,0 +1,119 @@
+#include <unity.h>
+#include <RadioManager.h>
+
+/*
+ * Throughput of a link against distance and extra loss rate, in the radio simulator: node A
+ * sends encrypted messages to B back to back for DURATION and the goodput counts the message
+ * bytes B receives intact. Run in the native env (every link at 250 kbps) and in native_rate
+ * (RADIO_MANAGER_ADAPTIVE_RATE) to compare; the rate reached is printed for the latter.
+ */
+
+static const uint8_t CHANNEL = 0;
+static const size_t MESSAGE_SIZE = 256;
+static const uint64_t DURATION = 5000000; // us
+
+static const double DISTANCES[] = { 1, 5, 10, 20, 30, 40, 60 };     // m
+static const double LOSS_RATES[] = { 0, 0.05, 0.15, 0.3 };
+
+struct LinkResult {
+    double goodput;      // kbit/s of message bytes received
+    uint32_t messages;   // Messages received intact
+    uint32_t corrupted;  // Messages received with a wrong length or content
+    uint32_t failures;   // Messages aborted by A
+    double retries;      // Retransmissions per fragment
+    rf24_datarate_e rate;
+};
+
+static const char* rateName(rf24_datarate_e rate) {
+    switch (rate) {
+        case RF24_1MBPS: return "1M";
+        case RF24_2MBPS: return "2M";
+        default: return "250k";
+    }
+}
+
+/**
+ * @brief Pairs two nodes directly, with the keys of each other, on CHANNEL
+ */
+static void pair(RadioManager& nodeA, const char* idA, RadioManager& nodeB, const char* idB) {
+    Bytes publicA, publicB, privateKey;
+    nodeA.getPersonalKeys(publicA, privateKey);
+    nodeB.getPersonalKeys(publicB, privateKey);
+    String addrA = String("1") + idA, addrB = String("1") + idB;
+    TEST_ASSERT_TRUE(nodeA.setPairedAddr(addrB, CHANNEL, publicB));
+    TEST_ASSERT_TRUE(nodeB.setPairedAddr(addrA, CHANNEL, publicA));
+}
+
+static LinkResult measureLink(double distance, double loss) {
+    RadioSim sim;
+    RadioManager nodeA(1, 2, "NODA"), nodeB(3, 4, "NODB");
+    sim.setPosition(1, distance);
+    sim.setLoss(loss);
+    sim.setLoop(0, [&] { nodeA.loop(); });
+    sim.setLoop(1, [&] { nodeB.loop(); });
+    TEST_ASSERT_TRUE(nodeA.begin());
+    TEST_ASSERT_TRUE(nodeB.begin());
+    pair(nodeA, "NODA", nodeB, "NODB");
+
+    uint8_t message[MESSAGE_SIZE], received[MESSAGE_SIZE];
+    for (size_t i = 0; i < sizeof(message); i++) message[i] = static_cast<uint8_t>(i * 13);
+    LinkResult result = { 0, 0, 0, 0, 0, RF24_250KBPS };
+    uint8_t status = 1;
+    uint64_t bytes = 0;
+    uint64_t end = sim.now() + DURATION;
+    while (sim.now() < end) {
+        if (status != 0) {
+            if (status != 1) result.failures++;
+            status = 0;
+            nodeA.sendMsg(message, sizeof(message), CHANNEL, &status, true);
+        }
+        sim.run(1000);
+        while (nodeB.isMsgAvailable(CHANNEL)) {
+            size_t length = nodeB.readMsg(CHANNEL, received, sizeof(received));
+            if (length == sizeof(message) && memcmp(received, message, length) == 0) {
+                bytes += length;
+                result.messages++;
+            } else {
+                result.corrupted++;
+            }
+        }
+    }
+    const RadioStats& stats = nodeA.getStats(CHANNEL);
+    result.goodput = bytes * 8.0 / (DURATION / 1000.0);
+    result.retries = stats.fragmentsSent ? static_cast<double>(stats.retries) / stats.fragmentsSent : 0;
+    result.rate = nodeA.getDataRate(CHANNEL);
+    return result;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_throughput_vs_distance_and_loss() {
+#ifdef RADIO_MANAGER_ADAPTIVE_RATE
+    TEST_MESSAGE("RADIO_MANAGER_ADAPTIVE_RATE");
+#else
+    TEST_MESSAGE("Fixed rate (250 kbps)");
+#endif
+    char message[140];
+    for (double loss : LOSS_RATES) {
+        for (double distance : DISTANCES) {
+            LinkResult result = measureLink(distance, loss);
+            snprintf(message, sizeof(message), "loss %4.2f, %3.0f m: %6.1f kbit/s, %4u msgs, %2u corrupted, %3u failed, %5.2f retries/fragment, rate %s",
+                     loss, distance, result.goodput, static_cast<unsigned>(result.messages),
+                     static_cast<unsigned>(result.corrupted), static_cast<unsigned>(result.failures), result.retries, rateName(result.rate));
+            TEST_MESSAGE(message);
+            if (loss == 0 && distance <= 10) {
+                TEST_ASSERT_TRUE_MESSAGE(result.messages > 0, "No message received on a short link");
+            }
+        }
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_throughput_vs_distance_and_loss);
+    return UNITY_END();
+}
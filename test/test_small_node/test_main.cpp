@@ -0,0 +1,81 @@
+#include <unity.h>
+#include <RadioManager.h>
+
+/*
+ * RADIO_MANAGER_SMALL_NODE (pio test -e native_small): the object fits the 2 KB budget of the
+ * preset once the simulated radio is set aside, and two small nodes exchange messages of the
+ * largest size the preset allows.
+ */
+
+#ifndef RADIO_MANAGER_SMALL_NODE
+    #error "Build with RADIO_MANAGER_SMALL_NODE (pio test -e native_small)"
+#endif
+
+static const uint8_t CHANNEL = 0;  // The only channel of a small node
+static const size_t SMALL_NODE_BUDGET = 2048;
+static const size_t TARGET_RF24_SIZE = 64; // RF24 driver object on the ESP32 (about 40 bytes)
+
+/**
+ * @brief Pairs two nodes directly, with the keys of each other, on CHANNEL
+ */
+static void pair(RadioManager& nodeA, const char* idA, RadioManager& nodeB, const char* idB) {
+    Bytes publicA, publicB, privateKey;
+    nodeA.getPersonalKeys(publicA, privateKey);
+    nodeB.getPersonalKeys(publicB, privateKey);
+    String addrA = String("1") + idA, addrB = String("1") + idB;
+    TEST_ASSERT_TRUE(nodeA.setPairedAddr(addrB, CHANNEL, publicB));
+    TEST_ASSERT_TRUE(nodeB.setPairedAddr(addrA, CHANNEL, publicA));
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_object_budget() {
+    // The simulated RF24 holds the medium state of a whole radio, the driver on the target doesn't
+    size_t footprint = sizeof(RadioManager) - sizeof(RF24) + TARGET_RF24_SIZE;
+    char message[120];
+    snprintf(message, sizeof(message), "sizeof(RadioManager) %u, %u with the target RF24 (budget %u)",
+             static_cast<unsigned>(sizeof(RadioManager)), static_cast<unsigned>(footprint),
+             static_cast<unsigned>(SMALL_NODE_BUDGET));
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL(1, RadioManager::MAX_CHANNELS);
+    TEST_ASSERT_TRUE_MESSAGE(footprint <= SMALL_NODE_BUDGET, "RadioManager exceeds the 2 KB of RADIO_MANAGER_SMALL_NODE");
+}
+
+void test_largest_message() {
+    RadioSim sim;
+    RadioManager nodeA(1, 2, "NODA"), nodeB(3, 4, "NODB");
+    sim.setPosition(1, 1);
+    sim.setLoop(0, [&] { nodeA.loop(); });
+    sim.setLoop(1, [&] { nodeB.loop(); });
+    TEST_ASSERT_TRUE(nodeA.begin());
+    TEST_ASSERT_TRUE(nodeB.begin());
+    pair(nodeA, "NODA", nodeB, "NODB");
+
+    uint8_t message[RadioManagerConfig::MAX_MSG_SIZE + 1], received[RadioManagerConfig::MAX_MSG_SIZE];
+    for (size_t i = 0; i < sizeof(message); i++) message[i] = static_cast<uint8_t>(i * 7 + 1);
+    TEST_ASSERT_FALSE_MESSAGE(nodeA.sendMsg(message, sizeof(message), CHANNEL, nullptr, true), "Message above RADIO_MANAGER_MAX_MSG_SIZE sent");
+
+    // Encrypted, the nonce takes the largest message to the last fragment received
+    for (uint8_t round = 0; round < 3; round++) {
+        message[0] = round + 1;
+        uint8_t status = 0;
+        TEST_ASSERT_TRUE(nodeA.sendMsg(message, RadioManagerConfig::MAX_MSG_SIZE, CHANNEL, &status, true));
+        TEST_ASSERT_TRUE(sim.runUntil([&] { return status != 0; }, 1000000));
+        TEST_ASSERT_EQUAL(1, status);
+        TEST_ASSERT_TRUE(sim.runUntil([&] { return nodeB.isMsgAvailable(CHANNEL) > 0; }, 100000));
+        size_t length = nodeB.readMsg(CHANNEL, received, sizeof(received));
+        TEST_ASSERT_EQUAL(RadioManagerConfig::MAX_MSG_SIZE, length);
+        TEST_ASSERT_EQUAL_MEMORY(message, received, length);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_object_budget);
+    RUN_TEST(test_largest_message);
+    return UNITY_END();
+}
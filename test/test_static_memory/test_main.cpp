@@ -0,0 +1,166 @@
+#include <unity.h>
+#include <RadioManager.h>
+#include <new>
+
+/*
+ * RADIO_MANAGER_STATIC_MEMORY (pio test -e native_static): once begin() returned, pairing,
+ * sending and receiving must not touch the heap. Two nodes pair and exchange messages over
+ * the simulated medium with the heap locked: the allocator given to RadioManager
+ * refuses buffers and malloc() (String, std::vector, mbedtls...) counts its calls.
+ */
+
+#ifndef RADIO_MANAGER_STATIC_MEMORY
+    #error "Build with RADIO_MANAGER_STATIC_MEMORY (pio test -e native_static)"
+#endif
+
+static bool heapLocked = false;
+static uint32_t heapAllocations = 0; // Heap allocations while locked
+
+#if defined(__GLIBC__)
+// Interposed for the whole process, mbedtls and the C++ runtime included
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* buffer, size_t size);
+
+void* malloc(size_t size) {
+    if (heapLocked) heapAllocations++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    if (heapLocked) heapAllocations++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* buffer, size_t size) {
+    if (heapLocked) heapAllocations++;
+    return __libc_realloc(buffer, size);
+}
+}
+#else
+// Only the C++ allocations are seen
+void* operator new(size_t size) {
+    if (heapLocked) heapAllocations++;
+    void* buffer = malloc(size ? size : 1);
+    if (buffer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return buffer;
+}
+
+void operator delete(void* buffer) noexcept {
+    free(buffer);
+}
+#endif
+
+// Heap allocator failing once locked
+class FailingAllocator : public RadioAllocator {
+public:
+    FailingAllocator() : failures(0) {}
+
+    void* allocate(size_t size, uint8_t tier) override {
+        if (heapLocked) {
+            failures++;
+            return nullptr;
+        }
+        return fallback.allocate(size, tier);
+    }
+
+    void release(void* buffer, uint8_t tier) override {
+        fallback.release(buffer, tier);
+    }
+
+    uint32_t failures;
+
+private:
+    RadioHeapAllocator fallback;
+};
+
+static const uint8_t CHANNEL = 0; // First free channel, taken by the pairing on both nodes
+
+// Runs the simulation until the node receives a message, reads it without allocating
+static size_t receive(RadioSim& sim, RadioManager& node, uint8_t* buffer, size_t size) {
+    for (uint32_t ms = 0; ms < 2000; ms += 10) {
+        if (node.isMsgAvailable(CHANNEL)) {
+            return node.readMsg(CHANNEL, buffer, size);
+        }
+        sim.run(10000);
+    }
+    return 0;
+}
+
+static bool isIdle(RadioManager& node) {
+    return node.getCurrentState() == RadioManager::IDLE;
+}
+
+void setUp() {
+    heapLocked = false;
+    heapAllocations = 0;
+}
+
+void tearDown() {
+    heapLocked = false;
+}
+
+void test_pairing_send_receive_without_heap() {
+    RadioSim sim;
+    FailingAllocator allocatorA, allocatorB;
+    RadioManager nodeA(1, 2, "NODA", &allocatorA);
+    RadioManager nodeB(3, 4, "NODB", &allocatorB);
+    sim.setPosition(1, 3.0);
+    sim.setLoop(0, [&] { nodeA.loop(); });
+    sim.setLoop(1, [&] { nodeB.loop(); });
+    TEST_ASSERT_TRUE(nodeA.begin());
+    TEST_ASSERT_TRUE(nodeB.begin());
+
+    uint8_t request[200]; // Several fragments
+    uint8_t reply[20];
+    for (size_t i = 0; i < sizeof(request); i++) request[i] = static_cast<uint8_t>(i * 7);
+    for (size_t i = 0; i < sizeof(reply); i++) reply[i] = static_cast<uint8_t>(0xA0 + i);
+    uint8_t received[RadioManager::Config::MAX_MSG_SIZE];
+    uint8_t statusA = 0, statusB = 0;
+
+    heapLocked = true;
+
+    // Pairing: A listens first and transmits after PAIRING_LISTEN_TIME, B listens meanwhile
+    bool startedA = nodeA.startPairing();
+    sim.run(1000000);
+    bool startedB = nodeB.startPairing();
+    uint32_t ms = 0;
+    for (; ms < 20000 && !(isIdle(nodeA) && isIdle(nodeB)); ms += 10) {
+        sim.run(10000);
+    }
+    bool paired = isIdle(nodeA) && isIdle(nodeB);
+
+    // Encrypted request from A, several fragments, and encrypted reply from B
+    bool sentRequest = nodeA.sendMsg(request, sizeof(request), CHANNEL, &statusA, true);
+    size_t requestLength = receive(sim, nodeB, received, sizeof(received));
+    bool requestMatches = requestLength == sizeof(request) && memcmp(received, request, sizeof(request)) == 0;
+    bool sentReply = nodeB.sendMsg(reply, sizeof(reply), CHANNEL, &statusB, true);
+    size_t replyLength = receive(sim, nodeA, received, sizeof(received));
+    bool replyMatches = replyLength == sizeof(reply) && memcmp(received, reply, sizeof(reply)) == 0;
+
+    heapLocked = false;
+
+    TEST_ASSERT_TRUE(startedA);
+    TEST_ASSERT_TRUE(startedB);
+    TEST_ASSERT_TRUE_MESSAGE(paired, "Pairing did not complete");
+    TEST_ASSERT_EQUAL_STRING("1NODB", nodeA.getPairedAddr(CHANNEL).c_str());
+    TEST_ASSERT_EQUAL_STRING("1NODA", nodeB.getPairedAddr(CHANNEL).c_str());
+    TEST_ASSERT_TRUE(sentRequest);
+    TEST_ASSERT_TRUE_MESSAGE(requestMatches, "Request not received");
+    TEST_ASSERT_EQUAL_UINT8(1, statusA);
+    TEST_ASSERT_TRUE(sentReply);
+    TEST_ASSERT_TRUE_MESSAGE(replyMatches, "Reply not received");
+    TEST_ASSERT_EQUAL_UINT8(1, statusB);
+
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, allocatorA.failures + allocatorB.failures, "Buffer allocated after begin()");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, heapAllocations, "Heap used after begin()");
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_pairing_send_receive_without_heap);
+    return UNITY_END();
+}
@@ -0,0 +1,286 @@
+#include <unity.h>
+#include <RadioStore.h>
+#include <RadioFileStorage.h>
+#include <stdlib.h>
+#include <map>
+#include <vector>
+#include <functional>
+
+/*
+ * Power-cut harness of RadioStore: each operation (put, compact, superblock write) is run
+ * once to count the bytes it writes, then again from the same initial files with the power
+ * cut after every possible number of bytes. The interrupted write is torn at that offset and
+ * nothing reaches the files afterwards. After each cut the store is opened again and must
+ * hold either the state before the operation or the state after it, and keep working.
+ */
+
+typedef std::map<std::pair<uint8_t, uint8_t>, std::vector<uint8_t>> StoreState;
+typedef std::function<void(RadioStore&)> StoreOperation;
+
+// Same layout as the configuration of RadioManager: one record of type 1, peers of type 2
+static const uint8_t TYPES = 2;
+
+static char directory[] = "/tmp/radio_store_XXXXXX";
+static char prefix[64];
+
+/**
+ * @brief RadioFileStorage losing power after a given number of written bytes
+ *
+ * A whole-file write truncates the file first, as SPIFFS/LittleFS do, so a write torn at
+ * offset n leaves its first n bytes. Erasing counts as writing nothing: it only happens
+ * while bytes remain.
+ */
+class PowerCutStorage : public RadioFileStorage {
+public:
+    static const uint32_t NO_CUT = UINT32_MAX;
+
+    PowerCutStorage(const char* prefix, uint32_t budget = NO_CUT)
+        : RadioFileStorage(prefix), written(0), lastSuperblockStart(0), lastSuperblockEnd(0), remaining(budget) {}
+
+    size_t append(uint8_t file, const uint8_t* data, size_t length) override {
+        size_t allowed = allow(length);
+        return allowed > 0 ? RadioFileStorage::append(file, data, allowed) : 0;
+    }
+
+    bool write(uint8_t file, const uint8_t* data, size_t length) override {
+        if (remaining == 0) {
+            return false;
+        }
+        if (file == SUPERBLOCK_0 || file == SUPERBLOCK_1) {
+            lastSuperblockStart = written;
+            lastSuperblockEnd = written + length;
+        }
+        size_t allowed = allow(length);
+        bool complete = RadioFileStorage::write(file, data, allowed);
+        return complete && allowed == length;
+    }
+
+    bool erase(uint8_t file) override {
+        return remaining > 0 && RadioFileStorage::erase(file);
+    }
+
+    uint32_t written;             // Bytes written so far
+    uint32_t lastSuperblockStart; // Value of written when the last superblock write started
+    uint32_t lastSuperblockEnd;
+
+private:
+    uint32_t remaining;
+
+    size_t allow(size_t length) {
+        size_t allowed = std::min<size_t>(length, remaining);
+        if (remaining != NO_CUT) {
+            remaining -= allowed;
+        }
+        written += allowed;
+        return allowed;
+    }
+};
+
+static std::vector<uint8_t> valueOf(uint8_t type, uint8_t key, uint8_t version) {
+    // Lengths vary with the key and version so that records move around in the logs
+    std::vector<uint8_t> value(8 + (key * 13 + version * 7) % 60);
+    for (size_t i = 0; i < value.size(); i++) {
+        value[i] = static_cast<uint8_t>(type * 31 + key * 7 + version * 3 + i);
+    }
+    return value;
+}
+
+static void putValue(RadioStore& store, uint8_t type, uint8_t key, uint8_t version) {
+    std::vector<uint8_t> value = valueOf(type, key, version);
+    store.put(type, key, value.data(), value.size());
+}
+
+static StoreState readState(RadioStore& store) {
+    StoreState state;
+    uint8_t value[RadioStore::MAX_VALUE_SIZE];
+    for (uint8_t type = 1; type <= TYPES; type++) {
+        for (uint8_t key = 0; key < RadioStore::MAX_ENTRIES; key++) {
+            int length = store.get(type, key, value, sizeof(value));
+            if (length >= 0) {
+                state[std::make_pair(type, key)] = std::vector<uint8_t>(value, value + length);
+            }
+        }
+    }
+    return state;
+}
+
+static void eraseFiles() {
+    RadioFileStorage storage(prefix);
+    for (uint8_t file = 0; file < RadioStorage::FILE_COUNT; file++) {
+        storage.erase(file);
+    }
+}
+
+/**
+ * @brief Cuts the power at every byte of an operation and checks the recovered state
+ *
+ * @param compactThreshold Compaction threshold of the store
+ * @param setup Builds the initial state, without power cut
+ * @param operation Operation interrupted
+ * @param superblockOnly Only cut inside the last superblock write of the operation
+ */
+static void checkPowerCuts(uint32_t compactThreshold, StoreOperation setup, StoreOperation operation, bool superblockOnly = false) {
+    // Reference run: states before and after, bytes written by the operation
+    eraseFiles();
+    PowerCutStorage reference(prefix);
+    RadioStore referenceStore(reference, compactThreshold);
+    TEST_ASSERT_TRUE(referenceStore.begin());
+    setup(referenceStore);
+    StoreState before = readState(referenceStore);
+    reference.written = 0;
+    operation(referenceStore);
+    StoreState after = readState(referenceStore);
+    uint32_t total = reference.written;
+    TEST_ASSERT_TRUE_MESSAGE(before != after, "The operation must change the state");
+
+    uint32_t first = superblockOnly ? reference.lastSuperblockStart : 0;
+    uint32_t last = superblockOnly ? reference.lastSuperblockEnd : total;
+    TEST_ASSERT_TRUE(last > first);
+
+    for (uint32_t cut = first; cut <= last; cut++) {
+        eraseFiles();
+        {
+            PowerCutStorage storage(prefix);
+            RadioStore store(storage, compactThreshold);
+            TEST_ASSERT_TRUE(store.begin());
+            setup(store);
+        }
+        {
+            PowerCutStorage storage(prefix, cut);
+            RadioStore store(storage, compactThreshold);
+            store.begin(); // Reads only, the files are valid
+            operation(store);
+        }
+
+        // Reboot
+        PowerCutStorage storage(prefix);
+        RadioStore store(storage, compactThreshold);
+        char message[80];
+        snprintf(message, sizeof(message), "begin() after a power cut at byte %u of %u", cut, total);
+        TEST_ASSERT_TRUE_MESSAGE(store.begin(), message);
+        StoreState recovered = readState(store);
+        snprintf(message, sizeof(message), "Mixed state after a power cut at byte %u of %u", cut, total);
+        TEST_ASSERT_TRUE_MESSAGE(recovered == before || recovered == after, message);
+        if (cut == total) {
+            TEST_ASSERT_TRUE_MESSAGE(recovered == after, "Operation not applied without power cut");
+        }
+
+        // The recovered store keeps working across reboots
+        putValue(store, 1, 0, 200);
+        recovered[StoreState::key_type(1, 0)] = valueOf(1, 0, 200);
+        RadioStore reopened(storage, compactThreshold);
+        TEST_ASSERT_TRUE(reopened.begin());
+        snprintf(message, sizeof(message), "Write lost after recovering from a cut at byte %u", cut);
+        TEST_ASSERT_TRUE_MESSAGE(readState(reopened) == recovered, message);
+    }
+}
+
+// A few records, several versions of some and a removed one, without compaction
+static void fillStore(RadioStore& store) {
+    putValue(store, 1, 0, 0);
+    for (uint8_t key = 0; key < 3; key++) {
+        putValue(store, 2, key, 0);
+    }
+    putValue(store, 1, 0, 1);
+    putValue(store, 2, 0, 1);
+    store.remove(2, 1);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_put_new_record() {
+    checkPowerCuts(UINT32_MAX, fillStore, [](RadioStore& store) { putValue(store, 2, 3, 5); });
+}
+
+void test_put_replaced_record() {
+    checkPowerCuts(UINT32_MAX, fillStore, [](RadioStore& store) { putValue(store, 2, 2, 5); });
+}
+
+void test_remove_record() {
+    checkPowerCuts(UINT32_MAX, fillStore, [](RadioStore& store) { store.remove(2, 0); });
+}
+
+void test_put_with_compaction() {
+    // The log of fillStore() is just below the threshold, the put appends then compacts
+    eraseFiles();
+    PowerCutStorage storage(prefix);
+    RadioStore store(storage, UINT32_MAX);
+    TEST_ASSERT_TRUE(store.begin());
+    fillStore(store);
+    uint32_t threshold = store.getLogSize() + 1;
+    RadioStore compacting(storage, threshold);
+    TEST_ASSERT_TRUE(compacting.begin());
+    uint32_t sequence = compacting.getSequence();
+    putValue(compacting, 2, 3, 9);
+    TEST_ASSERT_EQUAL_UINT32(sequence + 1, compacting.getSequence());
+
+    checkPowerCuts(threshold, fillStore, [](RadioStore& store) { putValue(store, 2, 3, 9); });
+}
+
+void test_compact() {
+    // Compacting doesn't change the values, a record put afterwards tells the two states apart
+    checkPowerCuts(UINT32_MAX, fillStore, [](RadioStore& store) {
+        if (store.compact()) {
+            putValue(store, 2, 4, 3);
+        }
+    });
+}
+
+void test_superblock_write() {
+    // After two compactions both slots hold a valid superblock, the third one overwrites the oldest
+    StoreOperation setup = [](RadioStore& store) {
+        fillStore(store);
+        store.compact();
+        putValue(store, 2, 3, 1);
+        store.compact();
+    };
+    checkPowerCuts(UINT32_MAX, setup, [](RadioStore& store) {
+        putValue(store, 2, 3, 2); // Only reachable through the new superblock once compacted
+        store.compact();
+    }, true);
+}
+
+void test_format() {
+    // A new store writes its first superblock, a cut leaves an empty store in any case
+    for (uint32_t cut = 0; cut <= 32; cut++) {
+        eraseFiles();
+        {
+            PowerCutStorage storage(prefix, cut);
+            RadioStore store(storage);
+            store.begin();
+        }
+        PowerCutStorage storage(prefix);
+        RadioStore store(storage);
+        TEST_ASSERT_TRUE(store.begin());
+        TEST_ASSERT_TRUE(store.isEmpty());
+        putValue(store, 2, 3, 0);
+        RadioStore reopened(storage);
+        TEST_ASSERT_TRUE(reopened.begin());
+        TEST_ASSERT_EQUAL(1, readState(reopened).size());
+    }
+}
+
+int main() {
+    if (mkdtemp(directory) == nullptr) {
+        return 1;
+    }
+    snprintf(prefix, sizeof(prefix), "%s/radio", directory);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_put_new_record);
+    RUN_TEST(test_put_replaced_record);
+    RUN_TEST(test_remove_record);
+    RUN_TEST(test_put_with_compaction);
+    RUN_TEST(test_compact);
+    RUN_TEST(test_superblock_write);
+    RUN_TEST(test_format);
+    int failures = UNITY_END();
+
+    eraseFiles();
+    rmdir(directory);
+    return failures;
+}
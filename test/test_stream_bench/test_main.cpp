@@ -0,0 +1,260 @@
+#include <unity.h>
+#include <RadioManager.h>
+#include <vector>
+
+/*
+ * Goodput and residual loss of a link against the extra loss rate, in the radio simulator:
+ * node A sends B records of STREAM_PAYLOAD_SIZE bytes back to back for DURATION, as encrypted
+ * acknowledged messages and, in native_stream (RADIO_MANAGER_STREAM), with sendStream().
+ * The goodput counts the record bytes B gets intact, rebuilt stream records included.
+ */
+
+static const uint8_t CHANNEL = 0;
+static const size_t RECORD_SIZE = RadioManager::STREAM_PAYLOAD_SIZE;
+static const uint64_t DURATION = 5000000; // us
+static const double DISTANCE = 1;         // m
+
+static const double LOSS_RATES[] = { 0, 0.01, 0.05, 0.1, 0.2, 0.3 };
+
+struct StreamResult {
+    double goodput;      // kbit/s of record bytes received intact
+    uint32_t sent;       // Records sent
+    uint32_t received;   // Records received intact, once each
+    uint32_t recovered;  // Stream records rebuilt from the parity of their block
+    uint32_t corrupted;  // Records received with a wrong length or content
+    uint32_t failed;     // Messages aborted by A
+};
+
+// Records received by B, by sequence number
+static std::vector<bool> delivered;
+static uint32_t deliveredCount;
+static uint32_t corruptedCount;
+
+static void fillRecord(uint8_t* record, uint32_t sequence) {
+    memcpy(record, &sequence, sizeof(sequence));
+    for (size_t i = sizeof(sequence); i < RECORD_SIZE; i++) {
+        record[i] = static_cast<uint8_t>(sequence * 7 + i * 13 + 1);
+    }
+}
+
+static void deliver(const uint8_t* data, size_t length) {
+    uint8_t expected[RECORD_SIZE];
+    uint32_t sequence;
+    if (length != RECORD_SIZE) {
+        corruptedCount++;
+        return;
+    }
+    memcpy(&sequence, data, sizeof(sequence));
+    fillRecord(expected, sequence);
+    if (sequence >= delivered.size() || memcmp(data, expected, RECORD_SIZE) != 0) {
+        corruptedCount++;
+    } else if (!delivered[sequence]) {
+        delivered[sequence] = true;
+        deliveredCount++;
+    }
+}
+
+static void onRecord(uint8_t channel, const uint8_t* data, uint8_t length) {
+    (void)channel;
+    deliver(data, length);
+}
+
+/**
+ * @brief Pairs two nodes directly, with the keys of each other, on CHANNEL
+ */
+static void pair(RadioManager& nodeA, const char* idA, RadioManager& nodeB, const char* idB) {
+    Bytes publicA, publicB, privateKey;
+    nodeA.getPersonalKeys(publicA, privateKey);
+    nodeB.getPersonalKeys(publicB, privateKey);
+    String addrA = String("1") + idA, addrB = String("1") + idB;
+    TEST_ASSERT_TRUE(nodeA.setPairedAddr(addrB, CHANNEL, publicB));
+    TEST_ASSERT_TRUE(nodeB.setPairedAddr(addrA, CHANNEL, publicA));
+}
+
+/**
+ * @brief Sends records from A to B for DURATION, as a stream or as acknowledged messages
+ */
+static StreamResult measureLink(double loss, bool stream) {
+    RadioSim sim;
+    RadioManager nodeA(1, 2, "NODA"), nodeB(3, 4, "NODB");
+    sim.setPosition(1, DISTANCE);
+    sim.setLoss(loss);
+    TEST_ASSERT_TRUE(nodeA.begin());
+    TEST_ASSERT_TRUE(nodeB.begin());
+    pair(nodeA, "NODA", nodeB, "NODB");
+    nodeB.onStream(onRecord);
+    delivered.assign(1000000, false);
+    deliveredCount = 0;
+    corruptedCount = 0;
+
+    StreamResult result = { 0, 0, 0, 0, 0, 0 };
+    uint8_t record[RECORD_SIZE], received[RECORD_SIZE];
+    uint8_t status = 1;
+    uint64_t end = sim.now() + DURATION;
+    // Stream records are written from the loop of A, at once
+    sim.setLoop(0, [&] {
+        nodeA.loop();
+        if (!stream || micros() >= end || result.sent >= delivered.size()) {
+            return;
+        }
+        fillRecord(record, result.sent);
+        if (nodeA.sendStream(CHANNEL, record, RECORD_SIZE)) {
+            result.sent++;
+        }
+    });
+    sim.setLoop(1, [&] { nodeB.loop(); });
+    while (sim.now() < end) {
+        if (!stream && status != 0 && result.sent < delivered.size()) {
+            if (status != 1) result.failed++;
+            fillRecord(record, result.sent++);
+            status = 0;
+            nodeA.sendMsg(record, RECORD_SIZE, CHANNEL, &status, true);
+        }
+        sim.run(1000);
+        while (nodeB.isMsgAvailable(CHANNEL)) {
+            size_t length = nodeB.readMsg(CHANNEL, received, sizeof(received));
+            deliver(received, length);
+        }
+    }
+    if (stream) {
+        // The parity of the last block, then the records still in flight
+        sim.setLoop(0, [&] { nodeA.loop(); });
+        sim.runUntil([&] { return nodeA.flushStream(CHANNEL) || nodeA.getStats(CHANNEL).streamSent % RadioManagerConfig::STREAM_BLOCK == 0; }, 100000);
+    }
+    sim.run(50000);
+    while (nodeB.isMsgAvailable(CHANNEL)) {
+        size_t length = nodeB.readMsg(CHANNEL, received, sizeof(received));
+        deliver(received, length);
+    }
+    result.received = deliveredCount;
+    result.corrupted = corruptedCount;
+    result.recovered = nodeB.getStats(CHANNEL).streamRecovered;
+    result.goodput = deliveredCount * RECORD_SIZE * 8.0 / (DURATION / 1000.0);
+    return result;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_acknowledged_vs_loss() {
+    char message[140];
+    for (double loss : LOSS_RATES) {
+        StreamResult result = measureLink(loss, false);
+        // A message whose ciphertext ends with zeros loses them to the zero padding of static payloads
+        snprintf(message, sizeof(message), "messages, loss %4.2f: %6.1f kbit/s, %5u/%5u records, %2u corrupted, %3u failed",
+                 loss, result.goodput, static_cast<unsigned>(result.received), static_cast<unsigned>(result.sent),
+                 static_cast<unsigned>(result.corrupted), static_cast<unsigned>(result.failed));
+        TEST_MESSAGE(message);
+        TEST_ASSERT_TRUE_MESSAGE(result.received > 0, "No record received");
+    }
+}
+
+void test_stream_vs_loss() {
+#ifdef RADIO_MANAGER_STREAM
+    char message[160];
+    snprintf(message, sizeof(message), "RADIO_MANAGER_STREAM, %u records per parity frame", RadioManagerConfig::STREAM_BLOCK);
+    TEST_MESSAGE(message);
+    for (double loss : LOSS_RATES) {
+        StreamResult result = measureLink(loss, true);
+        uint32_t lost = result.sent - result.received;
+        // A record is lost when another frame of its block (records and parity) is lost too
+        double expected = loss * (1 - pow(1 - loss, RadioManagerConfig::STREAM_BLOCK));
+        snprintf(message, sizeof(message), "stream, loss %4.2f: %6.1f kbit/s, %5u/%5u records, %4u rebuilt, %5.2f %% lost (%5.2f %% expected)",
+                 loss, result.goodput, static_cast<unsigned>(result.received), static_cast<unsigned>(result.sent),
+                 static_cast<unsigned>(result.recovered), result.sent ? 100.0 * lost / result.sent : 0.0, 100 * expected);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_TRUE_MESSAGE(result.received > 0, "No record received");
+        TEST_ASSERT_EQUAL_MESSAGE(0, result.corrupted, "Stream record received corrupted");
+        if (loss == 0) {
+            TEST_ASSERT_EQUAL_MESSAGE(0, lost, "Record lost without extra loss");
+        }
+    }
+#else
+    TEST_IGNORE_MESSAGE("RADIO_MANAGER_STREAM not defined (pio test -e native_stream)");
+#endif
+}
+
+#ifdef RADIO_MANAGER_STREAM
+// Records handed to the callback of B, in order
+static std::vector<std::vector<uint8_t>> records;
+
+static void onParityRecord(uint8_t channel, const uint8_t* data, uint8_t length) {
+    (void)channel;
+    records.push_back(std::vector<uint8_t>(data, data + length));
+}
+#endif
+
+void test_parity_rebuilds_lost_record() {
+#ifdef RADIO_MANAGER_STREAM
+    // Two blocks, record 1 of the first one shorter than the others and dropped on its way
+    static const uint8_t BLOCKS = 2;
+    static const uint8_t LOST = 1;
+    static const uint8_t LOST_LENGTH = 10;
+    const uint8_t count = BLOCKS * RadioManagerConfig::STREAM_BLOCK;
+    RadioSim sim;
+    RadioManager nodeA(1, 2, "NODA"), nodeB(3, 4, "NODB");
+    sim.setPosition(1, DISTANCE);
+    TEST_ASSERT_TRUE(nodeA.begin());
+    TEST_ASSERT_TRUE(nodeB.begin());
+    pair(nodeA, "NODA", nodeB, "NODB");
+    records.clear();
+    nodeB.onStream(onParityRecord);
+
+    uint8_t sent[count][RECORD_SIZE];
+    for (uint8_t k = 0; k < count; k++) {
+        fillRecord(sent[k], k);
+    }
+    uint32_t dropped = 0;
+    sim.setDropFilter([&](size_t sender, const uint8_t* payload, uint8_t length) {
+        // Stream frame: 'D', then the block counter and the position in the 16-bit index
+        uint16_t index = payload[1] | (payload[2] << 8);
+        bool lost = sender == 0 && length >= 3 && payload[0] == 'D' && index == LOST;
+        dropped += lost ? 1 : 0;
+        return lost;
+    });
+    uint8_t next = 0;
+    sim.setLoop(0, [&] {
+        nodeA.loop();
+        if (next < count && nodeA.sendStream(CHANNEL, sent[next], next == LOST ? LOST_LENGTH : RECORD_SIZE)) {
+            next++;
+        }
+    });
+    sim.setLoop(1, [&] { nodeB.loop(); });
+    sim.run(100000);
+
+    TEST_ASSERT_EQUAL(count, next);
+    TEST_ASSERT_EQUAL(1, dropped);
+    const RadioStats& stats = nodeB.getStats(CHANNEL);
+    TEST_ASSERT_EQUAL(1, stats.streamRecovered);
+    TEST_ASSERT_EQUAL(count - 1, stats.streamReceived);
+    TEST_ASSERT_EQUAL(0, stats.streamLost);
+    // The rebuilt record comes with the parity, after the other records of its block
+    std::vector<uint8_t> order;
+    for (uint8_t k = 0; k < RadioManagerConfig::STREAM_BLOCK; k++) {
+        if (k != LOST) order.push_back(k);
+    }
+    order.push_back(LOST);
+    for (uint8_t k = RadioManagerConfig::STREAM_BLOCK; k < count; k++) {
+        order.push_back(k);
+    }
+    TEST_ASSERT_EQUAL(count, records.size());
+    for (uint8_t k = 0; k < count; k++) {
+        size_t length = order[k] == LOST ? LOST_LENGTH : RECORD_SIZE;
+        TEST_ASSERT_EQUAL(length, records[k].size());
+        TEST_ASSERT_EQUAL_MEMORY(sent[order[k]], records[k].data(), length);
+    }
+#else
+    TEST_IGNORE_MESSAGE("RADIO_MANAGER_STREAM not defined (pio test -e native_stream)");
+#endif
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_acknowledged_vs_loss);
+    RUN_TEST(test_stream_vs_loss);
+    RUN_TEST(test_parity_rebuilds_lost_record);
+    return UNITY_END();
+}
@@ -0,0 +1,93 @@
+#include <unity.h>
+#include <SenderNetwork.h>
+
+/*
+ * Aggregate goodput against the number of nodes, in the radio simulator: 1 to 5 senders around
+ * a gateway (SenderNetwork.h) send it encrypted messages, either all on the same schedule (a
+ * report every REPORT_PERIOD) or back to back. Results add up SEEDS runs of DURATION. The nodes
+ * contend for the channel; in native_tdma (RADIO_MANAGER_TDMA) the same runs are repeated with
+ * the gateway calling startTdma() and the senders followTdma().
+ */
+
+static const size_t MESSAGE_SIZE = 96;        // 4 fragments
+static const uint64_t DURATION = 10000000;    // us
+static const uint64_t WARMUP = 200000;        // us before counting, for the first beacons
+static const uint32_t SEEDS = 4;
+static const uint64_t REPORT_PERIOD = 200000; // us, longer than the frame of 5 nodes
+
+/**
+ * @brief Measures senders reporting to the gateway, contending or in TDMA slots
+ *
+ * @param unscheduled Incremented for each sender left without a slot at the end of a TDMA run
+ */
+static NetworkResult measureNetwork(uint8_t senders, bool periodic, bool tdma, uint32_t& unscheduled) {
+    NetworkResult result = {};
+    for (uint32_t seed = 1; seed <= SEEDS; seed++) {
+        SenderNetwork network(senders, seed);
+#ifdef RADIO_MANAGER_TDMA
+        if (tdma) {
+            TEST_ASSERT_TRUE(network.collector.startTdma());
+            for (SenderNetwork::Sender& sender : network.nodes) {
+                TEST_ASSERT_TRUE(sender.node->followTdma(0));
+            }
+        }
+#endif
+        network.sim.run(WARMUP);
+        network.measure(periodic, REPORT_PERIOD, DURATION, MESSAGE_SIZE, result);
+        for (SenderNetwork::Sender& sender : network.nodes) {
+            unscheduled += tdma && sender.node->getTdmaSlot() == 255 ? 1 : 0;
+        }
+    }
+    result.finish();
+    return result;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_goodput_vs_nodes() {
+#ifdef RADIO_MANAGER_TDMA
+    const bool modes[] = { false, true };
+    char message[80];
+    snprintf(message, sizeof(message), "RADIO_MANAGER_TDMA, slot %u ms, guard %u ms",
+             RadioManagerConfig::TDMA_SLOT, RadioManagerConfig::TDMA_GUARD);
+    TEST_MESSAGE(message);
+#else
+    const bool modes[] = { false };
+#endif
+    for (bool periodic : { true, false }) {
+        // Goodput of 1 and of all senders, contending ([0]) then in TDMA slots ([1])
+        double single[2] = {}, full[2] = {};
+        for (bool tdma : modes) {
+            TEST_MESSAGE(tdma ? "TDMA slots" : "Contention");
+            for (uint8_t senders = 1; senders <= SenderNetwork::MAX_SENDERS; senders++) {
+                uint32_t unscheduled = 0;
+                NetworkResult result = measureNetwork(senders, periodic, tdma, unscheduled);
+                result.report(periodic ? "periodic" : "saturated", senders);
+                TEST_ASSERT_TRUE_MESSAGE(result.received > 0, "No message received");
+                TEST_ASSERT_EQUAL_MESSAGE(0, unscheduled, "Sender without a TDMA slot");
+                if (senders == 1) single[tdma] = result.goodput;
+                if (senders == SenderNetwork::MAX_SENDERS) full[tdma] = result.goodput;
+            }
+        }
+#ifdef RADIO_MANAGER_TDMA
+        TEST_ASSERT_TRUE_MESSAGE(full[1] >= full[0], "TDMA goodput below contention with 5 senders");
+        if (periodic) {
+            // Every report fits its slot: the goodput grows with the senders
+            TEST_ASSERT_TRUE_MESSAGE(full[1] >= 0.9 * SenderNetwork::MAX_SENDERS * single[1], "TDMA goodput not scaling with the senders");
+        }
+#else
+        (void)single;
+        (void)full;
+#endif
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_goodput_vs_nodes);
+    return UNITY_END();
+}